@@ -0,0 +1,36 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Benchmark.h"
+
+#include <iostream>
+
+using namespace std;
+
+
+void Bench::PrintGroup(string_view title)
+{
+	cout << format("\n{}\n", title);
+}
+
+
+void Bench::PrintResult(string_view name, double nsPerOp, double baselineNsPerOp)
+{
+	if (baselineNsPerOp > 0.0)
+	{
+		cout << format("  {:<52} {:>10.2f} ns/op  {:>6.2f}x\n", name, nsPerOp, baselineNsPerOp / nsPerOp);
+	}
+	else
+	{
+		cout << format("  {:<52} {:>10.2f} ns/op\n", name, nsPerOp);
+	}
+}
@@ -0,0 +1,65 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+// A minimal timing harness.  Each benchmark is a function that performs a known number of
+// operations.  It runs once to warm up, then s_numRuns more times, and the fastest run is
+// reported, which filters out most of the noise from other processes.  Run the Release or
+// Profile build, Debug numbers mean nothing.
+
+namespace Bench
+{
+
+constexpr int s_numRuns{ 5 };
+
+
+// Keeps the compiler from discarding a result that's otherwise unused
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	volatile T sink = value;
+	(void)sink;
+}
+
+
+// Best time per operation over s_numRuns runs of func, which does numOps operations per call
+template <typename Func>
+double MeasureNsPerOp(uint64_t numOps, Func&& func)
+{
+	func();
+
+	double best = std::numeric_limits<double>::max();
+	for (int run = 0; run < s_numRuns; ++run)
+	{
+		const auto timeStart = std::chrono::high_resolution_clock::now();
+		func();
+		const auto timeEnd = std::chrono::high_resolution_clock::now();
+
+		best = std::min(best, std::chrono::duration<double, std::nano>(timeEnd - timeStart).count() / (double)numOps);
+	}
+	return best;
+}
+
+
+void PrintGroup(std::string_view title);
+
+// A baseline of 0 prints just the time, otherwise the time and the speedup over the baseline
+void PrintResult(std::string_view name, double nsPerOp, double baselineNsPerOp = 0.0);
+
+
+void RunQueueBenchmarks();
+void RunHashBenchmarks();
+void RunFlatHashMapBenchmarks();
+void RunRefCountBenchmarks();
+void RunSmallVectorBenchmarks();
+
+} // namespace Bench
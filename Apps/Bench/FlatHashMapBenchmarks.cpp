@@ -0,0 +1,203 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Benchmark.h"
+
+#include "Core\FlatHashMap.h"
+
+#include <random>
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr size_t s_numKeys{ 64 * 1024 };
+constexpr uint32_t s_numReaderThreads{ 4 };
+
+
+vector<uint64_t> MakeIntegerKeys(uint64_t seed)
+{
+	mt19937_64 random{ seed };
+	vector<uint64_t> keys(s_numKeys);
+	for (auto& key : keys)
+	{
+		key = random();
+	}
+	return keys;
+}
+
+
+// Shaped like the file system's relative paths
+vector<string> MakePathKeys()
+{
+	mt19937 random{ 7 };
+	vector<string> keys(s_numKeys);
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		keys[i] = format("textures/set{:03}/surface_{:05}_{}.dds", random() % 100, i, random() % 4);
+	}
+	return keys;
+}
+
+
+using MapTimes = array<double, 3>;
+
+
+// Prints and returns the insert, hit and miss times.  Zero baseline times print no speedup.
+template <typename Map, typename Key>
+MapTimes MeasureMap(string_view mapName, string_view keyName, const vector<Key>& keys, const vector<Key>& missingKeys, const MapTimes& baselineTimes)
+{
+	MapTimes times{};
+	times[0] = Bench::MeasureNsPerOp(keys.size(),
+		[&keys]
+		{
+			Map map;
+			for (const auto& key : keys)
+			{
+				map.try_emplace(key, 1u);
+			}
+			Bench::DoNotOptimize(map.size());
+		});
+
+	Map map;
+	for (const auto& key : keys)
+	{
+		map.try_emplace(key, 1u);
+	}
+
+	times[1] = Bench::MeasureNsPerOp(keys.size(),
+		[&keys, &map]
+		{
+			size_t found = 0;
+			for (const auto& key : keys)
+			{
+				found += map.find(key) != map.end() ? 1 : 0;
+			}
+			Bench::DoNotOptimize(found);
+		});
+
+	times[2] = Bench::MeasureNsPerOp(missingKeys.size(),
+		[&missingKeys, &map]
+		{
+			size_t found = 0;
+			for (const auto& key : missingKeys)
+			{
+				found += map.find(key) != map.end() ? 1 : 0;
+			}
+			Bench::DoNotOptimize(found);
+		});
+
+	const string_view operations[] = { "insert", "find hit", "find miss" };
+	for (size_t i = 0; i < size(operations); ++i)
+	{
+		Bench::PrintResult(format("{}<{}>, {}", mapName, keyName, operations[i]), times[i], baselineTimes[i]);
+	}
+	return times;
+}
+
+
+// The baseline for the concurrent map, what the file system's resolved-path cache used to be
+class LockedMap : NonCopyable, NonMovable
+{
+public:
+	void insert(const string& key, uint32_t value)
+	{
+		lock_guard lock(m_mutex);
+		m_map.try_emplace(key, value);
+	}
+
+	bool find(const string& key, uint32_t& value) const
+	{
+		shared_lock lock(m_mutex);
+		auto it = m_map.find(key);
+		if (it == m_map.end())
+		{
+			return false;
+		}
+		value = it->second;
+		return true;
+	}
+
+private:
+	mutable shared_mutex m_mutex;
+	unordered_map<string, uint32_t> m_map;
+};
+
+
+// Time per lookup with s_numReaderThreads threads all looking up every key at once, the
+// read-mostly pattern of the path and pipeline caches
+template <typename Map>
+double MeasureConcurrentFind(const vector<string>& keys)
+{
+	Map map;
+	for (const auto& key : keys)
+	{
+		map.insert(key, 1u);
+	}
+
+	return Bench::MeasureNsPerOp(keys.size() * s_numReaderThreads,
+		[&keys, &map]
+		{
+			latch start{ s_numReaderThreads };
+			vector<thread> threads;
+			for (uint32_t i = 0; i < s_numReaderThreads; ++i)
+			{
+				threads.emplace_back(
+					[&keys, &map, &start]
+					{
+						start.arrive_and_wait();
+						uint32_t found = 0;
+						for (const auto& key : keys)
+						{
+							uint32_t value = 0;
+							found += map.find(key, value) ? value : 0;
+						}
+						Bench::DoNotOptimize(found);
+					});
+			}
+
+			for (auto& worker : threads)
+			{
+				worker.join();
+			}
+		});
+}
+
+} // anonymous namespace
+
+
+void Bench::RunFlatHashMapBenchmarks()
+{
+	PrintGroup(format("Hash maps: {} keys, speedup over std::unordered_map", s_numKeys));
+
+	{
+		const auto keys = MakeIntegerKeys(1);
+		const auto missingKeys = MakeIntegerKeys(2);
+
+		const MapTimes stdTimes = MeasureMap<unordered_map<uint64_t, uint32_t>>("std::unordered_map", "uint64_t", keys, missingKeys, {});
+		MeasureMap<FlatHashMap<uint64_t, uint32_t>>("FlatHashMap", "uint64_t", keys, missingKeys, stdTimes);
+	}
+
+	const auto keys = MakePathKeys();
+	vector<string> missingKeys(keys.size());
+	ranges::transform(keys, missingKeys.begin(), [](const string& key) { return key + ".bak"; });
+
+	const MapTimes stdTimes = MeasureMap<unordered_map<string, uint32_t>>("std::unordered_map", "std::string", keys, missingKeys, {});
+	MeasureMap<FlatHashMap<string, uint32_t>>("FlatHashMap", "std::string", keys, missingKeys, stdTimes);
+
+	const double lockedTime = MeasureConcurrentFind<LockedMap>(keys);
+	PrintResult(format("unordered_map + shared_mutex, find, {} threads", s_numReaderThreads), lockedTime);
+	PrintResult(format("ConcurrentFlatHashMap, find, {} threads", s_numReaderThreads), MeasureConcurrentFind<ConcurrentFlatHashMap<string, uint32_t>>(keys), lockedTime);
+}
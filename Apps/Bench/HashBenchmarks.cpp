@@ -0,0 +1,115 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Benchmark.h"
+
+#include "Core\Hash.h"
+
+#include <random>
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr size_t s_numInputs{ 4096 };
+constexpr size_t s_numPasses{ 16 };
+
+
+// Random printable strings of one length, standing in for names and paths (short) up to
+// serialized state and file contents (long)
+vector<string> MakeInputs(size_t length)
+{
+	mt19937 random{ (uint32_t)length };
+	uniform_int_distribution<int> printable{ 'a', 'z' };
+
+	vector<string> inputs(s_numInputs);
+	for (auto& input : inputs)
+	{
+		input.resize(length);
+		for (char& c : input)
+		{
+			c = (char)printable(random);
+		}
+	}
+	return inputs;
+}
+
+
+template <typename HashFunc>
+double MeasureHash(const vector<string>& inputs, HashFunc&& hashFunc)
+{
+	return Bench::MeasureNsPerOp(inputs.size() * s_numPasses,
+		[&inputs, &hashFunc]
+		{
+			size_t combined = 0;
+			for (size_t pass = 0; pass < s_numPasses; ++pass)
+			{
+				for (const auto& input : inputs)
+				{
+					combined ^= hashFunc(string_view{ input });
+				}
+			}
+			Bench::DoNotOptimize(combined);
+		});
+}
+
+
+span<const byte> AsBytes(string_view str)
+{
+	return as_bytes(span{ str.data(), str.size() });
+}
+
+} // anonymous namespace
+
+
+void Bench::RunHashBenchmarks()
+{
+	const bool hasCrc32 = Utility::HasHardwareCrc32();
+	PrintGroup(format("Hashing: HashRange is using {}, speedup over std::hash<std::string_view>", hasCrc32 ? "CRC32C" : "multiply-mix"));
+
+	for (const size_t length : { 16u, 64u, 1024u })
+	{
+		const auto inputs = MakeInputs(length);
+
+		const double stdTime = MeasureHash(inputs, [](string_view input) { return hash<string_view>{}(input); });
+		PrintResult(format("std::hash, {} bytes", length), stdTime);
+
+		PrintResult(format("Utility::HashRange, {} bytes", length),
+			MeasureHash(inputs, [](string_view input) { return Utility::HashRange(AsBytes(input)); }), stdTime);
+
+		PrintResult(format("  multiply-mix, {} bytes", length),
+			MeasureHash(inputs,
+				[](string_view input)
+				{
+					const auto* begin = (const uint8_t*)input.data();
+					return Utility::Detail::HashBytesMix(begin, begin + input.size(), Utility::g_hashStart);
+				}),
+			stdTime);
+
+#if ENABLE_HARDWARE_CRC32
+		if (hasCrc32)
+		{
+			PrintResult(format("  CRC32C, {} bytes", length),
+				MeasureHash(inputs,
+					[](string_view input)
+					{
+						const auto* begin = (const uint8_t*)input.data();
+						return Utility::Detail::HashBytesCrc32(begin, begin + input.size(), Utility::g_hashStart);
+					}),
+				stdTime);
+		}
+#endif
+	}
+}
@@ -0,0 +1,55 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Benchmark.h"
+
+#include <iostream>
+
+using namespace std;
+
+
+// Microbenchmarks for the engine's core containers and primitives, each against the standard
+// library equivalent it replaced.  Pass group names to run just those, or nothing to run everything.
+int main(int argc, char* argv[])
+{
+	const pair<string_view, void(*)()> groups[] = {
+		{ "queue", Bench::RunQueueBenchmarks },
+		{ "hash", Bench::RunHashBenchmarks },
+		{ "flatmap", Bench::RunFlatHashMapBenchmarks },
+		{ "refcount", Bench::RunRefCountBenchmarks },
+		{ "smallvector", Bench::RunSmallVectorBenchmarks } };
+
+	const span<char*> args{ argv + 1, (size_t)std::max(argc - 1, 0) };
+	for (const char* arg : args)
+	{
+		if (ranges::find(groups, string_view{ arg }, [](const auto& group) { return group.first; }) == end(groups))
+		{
+			string groupNames;
+			for (const auto& [name, run] : groups)
+			{
+				groupNames += format(" {}", name);
+			}
+			cerr << format("Unknown benchmark group '{}', expected one of:{}\n", arg, groupNames);
+			return 1;
+		}
+	}
+
+	for (const auto& [name, run] : groups)
+	{
+		if (args.empty() || ranges::find(args, name, [](const char* arg) { return string_view{ arg }; }) != args.end())
+		{
+			run();
+		}
+	}
+
+	return 0;
+}
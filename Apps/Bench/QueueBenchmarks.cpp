@@ -0,0 +1,169 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Benchmark.h"
+
+#include "Core\RingBuffer.h"
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr uint64_t s_numItems{ 1 << 20 };
+constexpr size_t s_capacity{ 4096 };
+constexpr size_t s_batchSize{ 32 };
+
+
+// The baseline, a std::queue behind a std::mutex.  Bounded like the ring buffers, so producers
+// get the same back pressure.
+class MutexQueue : NonCopyable, NonMovable
+{
+public:
+	explicit MutexQueue(size_t capacity)
+		: m_capacity{ capacity }
+	{}
+
+	bool TryPush(uint64_t value)
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if (m_queue.size() == m_capacity)
+		{
+			return false;
+		}
+		m_queue.push(value);
+		return true;
+	}
+
+	bool TryPop(uint64_t& value)
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if (m_queue.empty())
+		{
+			return false;
+		}
+		value = m_queue.front();
+		m_queue.pop();
+		return true;
+	}
+
+	size_t TryPopBatch(span<uint64_t> values)
+	{
+		lock_guard<mutex> lock(m_mutex);
+		const size_t count = std::min(values.size(), m_queue.size());
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] = m_queue.front();
+			m_queue.pop();
+		}
+		return count;
+	}
+
+private:
+	const size_t m_capacity{ 0 };
+	mutex m_mutex;
+	queue<uint64_t> m_queue;
+};
+
+
+// Time per item for s_numItems to pass through the queue, producers and consumers all starting
+// together.  Full or empty queues make the thread yield and retry, like the log producers do.
+template <typename Queue>
+double MeasureQueue(uint32_t numProducers, uint32_t numConsumers, bool popBatches)
+{
+	return Bench::MeasureNsPerOp(s_numItems,
+		[numProducers, numConsumers, popBatches]
+		{
+			Queue itemQueue{ s_capacity };
+			atomic<uint64_t> numPopped{ 0 };
+			latch start{ numProducers + numConsumers };
+
+			vector<thread> threads;
+			for (uint32_t i = 0; i < numProducers; ++i)
+			{
+				threads.emplace_back(
+					[&itemQueue, &start, numProducers]
+					{
+						start.arrive_and_wait();
+						for (uint64_t item = 0; item < s_numItems / numProducers; ++item)
+						{
+							while (!itemQueue.TryPush(item))
+							{
+								this_thread::yield();
+							}
+						}
+					});
+			}
+
+			for (uint32_t i = 0; i < numConsumers; ++i)
+			{
+				threads.emplace_back(
+					[&itemQueue, &start, &numPopped, popBatches]
+					{
+						start.arrive_and_wait();
+
+						array<uint64_t, s_batchSize> items{};
+						uint64_t sum = 0;
+						while (numPopped.load(memory_order_relaxed) < s_numItems)
+						{
+							const size_t count = popBatches ? itemQueue.TryPopBatch(items) : (itemQueue.TryPop(items[0]) ? 1 : 0);
+							if (count == 0)
+							{
+								this_thread::yield();
+								continue;
+							}
+
+							for (size_t item = 0; item < count; ++item)
+							{
+								sum += items[item];
+							}
+							numPopped.fetch_add(count, memory_order_relaxed);
+						}
+						Bench::DoNotOptimize(sum);
+					});
+			}
+
+			for (auto& worker : threads)
+			{
+				worker.join();
+			}
+		});
+}
+
+} // anonymous namespace
+
+
+void Bench::RunQueueBenchmarks()
+{
+	PrintGroup(format("Queues: {} items through a {} slot queue, speedup over std::mutex + std::queue", s_numItems, s_capacity));
+
+	for (const uint32_t numThreads : { 1u, 2u, 4u })
+	{
+		const string config = format("{}P/{}C", numThreads, numThreads);
+
+		const double mutexTime = MeasureQueue<MutexQueue>(numThreads, numThreads, false);
+		PrintResult(format("std::mutex + std::queue, {}", config), mutexTime);
+		PrintResult(format("MpmcRingBuffer, {}", config), MeasureQueue<MpmcRingBuffer<uint64_t>>(numThreads, numThreads, false), mutexTime);
+
+		const double mutexBatchTime = MeasureQueue<MutexQueue>(numThreads, numThreads, true);
+		PrintResult(format("std::mutex + std::queue, {}, pop {}", config, s_batchSize), mutexBatchTime);
+		PrintResult(format("MpmcRingBuffer, {}, pop {}", config, s_batchSize), MeasureQueue<MpmcRingBuffer<uint64_t>>(numThreads, numThreads, true), mutexBatchTime);
+
+		if (numThreads == 1)
+		{
+			PrintResult(format("SpscRingBuffer, {}", config), MeasureQueue<SpscRingBuffer<uint64_t>>(1, 1, false), mutexTime);
+			PrintResult(format("SpscRingBuffer, {}, pop {}", config, s_batchSize), MeasureQueue<SpscRingBuffer<uint64_t>>(1, 1, true), mutexBatchTime);
+		}
+	}
+}
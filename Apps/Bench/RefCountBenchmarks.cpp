@@ -0,0 +1,145 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Benchmark.h"
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr size_t s_numOps{ 1 << 20 };
+constexpr uint32_t s_numContendedThreads{ 4 };
+
+
+// Same payload for all three, roughly the size of the small graphics wrapper objects
+struct Payload
+{
+	uint64_t values[4]{};
+};
+
+
+class SharedObject : public Payload
+{};
+
+
+class AtomicObject : public IObject, public NonCopyable, public Payload
+{
+	IMPLEMENT_IOBJECT
+};
+
+
+class SingleThreadedObject : public IObject, public NonCopyable, public Payload
+{
+	IMPLEMENT_IOBJECT_SINGLE_THREADED
+};
+
+
+// Runs threadFunc on numThreads threads that all start together
+template <typename ThreadFunc>
+void RunThreads(uint32_t numThreads, ThreadFunc&& threadFunc)
+{
+	latch start{ numThreads };
+	vector<thread> threads;
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		threads.emplace_back(
+			[&start, &threadFunc]
+			{
+				start.arrive_and_wait();
+				threadFunc();
+			});
+	}
+
+	for (auto& worker : threads)
+	{
+		worker.join();
+	}
+}
+
+
+// Copies and releases a reference s_numOps times, split across numThreads threads.  They all
+// copy the same object, so with more than one thread the reference count's cache line bounces.
+template <typename Ptr>
+double MeasureCopy(const Ptr& object, uint32_t numThreads)
+{
+	return Bench::MeasureNsPerOp(s_numOps,
+		[&object, numThreads]
+		{
+			RunThreads(numThreads,
+				[&object, numThreads]
+				{
+					for (size_t op = 0; op < s_numOps / numThreads; ++op)
+					{
+						Ptr copied{ object };
+						Bench::DoNotOptimize(copied != nullptr);
+					}
+				});
+		});
+}
+
+
+// Each thread takes one reference and passes it back and forth between two pointers s_numOps
+// times in total.  Moves shouldn't touch the count, so this shouldn't slow down with more threads.
+template <typename Ptr>
+double MeasureMove(const Ptr& object, uint32_t numThreads)
+{
+	return Bench::MeasureNsPerOp(s_numOps,
+		[&object, numThreads]
+		{
+			RunThreads(numThreads,
+				[&object, numThreads]
+				{
+					Ptr first{ object };
+					for (size_t op = 0; op < s_numOps / numThreads; ++op)
+					{
+						Ptr second{ std::move(first) };
+						first = std::move(second);
+						Bench::DoNotOptimize(first != nullptr);
+					}
+				});
+		});
+}
+
+} // anonymous namespace
+
+
+void Bench::RunRefCountBenchmarks()
+{
+	PrintGroup("Reference counting: speedup over std::shared_ptr");
+
+	const auto sharedObject = make_shared<SharedObject>();
+	const auto atomicObject = IntrusivePtr<AtomicObject>::Create(new AtomicObject);
+	const auto singleThreadedObject = IntrusivePtr<SingleThreadedObject>::Create(new SingleThreadedObject);
+
+	const double sharedCopyTime = MeasureCopy(sharedObject, 1);
+	PrintResult("std::shared_ptr, copy + release", sharedCopyTime);
+	PrintResult("IMPLEMENT_IOBJECT, copy + release", MeasureCopy(atomicObject, 1), sharedCopyTime);
+	PrintResult("IMPLEMENT_IOBJECT_SINGLE_THREADED, copy + release", MeasureCopy(singleThreadedObject, 1), sharedCopyTime);
+
+	const double sharedMoveTime = MeasureMove(sharedObject, 1);
+	PrintResult("std::shared_ptr, move", sharedMoveTime);
+	PrintResult("IMPLEMENT_IOBJECT, move", MeasureMove(atomicObject, 1), sharedMoveTime);
+
+	// The single threaded count can't be shared, so only the atomic ones race here
+	const double sharedContendedTime = MeasureCopy(sharedObject, s_numContendedThreads);
+	PrintResult(format("std::shared_ptr, copy + release, {} threads", s_numContendedThreads), sharedContendedTime);
+	PrintResult(format("IMPLEMENT_IOBJECT, copy + release, {} threads", s_numContendedThreads),
+		MeasureCopy(atomicObject, s_numContendedThreads), sharedContendedTime);
+
+	const double sharedContendedMoveTime = MeasureMove(sharedObject, s_numContendedThreads);
+	PrintResult(format("std::shared_ptr, move, {} threads", s_numContendedThreads), sharedContendedMoveTime);
+	PrintResult(format("IMPLEMENT_IOBJECT, move, {} threads", s_numContendedThreads),
+		MeasureMove(atomicObject, s_numContendedThreads), sharedContendedMoveTime);
+}
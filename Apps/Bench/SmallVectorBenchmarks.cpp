@@ -0,0 +1,157 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Benchmark.h"
+
+#include "Core\SmallVector.h"
+
+#include <random>
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr size_t s_numLists{ 64 * 1024 };
+constexpr size_t s_numContexts{ 1024 };
+constexpr size_t s_numFrames{ 16 };
+constexpr size_t s_inlineCapacity{ 16 };
+
+
+// About the size of a texture barrier
+struct Barrier
+{
+	uint64_t resource{ 0 };
+	uint32_t beforeState{ 0 };
+	uint32_t afterState{ 0 };
+	uint32_t subresource{ 0 };
+	uint32_t flags{ 0 };
+};
+
+
+template <typename Vector>
+uint64_t FillAndSum(Vector& barriers, size_t numBarriers, uint64_t resource)
+{
+	for (size_t i = 0; i < numBarriers; ++i)
+	{
+		barriers.push_back({ .resource = resource + i, .beforeState = 1, .afterState = 2 });
+	}
+
+	uint64_t sum = 0;
+	for (const auto& barrier : barriers)
+	{
+		sum += barrier.resource + barrier.afterState;
+	}
+	return sum;
+}
+
+
+// Heap allocations to build one list of numBarriers from empty.  Both containers only allocate
+// when the capacity grows, so counting capacity changes counts allocations without hooking the heap.
+template <typename Vector>
+size_t CountAllocations(size_t numBarriers)
+{
+	Vector barriers;
+	size_t numAllocations = 0;
+	for (size_t i = 0; i < numBarriers; ++i)
+	{
+		const size_t capacity = barriers.capacity();
+		barriers.push_back({});
+		numAllocations += barriers.capacity() != capacity ? 1 : 0;
+	}
+	return numAllocations;
+}
+
+
+// Builds, reads back and destroys s_numLists lists, like a context's barrier list the first time
+// it's used
+template <typename Vector>
+double MeasureNewLists(size_t numBarriers)
+{
+	return Bench::MeasureNsPerOp(s_numLists,
+		[numBarriers]
+		{
+			uint64_t sum = 0;
+			for (size_t i = 0; i < s_numLists; ++i)
+			{
+				Vector barriers;
+				sum += FillAndSum(barriers, numBarriers, i);
+			}
+			Bench::DoNotOptimize(sum);
+		});
+}
+
+
+// A pool of contexts, each keeping its list between flushes, flushed once per frame for
+// s_numFrames frames.  Nothing allocates once the lists have grown, so the difference is the
+// extra cache line std::vector touches to reach its elements.  The pool hands contexts out in
+// no particular order, so they're visited shuffled.
+template <typename Vector>
+double MeasureReusedLists(size_t numBarriers)
+{
+	struct Context
+	{
+		uint64_t fenceValue{ 0 };
+		Vector barriers;
+	};
+
+	vector<unique_ptr<Context>> contexts(s_numContexts);
+	for (auto& context : contexts)
+	{
+		context = make_unique<Context>();
+	}
+	ranges::shuffle(contexts, mt19937{ 11 });
+
+	return Bench::MeasureNsPerOp(s_numContexts * s_numFrames,
+		[&contexts, numBarriers]
+		{
+			uint64_t sum = 0;
+			for (size_t frame = 0; frame < s_numFrames; ++frame)
+			{
+				for (auto& context : contexts)
+				{
+					sum += FillAndSum(context->barriers, numBarriers, frame);
+					context->barriers.clear();
+					++context->fenceValue;
+				}
+			}
+			Bench::DoNotOptimize(sum);
+		});
+}
+
+} // anonymous namespace
+
+
+void Bench::RunSmallVectorBenchmarks()
+{
+	using StdList = vector<Barrier>;
+	using SmallList = SmallVector<Barrier, s_inlineCapacity>;
+
+	PrintGroup(format("Small vectors: per barrier list, speedup over std::vector, {} inline slots", s_inlineCapacity));
+
+	for (const size_t numBarriers : { 4u, 16u, 64u })
+	{
+		const double stdTime = MeasureNewLists<StdList>(numBarriers);
+		PrintResult(format("std::vector, new, {} barriers, {} allocs", numBarriers, CountAllocations<StdList>(numBarriers)), stdTime);
+		PrintResult(format("SmallVector, new, {} barriers, {} allocs", numBarriers, CountAllocations<SmallList>(numBarriers)),
+			MeasureNewLists<SmallList>(numBarriers), stdTime);
+	}
+
+	for (const size_t numBarriers : { 4u, 16u })
+	{
+		const double stdTime = MeasureReusedLists<StdList>(numBarriers);
+		PrintResult(format("std::vector, {} contexts, {} barriers", s_numContexts, numBarriers), stdTime);
+		PrintResult(format("SmallVector, {} contexts, {} barriers", s_numContexts, numBarriers), MeasureReusedLists<SmallList>(numBarriers), stdTime);
+	}
+}
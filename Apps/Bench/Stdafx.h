@@ -0,0 +1,68 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+// Windows headers
+#include <windows.h>
+#include <wrl.h>
+#include <comdef.h>
+
+// Standard library headers
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <latch>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Engine headers
+#include "Core\AllocationTracking.h"
+#include "Core\BitmaskEnum.h"
+#include "Core\CoreEnums.h"
+#include "Core\DWParam.h"
+#include "Core\IntrusivePtr.h"
+#include "Core\IObject.h"
+#include "Core\NonCopyable.h"
+#include "Core\NonMovable.h"
+#include "Core\StringId.h"
+#include "Core\Utility.h"
+#include "Core\VectorMath.h"
+#include "LogSystem.h"
+
+// App name
+static const std::string s_appName{ "Bench" };
\ No newline at end of file
@@ -25,16 +25,32 @@
 // Standard library headers
 #include <array>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cstdarg>
+#include <exception>
+#include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
 #include <future>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <queue>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <variant>
+#include <vector>
 
 // Engine headers
+#include "Core\AllocationTracking.h"
 #include "Core\BitmaskEnum.h"
 #include "Core\CoreEnums.h"
 #include "Core\DWParam.h"
@@ -42,6 +58,7 @@
 #include "Core\IObject.h"
 #include "Core\NonCopyable.h"
 #include "Core\NonMovable.h"
+#include "Core\StringId.h"
 #include "Core\Utility.h"
 #include "Core\VectorMath.h"
 #include "LogSystem.h"
@@ -0,0 +1,4 @@
+@ECHO OFF
+REM This batch file builds a Kodiak pack file (.kpak) from a directory.  Pass --compress to compress entries.
+REM It is expected that python.exe is on your path and is version 3.0 or above.
+python.exe Programs\PackBuilder\BuildPack.py %*
\ No newline at end of file
@@ -0,0 +1,4 @@
+@ECHO OFF
+REM This batch file decodes a Kodiak binary log (.klog) to text, or to JSON lines with --json.
+REM It is expected that python.exe is on your path and is version 3.0 or above.
+python.exe Programs\LogDecoder\DecodeLog.py %*
\ No newline at end of file
@@ -14,6 +14,7 @@
 
 #include "FileSystem.h"
 #include "InputSystem.h"
+#include "JobSystem.h"
 #include "Graphics\CreationParams.h"
 #include "Graphics\GraphicsCommon.h"
 #include "External\CLI11\CLI\CLI.hpp"
@@ -30,6 +31,18 @@ LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 
 static Kodiak::Application* g_application = nullptr;
 
+#if ENABLE_ALLOCATION_TRACKING
+// Frames after this many should leave the general heap alone
+static constexpr uint64_t s_allocationWarmupFrames{ 120 };
+
+// Heap allocations charged to frames.  The log thread's don't count, the once a second stats
+// logging would set them off.
+static AllocationStats GetFrameAllocationTotals() noexcept
+{
+	return GetAllocationTotals() - GetAllocationTotals(AllocationTag::Log);
+}
+#endif
+
 
 Application::Application()
 {
@@ -109,6 +122,10 @@ int Application::Run(int argc, char* argv[])
 			break;
 	} while (Tick());	// Returns false to quit loop
 
+	// The last frame may still be presenting
+	m_frameGraph->WaitForAll();
+	StopRenderThread();
+
 	Shutdown();
 
 	return 0;
@@ -131,6 +148,16 @@ int Application::ProcessCommandLine(int argc, char* argv[])
 	// Width, height
 	auto widthOpt = app.add_option("--resx,--width", m_appDesc.width, "Sets initial window width");
 	auto heightOpt = app.add_option("--resy,--height", m_appDesc.height, "Sets initial window height");
+
+	// Threading
+	app.add_flag("--render-thread", m_appDesc.useRenderThread, "Render on a separate thread, one frame behind Update");
+
+	const map<string, ThreadAffinity> threadAffinityMap{
+		{ "float", ThreadAffinity::Float },
+		{ "group", ThreadAffinity::Group },
+		{ "pin", ThreadAffinity::Pin } };
+	app.add_option("--thread-affinity", m_appDesc.threadAffinity, "Where engine threads run: float, group or pin")
+		->transform(CLI::CheckedTransformer(threadAffinityMap, CLI::ignore_case));
 	
 	// Parse command line
 	CLI11_PARSE(app, argc, argv);
@@ -167,14 +194,33 @@ string Application::GetWindowTitle() const
 
 void Application::Initialize()
 {
+	SetAllocationThreadName("Main");
+
+	// Keep the job and log workers off the main and render threads' cores
+	const auto& cpuTopology = GetCpuTopology();
+	m_threadPlacement = make_unique<ThreadPlacement>(cpuTopology, m_appDesc.threadAffinity, m_appDesc.useRenderThread);
+	SetCurrentThreadAffinity(m_threadPlacement->GetCpuSet(ThreadRole::Main));
+
 	// Create core engine systems
+	m_jobSystem = make_unique<JobSystem>(m_threadPlacement->GetNumJobWorkers());
+	for (uint32_t i = 1; i < m_jobSystem->GetNumThreads(); ++i)
+	{
+		m_jobSystem->SetWorkerAffinity(i, m_threadPlacement->GetCpuSet(ThreadRole::JobWorker, i));
+	}
+
 	m_filesystem = make_unique<FileSystem>(m_appDesc.name);
 	m_filesystem->SetDefaultRootPath();
 	m_logSystem = make_unique<LogSystem>();
+	m_logSystem->SetWorkerAffinity(m_threadPlacement->GetCpuSet(ThreadRole::Log));
 
 	// This is the first place we can post a startup message
 	LogInfo(LogApplication) << "App: " << m_appDesc.name << " starting up" << endl;
 	LogInfo(LogApplication) << "  API: " << GraphicsApiToString(m_appDesc.api) << endl;
+	LogInfo(LogApplication) << "  CPU: " << cpuTopology.GetNumCores() << " cores, " << cpuTopology.GetNumLogicalProcessors() << " threads, "
+		<< cpuTopology.GetNumL3Domains() << " L3 domains, " << cpuTopology.GetNumNumaNodes() << " NUMA nodes"
+		<< (cpuTopology.IsHybrid() ? " (hybrid)" : "") << endl;
+	LogInfo(LogApplication) << "  Thread affinity: " << ThreadAffinityToString(m_threadPlacement->GetAffinity()) << endl;
+	LogInfo(LogApplication) << "  Job threads: " << m_jobSystem->GetNumThreads() << endl;
 	LogInfo(LogApplication) << endl;
 
 	m_inputSystem = make_unique<InputSystem>(m_hwnd);
@@ -185,17 +231,32 @@ void Application::Initialize()
 
 	Configure();
 
+	// Search paths added later are picked up automatically
+	m_filesystem->EnableFileWatching(m_appDesc.watchFiles);
+
 	CreateDeviceManager();
 
 	Startup();
 
+	CreateFrameGraph();
+	StartRenderThread();
+
 	m_isRunning = true;
 }
 
 
 void Application::Finalize()
 {
+	StopRenderThread();
 	Shutdown();
+
+#if ENABLE_IOBJECT_REGISTRY
+	// Release the engine's objects while the log is still up, anything left after that has leaked
+	m_frameSnapshots.reset();
+	m_deviceManager.Reset();
+	m_filesystem.reset();
+	ReportLeakedIObjects();
+#endif
 }
 
 
@@ -206,25 +267,31 @@ bool Application::Tick()
 
 	auto timeStart = chrono::high_resolution_clock::now();
 
-	m_inputSystem->Update(m_frameTimer);
+	// Present carries on into the next frame, which waits for it before BeginFrame.  With a render
+	// thread, the frame is drawn from a snapshot while the next Update runs.
+	m_frameGraph->Kick();
+	m_frameGraph->Wait(m_tickTask);
 
-	// Close on Escape key
-	if (m_inputSystem->IsFirstPressed(DigitalInput::kKey_escape))
-		return false;
-
-	bool res = Update();
-	if (res)
+	bool res = m_continueRunning;
+	if (res && m_renderThread.joinable())
 	{
-		//m_grid->Update(m_camera);
+		PublishFrame();
+	}
 
-		m_deviceManager->BeginFrame();
+	++m_frameCounter;
 
-		Render();
+#if ENABLE_ALLOCATION_TRACKING
+	const AllocationStats allocationTotals = GetFrameAllocationTotals();
+	const uint64_t frameAllocations = allocationTotals.numAllocations - m_lastAllocationTotals.numAllocations;
+	m_maxFrameAllocations = std::max(m_maxFrameAllocations, frameAllocations);
+	m_lastAllocationTotals = allocationTotals;
 
-		m_deviceManager->Present();
+	++m_numTrackedFrames;
+	if (frameAllocations != 0 && m_numTrackedFrames > s_allocationWarmupFrames)
+	{
+		++m_numAllocatingFrames;
 	}
-
-	++m_frameCounter;
+#endif
 
 	// Elapsed time for this frame
 	auto timeEnd = chrono::high_resolution_clock::now();
@@ -252,8 +319,28 @@ bool Application::Tick()
 		std::string windowTitle = GetWindowTitle();
 		SetWindowText(m_hwnd, windowTitle.c_str());
 
+		// Frame arenas stop growing once they fit a frame, anything after that is worth a look
+		const uint64_t arenaHeapAllocations = GetArenaHeapAllocations();
+		if (arenaHeapAllocations != m_arenaHeapAllocations)
+		{
+			LogDebug(LogApplication) << "Frame arenas grew " << (arenaHeapAllocations - m_arenaHeapAllocations) << " times in the last second" << endl;
+			m_arenaHeapAllocations = arenaHeapAllocations;
+		}
+
+#if ENABLE_ALLOCATION_TRACKING
+		LogAllocationStats(m_frameCounter);
+#endif
+#if ENABLE_IOBJECT_REGISTRY
+		LogIObjectStats();
+#endif
+
 		m_frameCounter = 0;
 		m_lastTimestamp = timeEnd;
+
+#if ENABLE_ALLOCATION_TRACKING
+		// Don't charge the window title and the logging above to the next frame
+		m_lastAllocationTotals = GetFrameAllocationTotals();
+#endif
 	}
 
 	//PrepareUI();
@@ -262,6 +349,231 @@ bool Application::Tick()
 }
 
 
+void Application::CreateFrameGraph()
+{
+	m_frameGraph = make_unique<TaskGraph>(*m_jobSystem, true);
+	auto& graph = *m_frameGraph;
+
+	m_frameTasks.input = graph.AddTask("Input",
+		[this] { m_inputSystem->Update(m_frameTimer); });
+
+	m_frameTasks.update = graph.AddTask("Update",
+		[this]
+		{
+			ALLOCATION_TAG(App);
+
+			// Close on Escape key
+			m_continueRunning = !m_inputSystem->IsFirstPressed(DigitalInput::kKey_escape) && Update();
+		},
+		{ m_frameTasks.input });
+
+	if (m_appDesc.useRenderThread)
+	{
+		// The render thread does the rest
+		m_tickTask = m_frameTasks.update;
+
+		AddFrameTasks(graph);
+		graph.Compile();
+		return;
+	}
+
+	m_frameTasks.beginFrame = graph.AddTask("BeginFrame",
+		[this]
+		{
+			if (m_continueRunning)
+			{
+				//m_grid->Update(m_camera);
+
+				m_deviceManager->BeginFrame();
+			}
+		},
+		{ m_frameTasks.update });
+
+	m_frameTasks.render = graph.AddTask("Render",
+		[this]
+		{
+			// Present reads its own flag, the next frame's Update may already be running by then
+			m_presentFrame = m_continueRunning;
+			if (m_presentFrame)
+			{
+				ALLOCATION_TAG(App);
+				Render();
+			}
+		},
+		{ m_frameTasks.beginFrame });
+
+	m_frameTasks.present = graph.AddTask("Present",
+		[this]
+		{
+			if (m_presentFrame)
+			{
+				m_deviceManager->Present();
+			}
+		},
+		{ m_frameTasks.render });
+
+	// The back buffer isn't ours again until the previous frame's Present is done
+	graph.AddPreviousFrameDependency(m_frameTasks.beginFrame, m_frameTasks.present);
+
+	m_tickTask = m_frameTasks.render;
+
+	AddFrameTasks(graph);
+
+	graph.Compile();
+}
+
+
+void Application::StartRenderThread()
+{
+	if (!m_appDesc.useRenderThread)
+	{
+		return;
+	}
+
+	m_frameSnapshots = make_unique<TripleBuffer<unique_ptr<FrameData>>>([this] { return CreateFrameData(); });
+	m_renderThread = thread([this] { RenderLoop(); });
+	SetThreadAffinity(m_renderThread, m_threadPlacement->GetCpuSet(ThreadRole::Render));
+}
+
+
+void Application::StopRenderThread()
+{
+	if (!m_renderThread.joinable())
+	{
+		return;
+	}
+
+	// Frames already published still get drawn
+	m_frameSnapshots->Close();
+	m_renderThread.join();
+}
+
+
+void Application::PublishFrame()
+{
+	ALLOCATION_TAG(App);
+
+	FrameData& frameData = *m_frameSnapshots->GetWriteSlot();
+	frameData.frameNumber = m_frameGraph->GetFrameNumber();
+	frameData.frameTimer = m_frameTimer;
+	frameData.appElapsedTime = m_appElapsedTime;
+
+	PrepareFrameData(frameData);
+
+	// Waits if the render thread is still two frames behind
+	m_frameSnapshots->Publish();
+}
+
+
+void Application::RenderLoop()
+{
+	SetThreadDescription(GetCurrentThread(), L"Kodiak Render");
+	SetAllocationThreadName("Render");
+	ALLOCATION_TAG(App);
+
+	while (auto* frameData = m_frameSnapshots->Acquire())
+	{
+		// Update may be two frames ahead, keep this thread's frame arenas on the frame it draws
+		SetThreadFrameNumber((*frameData)->frameNumber);
+
+		m_deviceManager->BeginFrame();
+
+		RenderFrame(**frameData);
+
+		m_deviceManager->Present();
+	}
+}
+
+
+#if ENABLE_ALLOCATION_TRACKING
+void Application::LogAllocationStats(uint32_t numFrames)
+{
+	AllocationSnapshot snapshot = GetAllocationSnapshot();
+
+	AllocationStats total;
+	for (size_t tag = 0; tag < snapshot.tags.size(); ++tag)
+	{
+		total += snapshot.tags[tag] - m_lastAllocationSnapshot.tags[tag];
+	}
+
+	const uint64_t frames = std::max(numFrames, 1u);
+	LogDebug(LogApplication, "Heap: {} allocations ({} bytes) per frame, {} in the worst frame",
+		total.numAllocations / frames, total.numBytes / frames, m_maxFrameAllocations);
+
+	for (size_t tag = 0; tag < snapshot.tags.size(); ++tag)
+	{
+		const AllocationStats stats = snapshot.tags[tag] - m_lastAllocationSnapshot.tags[tag];
+		if (stats.numAllocations > 0)
+		{
+			LogDebug(LogApplication, "  {}: {} allocations, {} bytes", AllocationTagToString((AllocationTag)tag), stats.numAllocations, stats.numBytes);
+		}
+	}
+
+	// Thread lists only grow, a thread's index is the same in both snapshots
+	for (size_t i = 0; i < snapshot.threads.size(); ++i)
+	{
+		const auto& threadStats = snapshot.threads[i];
+		const AllocationStats stats = i < m_lastAllocationSnapshot.threads.size()
+			? threadStats.stats - m_lastAllocationSnapshot.threads[i].stats
+			: threadStats.stats;
+		if (stats.numAllocations > 0)
+		{
+			LogDebug(LogApplication, "  {}: {} allocations, {} bytes", threadStats.threadName, stats.numAllocations, stats.numBytes);
+		}
+	}
+
+	m_lastAllocationSnapshot = move(snapshot);
+	m_maxFrameAllocations = 0;
+
+	// Steady-state frames should get by on the frame arenas and reused containers
+	if (m_numAllocatingFrames != 0)
+	{
+		LogWarning(LogApplication, "{} of the last {} frames allocated from the heap, expected none once warmed up",
+			m_numAllocatingFrames, numFrames);
+		m_numAllocatingFrames = 0;
+	}
+}
+#endif
+
+
+#if ENABLE_IOBJECT_REGISTRY
+void Application::LogIObjectStats()
+{
+	uint64_t numLive = 0;
+	uint64_t numLiveBytes = 0;
+	for (const auto& typeStats : GetIObjectStats())
+	{
+		numLive += typeStats.numLive;
+		numLiveBytes += typeStats.numLiveBytes;
+	}
+
+	// Steady growth over many seconds points at a leak or a reference cycle
+	if (numLive != m_numLiveIObjects)
+	{
+		LogDebug(LogApplication, "IObjects: {} live ({} bytes), was {}", numLive, numLiveBytes, m_numLiveIObjects);
+		m_numLiveIObjects = numLive;
+	}
+}
+
+
+void Application::ReportLeakedIObjects()
+{
+	auto stats = GetIObjectStats();
+	erase_if(stats, [](const auto& typeStats) { return typeStats.numLive == 0; });
+	if (stats.empty())
+	{
+		return;
+	}
+
+	LogWarning(LogApplication) << "IObjects still alive at shutdown:" << endl;
+	for (const auto& typeStats : stats)
+	{
+		LogWarning(LogApplication, "  {}: {} live ({} bytes), {} created", typeStats.typeName, typeStats.numLive, typeStats.numLiveBytes, typeStats.numCreated);
+	}
+}
+#endif
+
+
 void Application::CreateDeviceManager()
 {
 	auto creationParams = DeviceManagerCreationParams{}
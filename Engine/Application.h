@@ -10,7 +10,10 @@
 
 #pragma once
 
+#include "Core\TripleBuffer.h"
+#include "CpuTopology.h"
 #include "Graphics\GraphicsCommon.h"
+#include "TaskGraph.h"
 
 
 namespace Kodiak
@@ -20,6 +23,7 @@ namespace Kodiak
 class DeviceManager;
 class FileSystem;
 class InputSystem;
+class JobSystem;
 class LogSystem;
 enum class DigitalInput;
 enum class AnalogInput;
@@ -43,12 +47,52 @@ struct ApplicationDesc
 	bool useDebugMarkers{ false };
 #endif
 
+#if ENABLE_FILE_WATCHING
+	bool watchFiles{ true };
+#else
+	bool watchFiles{ false };
+#endif
+
+	// Run BeginFrame/Render/Present on a dedicated render thread, one frame behind Update
+	bool useRenderThread{ false };
+
+	// Where the main, render, job and log threads run, see ThreadPlacement.  Float leaves it to
+	// the OS, opt in to Group or Pin (--thread-affinity) after measuring on the target machines.
+	ThreadAffinity threadAffinity{ ThreadAffinity::Float };
+
 	ApplicationDesc& SetName(const std::string& value) { name = value; return *this; }
 	constexpr ApplicationDesc& SetWidth(uint32_t value) noexcept { width = value; return *this; }
 	constexpr ApplicationDesc& SetHeight(uint32_t value) noexcept { height = value; return *this; }
 	constexpr ApplicationDesc& SetApi(GraphicsApi value) noexcept { api = value; return *this; }
 	constexpr ApplicationDesc& SetUseValidation(bool value) noexcept { useValidation = value; return *this; }
 	constexpr ApplicationDesc& SetUseDebugMarkers(bool value) noexcept { useDebugMarkers = value; return *this; }
+	constexpr ApplicationDesc& SetWatchFiles(bool value) noexcept { watchFiles = value; return *this; }
+	constexpr ApplicationDesc& SetUseRenderThread(bool value) noexcept { useRenderThread = value; return *this; }
+	constexpr ApplicationDesc& SetThreadAffinity(ThreadAffinity value) noexcept { threadAffinity = value; return *this; }
+};
+
+
+// Everything the render thread needs to draw a frame, captured on the game thread after Update.
+// Derive from it to add application state, see Application::CreateFrameData.
+struct FrameData
+{
+	virtual ~FrameData() = default;
+
+	uint64_t frameNumber{ 0 };
+	float frameTimer{ 0.0f };
+	float appElapsedTime{ 0.0f };
+};
+
+
+// The engine's own tasks in the frame graph, for derived classes to depend on.  With a render
+// thread, the last three aren't in the graph.
+struct FrameTasks
+{
+	TaskId input{ 0 };
+	TaskId update{ 0 };
+	TaskId beginFrame{ s_invalidTask };
+	TaskId render{ s_invalidTask };
+	TaskId present{ s_invalidTask };
 };
 
 
@@ -71,6 +115,17 @@ public:
 	virtual void UpdateUI() {}
 	virtual void Render() {}
 
+	// Add tasks to the frame graph, depending on m_frameTasks to order them against the engine's
+	virtual void AddFrameTasks(TaskGraph& frameGraph) {}
+
+	// With a render thread (ApplicationDesc::useRenderThread), Update must not touch anything
+	// RenderFrame reads.  Copy it into a FrameData in PrepareFrameData instead, which runs after
+	// Update on the game thread.  RenderFrame gets the copy on the render thread, while the next
+	// Update runs.  Without a render thread, Render is called directly.
+	virtual std::unique_ptr<FrameData> CreateFrameData() { return std::make_unique<FrameData>(); }
+	virtual void PrepareFrameData(FrameData& frameData) {}
+	virtual void RenderFrame(const FrameData& frameData) { Render(); }
+
 	// Accessors
 	const HINSTANCE GetHINSTANCE() const { return m_hinst; }
 	const HWND GetHWND() const { return m_hwnd; }
@@ -102,17 +157,44 @@ protected:
 	float m_timerSpeed{ 1.0f };
 	uint32_t m_lastFps{ 0 };
 	uint32_t m_frameCounter{ 0 };
+	uint64_t m_arenaHeapAllocations{ 0 };
+#if ENABLE_ALLOCATION_TRACKING
+	AllocationStats m_lastAllocationTotals;
+	uint64_t m_maxFrameAllocations{ 0 };
+	uint64_t m_numTrackedFrames{ 0 };
+	uint32_t m_numAllocatingFrames{ 0 };
+	AllocationSnapshot m_lastAllocationSnapshot;
+#endif
+#if ENABLE_IOBJECT_REGISTRY
+	uint64_t m_numLiveIObjects{ 0 };
+#endif
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_appStartTime;
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_lastTimestamp;
 
 	HINSTANCE	m_hinst{};
 	HWND		m_hwnd{};
 
-	// Engine systems
+	// Which cores each engine thread gets
+	std::unique_ptr<ThreadPlacement> m_threadPlacement;
+
+	// Engine systems.  The job system is declared first so it is destroyed last, the others use it.
+	std::unique_ptr<JobSystem> m_jobSystem;
 	std::unique_ptr<FileSystem> m_filesystem;
 	std::unique_ptr<LogSystem> m_logSystem;
 	std::unique_ptr<InputSystem> m_inputSystem;
 	DeviceManagerHandle m_deviceManager;
+
+	// Runs input, Update, Render and Present each frame.  The next frame's input and Update
+	// overlap the previous frame's Present.
+	std::unique_ptr<TaskGraph> m_frameGraph;
+	FrameTasks m_frameTasks;
+	TaskId m_tickTask{ s_invalidTask };
+	bool m_continueRunning{ true };
+	bool m_presentFrame{ false };
+
+	// Render thread mode
+	std::unique_ptr<TripleBuffer<std::unique_ptr<FrameData>>> m_frameSnapshots;
+	std::thread m_renderThread;
 	
 private:
 	void Initialize();
@@ -120,6 +202,20 @@ private:
 	bool Tick();
 
 	void CreateDeviceManager();
+	void CreateFrameGraph();
+
+	void StartRenderThread();
+	void StopRenderThread();
+	void PublishFrame();
+	void RenderLoop();
+
+#if ENABLE_ALLOCATION_TRACKING
+	void LogAllocationStats(uint32_t numFrames);
+#endif
+#if ENABLE_IOBJECT_REGISTRY
+	void LogIObjectStats();
+	void ReportLeakedIObjects();
+#endif
 };
 
 
@@ -0,0 +1,333 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "AsyncFileReader.h"
+
+#include "FileSystem.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+// Completion key used to wake the completion loop for shutdown
+constexpr ULONG_PTR s_quitKey{ 1 };
+
+// Kernel handles aren't free, and a large working set would otherwise keep every file open
+constexpr size_t s_maxOpenFiles{ 256 };
+
+} // anonymous namespace
+
+
+AsyncFile::~AsyncFile()
+{
+	CloseHandle(m_fileHandle);
+}
+
+
+AsyncRead::AsyncRead(uint64_t offset, size_t size, void* destination) noexcept
+	: m_offset{ offset }
+	, m_size{ size }
+	, m_destination{ destination }
+{
+	m_overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+	m_overlapped.OffsetHigh = (DWORD)(offset >> 32);
+}
+
+
+void AsyncRead::Wait() const
+{
+	m_status.wait(AsyncReadStatus::Pending, memory_order_acquire);
+}
+
+
+void AsyncRead::Complete(size_t bytesRead, uint32_t errorCode)
+{
+	// Running off the end of the file is a short read, not a failure
+	if (errorCode == ERROR_HANDLE_EOF)
+	{
+		errorCode = ERROR_SUCCESS;
+	}
+
+	m_bytesRead = bytesRead;
+	m_errorCode = errorCode;
+
+	m_status.store(errorCode == ERROR_SUCCESS ? AsyncReadStatus::Completed : AsyncReadStatus::Failed, memory_order_release);
+	m_status.notify_all();
+}
+
+
+void Kodiak::WaitForAll(span<const AsyncReadHandle> reads)
+{
+	for (const auto& read : reads)
+	{
+		if (read)
+		{
+			read->Wait();
+		}
+	}
+}
+
+
+AsyncFileReader::AsyncFileReader()
+{
+	m_completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+	if (m_completionPort == nullptr)
+	{
+		LogWarning(LogFileSystem) << "Failed to create I/O completion port, async reads will use the thread pool.  Error code: " << GetLastError() << endl;
+		return;
+	}
+
+	m_completionLoop = async(launch::async, [this] { CompletionLoop(); });
+}
+
+
+AsyncFileReader::~AsyncFileReader()
+{
+	// Outstanding reads hold file handles and point at caller memory, let them finish
+	uint32_t pendingReads = m_pendingReads.load(memory_order_acquire);
+	while (pendingReads != 0)
+	{
+		m_pendingReads.wait(pendingReads, memory_order_acquire);
+		pendingReads = m_pendingReads.load(memory_order_acquire);
+	}
+
+	if (m_completionPort != nullptr)
+	{
+		PostQueuedCompletionStatus(m_completionPort, 0, s_quitKey, nullptr);
+		m_completionLoop.get();
+
+		CloseHandle(m_completionPort);
+		m_completionPort = nullptr;
+	}
+
+	InvalidateAllFiles();
+}
+
+
+AsyncReadHandle AsyncFileReader::Read(const string& fullPath, uint64_t offset, size_t size, void* destination)
+{
+	assert(destination != nullptr || size == 0);
+
+	// ReadFile takes a DWORD count, a larger read would be silently truncated
+	if (size > MAXDWORD)
+	{
+		return MakeFailedRead(ERROR_INVALID_PARAMETER);
+	}
+
+	auto read = AsyncReadHandle::Create(new AsyncRead(offset, size, destination));
+
+	read->m_file = GetFile(fullPath);
+	if (!read->m_file)
+	{
+		read->Complete(0, GetLastError());
+		return read;
+	}
+
+	if (size == 0)
+	{
+		read->Complete(0, ERROR_SUCCESS);
+		return read;
+	}
+
+	Submit(read.Get());
+
+	return read;
+}
+
+
+AsyncReadHandle AsyncFileReader::Execute(function<uint32_t(size_t& bytesRead)> readFunc)
+{
+	auto read = AsyncReadHandle::Create(new AsyncRead(0, 0, nullptr));
+	read->m_readFunc = move(readFunc);
+
+	read->AddRef();
+	read->m_reader = this;
+	m_pendingReads.fetch_add(1, memory_order_relaxed);
+
+	SubmitToThreadPool(read.Get());
+
+	return read;
+}
+
+
+AsyncReadHandle AsyncFileReader::MakeFailedRead(uint32_t errorCode)
+{
+	auto read = AsyncReadHandle::Create(new AsyncRead(0, 0, nullptr));
+	read->Complete(0, errorCode);
+	return read;
+}
+
+
+void AsyncFileReader::InvalidateFile(const string& fullPath)
+{
+	lock_guard<mutex> lock(m_fileMutex);
+
+	auto it = m_fileLookup.find(fullPath);
+	if (it != m_fileLookup.end())
+	{
+		const auto fileIt = it->second;
+		m_fileLookup.erase(it);
+		m_files.erase(fileIt);
+	}
+}
+
+
+void AsyncFileReader::InvalidateAllFiles()
+{
+	lock_guard<mutex> lock(m_fileMutex);
+
+	m_fileLookup.clear();
+	m_files.clear();
+}
+
+
+AsyncFileHandle AsyncFileReader::GetFile(const string& fullPath)
+{
+	lock_guard<mutex> lock(m_fileMutex);
+
+	auto it = m_fileLookup.find(fullPath);
+	if (it != m_fileLookup.end())
+	{
+		m_files.splice(m_files.begin(), m_files, it->second);
+		return m_files.front().second;
+	}
+
+	// Share write and delete so tools can still replace files that have been read from
+	const DWORD overlappedFlag = (m_completionPort != nullptr) ? FILE_FLAG_OVERLAPPED : 0;
+	HANDLE fileHandle = CreateFileA(fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | overlappedFlag, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		const DWORD errorCode = GetLastError();
+		LogWarning(LogFileSystem) << "Failed to open " << fullPath << " for async reads.  Error code: " << errorCode << endl;
+		SetLastError(errorCode);
+		return nullptr;
+	}
+
+	if (m_completionPort != nullptr)
+	{
+		CreateIoCompletionPort(fileHandle, m_completionPort, 0, 0);
+	}
+
+	// Reads in flight hold their own reference, the handle closes when they finish
+	if (m_files.size() >= s_maxOpenFiles)
+	{
+		m_fileLookup.erase(m_files.back().first);
+		m_files.pop_back();
+	}
+
+	m_files.emplace_front(fullPath, AsyncFileHandle::Create(new AsyncFile(fileHandle)));
+	m_fileLookup.emplace(m_files.front().first, m_files.begin());
+
+	return m_files.front().second;
+}
+
+
+void AsyncFileReader::Submit(AsyncRead* read)
+{
+	// The reader holds a reference while the read is in flight
+	read->AddRef();
+	read->m_reader = this;
+	m_pendingReads.fetch_add(1, memory_order_relaxed);
+
+	if (m_completionPort == nullptr)
+	{
+		SubmitToThreadPool(read);
+		return;
+	}
+
+	// Completions are always queued to the port, even when ReadFile finishes synchronously
+	if (!ReadFile(read->m_file->GetHandle(), read->m_destination, (DWORD)read->m_size, nullptr, &read->m_overlapped))
+	{
+		const DWORD errorCode = GetLastError();
+		if (errorCode != ERROR_IO_PENDING)
+		{
+			OnReadComplete(read, 0, errorCode);
+		}
+	}
+}
+
+
+void AsyncFileReader::SubmitToThreadPool(AsyncRead* read)
+{
+	if (!TrySubmitThreadpoolCallback(ThreadPoolRead, read, nullptr))
+	{
+		// No thread pool either, read inline
+		ThreadPoolRead(nullptr, read);
+	}
+}
+
+
+void AsyncFileReader::OnReadComplete(AsyncRead* read, size_t bytesRead, uint32_t errorCode)
+{
+	// Don't keep an evicted file open for as long as the caller holds the read
+	read->m_file = nullptr;
+	read->Complete(bytesRead, errorCode);
+	read->Release();
+
+	if (m_pendingReads.fetch_sub(1, memory_order_acq_rel) == 1)
+	{
+		m_pendingReads.notify_all();
+	}
+}
+
+
+void AsyncFileReader::CompletionLoop()
+{
+	while (true)
+	{
+		DWORD bytesTransferred{ 0 };
+		ULONG_PTR completionKey{ 0 };
+		OVERLAPPED* overlapped{ nullptr };
+
+		const BOOL result = GetQueuedCompletionStatus(m_completionPort, &bytesTransferred, &completionKey, &overlapped, INFINITE);
+
+		if (overlapped == nullptr)
+		{
+			if (completionKey == s_quitKey)
+			{
+				return;
+			}
+			continue;
+		}
+
+		AsyncRead* read = CONTAINING_RECORD(overlapped, AsyncRead, m_overlapped);
+		OnReadComplete(read, bytesTransferred, result ? ERROR_SUCCESS : GetLastError());
+	}
+}
+
+
+void CALLBACK AsyncFileReader::ThreadPoolRead(PTP_CALLBACK_INSTANCE instance, void* context)
+{
+	(void)instance;
+
+	AsyncRead* read = reinterpret_cast<AsyncRead*>(context);
+
+	if (read->m_readFunc)
+	{
+		size_t bytesRead{ 0 };
+		const uint32_t errorCode = read->m_readFunc(bytesRead);
+		read->m_readFunc = nullptr;
+		read->m_reader->OnReadComplete(read, bytesRead, errorCode);
+		return;
+	}
+
+	// Without FILE_FLAG_OVERLAPPED, the OVERLAPPED struct just carries the offset
+	DWORD bytesRead{ 0 };
+	const BOOL result = ReadFile(read->m_file->GetHandle(), read->m_destination, (DWORD)read->m_size, &bytesRead, &read->m_overlapped);
+
+	read->m_reader->OnReadComplete(read, bytesRead, result ? ERROR_SUCCESS : GetLastError());
+}
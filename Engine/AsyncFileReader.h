@@ -0,0 +1,158 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core\FlatHashMap.h"
+
+namespace Kodiak
+{
+
+// Forward declarations
+class AsyncFileReader;
+
+
+struct AsyncReadDesc
+{
+	std::string fname;
+	uint64_t offset{ 0 };
+	size_t size{ 0 };
+	void* destination{ nullptr };
+
+	AsyncReadDesc& SetFilename(const std::string& value) { fname = value; return *this; }
+	constexpr AsyncReadDesc& SetOffset(uint64_t value) noexcept { offset = value; return *this; }
+	constexpr AsyncReadDesc& SetSize(size_t value) noexcept { size = value; return *this; }
+	constexpr AsyncReadDesc& SetDestination(void* value) noexcept { destination = value; return *this; }
+};
+
+
+enum class AsyncReadStatus : uint32_t
+{
+	Pending,
+	Completed,
+	Failed
+};
+
+
+// An open file shared by the reads against it, closed when the last reference goes.  A file
+// evicted from the reader's cache stays open until the reads already issued against it finish.
+class AsyncFile : public IObject, public NonCopyable
+{
+	IMPLEMENT_IOBJECT
+
+public:
+	explicit AsyncFile(HANDLE fileHandle) noexcept : m_fileHandle{ fileHandle } {}
+	~AsyncFile();
+
+	HANDLE GetHandle() const noexcept { return m_fileHandle; }
+
+private:
+	const HANDLE m_fileHandle{ INVALID_HANDLE_VALUE };
+};
+using AsyncFileHandle = IntrusivePtr<AsyncFile>;
+
+
+// Completion handle for a single asynchronous read.  The destination buffer must stay
+// valid until the read is complete.  Reads that run past the end of the file complete
+// successfully with fewer bytes read than requested.
+class AsyncRead : public IObject, public NonCopyable
+{
+	IMPLEMENT_IOBJECT
+
+	friend class AsyncFileReader;
+
+public:
+	AsyncRead(uint64_t offset, size_t size, void* destination) noexcept;
+
+	AsyncReadStatus GetStatus() const noexcept { return m_status.load(std::memory_order_acquire); }
+	bool IsComplete() const noexcept { return GetStatus() != AsyncReadStatus::Pending; }
+	bool Succeeded() const noexcept { return GetStatus() == AsyncReadStatus::Completed; }
+
+	// Blocks until the read is complete
+	void Wait() const;
+
+	size_t GetBytesRead() const noexcept { return m_bytesRead; }
+	uint32_t GetErrorCode() const noexcept { return m_errorCode; }
+
+private:
+	void Complete(size_t bytesRead, uint32_t errorCode);
+
+private:
+	// The completion port hands back this pointer, CONTAINING_RECORD recovers the read from it
+	OVERLAPPED m_overlapped{};
+
+	AsyncFileReader* m_reader{ nullptr };
+	AsyncFileHandle m_file;
+	uint64_t m_offset{ 0 };
+	size_t m_size{ 0 };
+	void* m_destination{ nullptr };
+	std::function<uint32_t(size_t&)> m_readFunc;
+
+	size_t m_bytesRead{ 0 };
+	uint32_t m_errorCode{ 0 };
+	std::atomic<AsyncReadStatus> m_status{ AsyncReadStatus::Pending };
+};
+using AsyncReadHandle = IntrusivePtr<AsyncRead>;
+
+
+// Blocks until every read in the list is complete
+void WaitForAll(std::span<const AsyncReadHandle> reads);
+
+
+// Issues overlapped reads against an I/O completion port, so any number of reads can be
+// in flight at once.  A single thread drains the port and signals the completion handles.
+// If the completion port can't be created, reads run as blocking reads on the system
+// thread pool instead.
+class AsyncFileReader : NonCopyable, NonMovable
+{
+public:
+	AsyncFileReader();
+	~AsyncFileReader();
+
+	// fullPath must be an absolute path, FileSystem resolves names before calling this.  Reads are
+	// limited to 4GB, larger ones fail with ERROR_INVALID_PARAMETER.
+	AsyncReadHandle Read(const std::string& fullPath, uint64_t offset, size_t size, void* destination);
+
+	// Runs readFunc on the thread pool and completes the returned read with its result, for reads
+	// that need more work than a single ReadFile.  readFunc returns a Win32 error code.
+	AsyncReadHandle Execute(std::function<uint32_t(size_t& bytesRead)> readFunc);
+
+	// Returns a read that has already failed with the given error code
+	static AsyncReadHandle MakeFailedRead(uint32_t errorCode);
+
+	// Closes the cached handle for a file that changed on disk, so the next read opens it again
+	// (a save by renaming over the file leaves the old handle reading the old file)
+	void InvalidateFile(const std::string& fullPath);
+	void InvalidateAllFiles();
+
+private:
+	AsyncFileHandle GetFile(const std::string& fullPath);
+	void Submit(AsyncRead* read);
+	void SubmitToThreadPool(AsyncRead* read);
+	void OnReadComplete(AsyncRead* read, size_t bytesRead, uint32_t errorCode);
+	void CompletionLoop();
+
+	static void CALLBACK ThreadPoolRead(PTP_CALLBACK_INSTANCE instance, void* context);
+
+private:
+	HANDLE m_completionPort{ nullptr };
+	std::future<void> m_completionLoop;
+
+	// Open files, most recently used first, and at most s_maxOpenFiles of them.  Lookup keys
+	// point at the names in the list.
+	using FileList = std::list<std::pair<std::string, AsyncFileHandle>>;
+	std::mutex m_fileMutex;
+	FileList m_files;
+	FlatHashMap<std::string_view, FileList::iterator> m_fileLookup;
+
+	std::atomic<uint32_t> m_pendingReads{ 0 };
+};
+
+} // namespace Kodiak
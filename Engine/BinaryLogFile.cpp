@@ -0,0 +1,211 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "BinaryLogFile.h"
+
+#include "LogSystem.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+// Keeps any one record well inside a segment, see s_maxStringLength
+constexpr size_t s_minSegmentSize{ 1024 * 1024 };
+
+} // anonymous namespace
+
+
+BinaryLogFile::~BinaryLogFile()
+{
+	Close();
+}
+
+
+bool BinaryLogFile::Open(const RollingLogFileDesc& desc)
+{
+	assert(!IsOpen());
+	assert(desc.segmentSize >= s_minSegmentSize);
+
+	if (!m_file.Open(desc))
+	{
+		return false;
+	}
+
+	WriteSegmentHeader();
+
+	return true;
+}
+
+
+void BinaryLogFile::Close()
+{
+	m_file.Close();
+
+	m_buffer.clear();
+	m_categoryIds.clear();
+	m_nextCategoryId = 1;
+	m_formatIds.clear();
+	m_formats.clear();
+}
+
+
+void BinaryLogFile::Write(const LogMessage& message)
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	const uint32_t categoryId = message.category.IsValid() ? GetCategoryId(message.category.GetNameId()) : 0;
+	const uint32_t formatId = message.format.empty() ? 0 : GetFormatId(message.format);
+
+	WriteValue(BinaryLogRecordType::Message);
+	WriteValue<uint64_t>(message.timestamp.time_since_epoch().count());
+	WriteValue<uint32_t>(message.threadId);
+	WriteValue<uint32_t>(categoryId);
+	WriteValue<uint8_t>((uint8_t)message.severity);
+	WriteValue<uint32_t>(formatId);
+
+	if (formatId == 0)
+	{
+		// Preformatted by LogProxy, a single string arg
+		const size_t length = std::min(message.messageStr.size(), s_maxStringLength);
+		WriteValue<uint8_t>(1);
+		WriteValue(BinaryLogArgType::String);
+		WriteValue<uint32_t>((uint32_t)length);
+		WriteBytes(message.messageStr.data(), length);
+	}
+	else
+	{
+		// Packed in this layout at the call site
+		WriteValue<uint8_t>(message.numArgs);
+		WriteBytes(message.args.data(), message.args.size());
+	}
+
+	CommitRecord();
+
+	if (message.severity == Severity::Fatal || message.severity == Severity::Error)
+	{
+		Flush();
+	}
+}
+
+
+void BinaryLogFile::Flush()
+{
+	m_file.Flush();
+}
+
+
+uint32_t BinaryLogFile::GetCategoryId(StringId categoryName)
+{
+	auto it = m_categoryIds.find(categoryName);
+	if (it != m_categoryIds.end())
+	{
+		return it->second;
+	}
+
+	const uint32_t categoryId = m_nextCategoryId++;
+	m_categoryIds.emplace(categoryName, categoryId);
+	WriteCategoryRecord(categoryName, categoryId);
+
+	return categoryId;
+}
+
+
+uint32_t BinaryLogFile::GetFormatId(string_view format)
+{
+	auto it = m_formatIds.find(format.data());
+	if (it != m_formatIds.end())
+	{
+		return it->second;
+	}
+
+	m_formats.push_back(format);
+	const uint32_t formatId = (uint32_t)m_formats.size();
+	m_formatIds.emplace(format.data(), formatId);
+	WriteFormatRecord(format, formatId);
+
+	return formatId;
+}
+
+
+void BinaryLogFile::WriteCategoryRecord(StringId categoryName, uint32_t categoryId)
+{
+	WriteValue(BinaryLogRecordType::Category);
+	WriteValue<uint32_t>(categoryId);
+	const string_view nameStr = categoryName.GetString();
+	WriteValue<uint16_t>((uint16_t)nameStr.size());
+	WriteBytes(nameStr.data(), nameStr.size());
+}
+
+
+void BinaryLogFile::WriteFormatRecord(string_view format, uint32_t formatId)
+{
+	const size_t length = std::min<size_t>(format.size(), UINT16_MAX);
+	WriteValue(BinaryLogRecordType::Format);
+	WriteValue<uint32_t>(formatId);
+	WriteValue<uint16_t>((uint16_t)length);
+	WriteBytes(format.data(), length);
+}
+
+
+// Repeats every definition so far, so the segment decodes without the ones before it
+void BinaryLogFile::WriteSegmentHeader()
+{
+	// Built in the buffer, so set aside any record waiting for the new segment
+	vector<char> record;
+	swap(record, m_buffer);
+
+	using period = chrono::system_clock::period;
+	static_assert(period::num == 1);
+
+	WriteBytes(s_magic, sizeof(s_magic));
+	WriteValue<uint16_t>(s_version);
+	WriteValue<uint16_t>(0);
+	WriteValue<uint64_t>(period::den);
+
+	for (const auto& [categoryName, categoryId] : m_categoryIds)
+	{
+		WriteCategoryRecord(categoryName, categoryId);
+	}
+
+	for (size_t i = 0; i < m_formats.size(); ++i)
+	{
+		WriteFormatRecord(m_formats[i], (uint32_t)(i + 1));
+	}
+
+	m_file.Write({ m_buffer.data(), m_buffer.size() });
+	m_buffer = move(record);
+}
+
+
+// Records never straddle two segments
+void BinaryLogFile::CommitRecord()
+{
+	if (m_buffer.size() > m_file.GetBytesAvailable())
+	{
+		if (!m_file.NextSegment())
+		{
+			m_buffer.clear();
+			return;
+		}
+		WriteSegmentHeader();
+	}
+
+	m_file.Write({ m_buffer.data(), m_buffer.size() });
+	m_buffer.clear();
+}
@@ -0,0 +1,119 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core\FlatHashMap.h"
+#include "RollingLogFile.h"
+
+namespace Kodiak
+{
+
+// Forward declarations
+struct LogMessage;
+
+
+// Binary log file layout (all values little-endian).  Decoded by Programs\LogDecoder\DecodeLog.py.
+//
+//   Header:    char[4] magic "KLOG", u16 version, u16 reserved, u64 ticks per second
+//
+//   Records start with a u8 BinaryLogRecordType:
+//     Category:  u32 categoryId, u16 nameLength, char[nameLength] name
+//     Format:    u32 formatId, u16 length, char[length] std::format string
+//     Message:   u64 ticks since 1970-01-01 UTC, u32 threadId, u32 categoryId, u8 severity,
+//                u32 formatId, u8 argCount, args...
+//
+//   Each arg starts with a u8 BinaryLogArgType:
+//     String:    u32 length, char[length] data
+//     Int:       i64
+//     UInt:      u64
+//     Double:    f64
+//     Bool:      u8
+//
+// Category id 0 is the invalid (unnamed) category.  Format id 0 is "{}", a single preformatted string arg.
+//
+// The file is written in segments, like the text log.  Every segment starts with a header and the
+// category and format records in use, so each can be decoded on its own.  A segment that wasn't
+// closed (the process died) is padded with zeroes after the last record.
+enum class BinaryLogRecordType : uint8_t
+{
+	Category = 1,
+	Message = 2,
+	Format = 3
+};
+
+
+enum class BinaryLogArgType : uint8_t
+{
+	String = 1,
+	Int = 2,
+	UInt = 3,
+	Double = 4,
+	Bool = 5
+};
+
+
+class BinaryLogFile : NonCopyable, NonMovable
+{
+public:
+	static constexpr char s_magic[4]{ 'K', 'L', 'O', 'G' };
+	static constexpr uint16_t s_version{ 2 };
+	static constexpr size_t s_maxStringLength{ 64 * 1024 };
+
+	BinaryLogFile() = default;
+	~BinaryLogFile();
+
+	bool Open(const RollingLogFileDesc& desc);
+	void Close();
+
+	bool IsOpen() const noexcept { return m_file.IsOpen(); }
+
+	// Messages at Error and above are flushed to disk right away
+	void Write(const LogMessage& message);
+	void Flush();
+
+private:
+	uint32_t GetCategoryId(StringId categoryName);
+	uint32_t GetFormatId(std::string_view format);
+
+	void WriteCategoryRecord(StringId categoryName, uint32_t categoryId);
+	void WriteFormatRecord(std::string_view format, uint32_t formatId);
+	void WriteSegmentHeader();
+	void CommitRecord();
+
+	template <typename T>
+	void WriteValue(T value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		const auto* bytes = reinterpret_cast<const char*>(&value);
+		m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	void WriteBytes(const char* data, size_t size)
+	{
+		m_buffer.insert(m_buffer.end(), data, data + size);
+	}
+
+private:
+	RollingLogFile m_file;
+
+	// The record being built, or the definitions it needs when they're new
+	std::vector<char> m_buffer;
+
+	FlatHashMap<StringId, uint32_t> m_categoryIds;
+	uint32_t m_nextCategoryId{ 1 };
+
+	// Format strings are literals, so they're keyed by address.  The same text at two addresses
+	// just gets two ids.
+	FlatHashMap<const char*, uint32_t> m_formatIds;
+	std::vector<std::string_view> m_formats;
+};
+
+} // namespace Kodiak
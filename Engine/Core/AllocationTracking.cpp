@@ -0,0 +1,321 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "AllocationTracking.h"
+
+#include <cstdlib>
+#include <new>
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+// Threads past this share one set of counters
+constexpr uint32_t s_maxTrackedThreads{ 128 };
+constexpr size_t s_maxThreadNameLength{ 32 };
+
+
+struct TagCounters
+{
+	atomic<uint64_t> numAllocations{ 0 };
+	atomic<uint64_t> numBytes{ 0 };
+	atomic<uint64_t> numFrees{ 0 };
+};
+
+
+// Written by the owning thread only, except for the shared overflow counters, so a plain load
+// and store is enough.  Everything here is constant initialized, allocations can be counted
+// before any static constructor runs.
+struct ThreadCounters
+{
+	array<TagCounters, (size_t)AllocationTag::Count> tags;
+	char threadName[s_maxThreadNameLength]{};
+};
+
+ThreadCounters g_threadCounters[s_maxTrackedThreads + 1];
+ThreadCounters& g_overflowCounters = g_threadCounters[s_maxTrackedThreads];
+atomic<uint32_t> g_numThreads{ 0 };
+
+// Guards the thread names
+mutex g_threadNameMutex;
+
+thread_local ThreadCounters* t_threadCounters{ nullptr };
+thread_local AllocationTag t_allocationTag{ AllocationTag::Untagged };
+
+
+ThreadCounters& GetThreadCounters() noexcept
+{
+	if (t_threadCounters == nullptr)
+	{
+		const uint32_t index = g_numThreads.fetch_add(1, memory_order_relaxed);
+		t_threadCounters = index < s_maxTrackedThreads ? &g_threadCounters[index] : &g_overflowCounters;
+	}
+	return *t_threadCounters;
+}
+
+
+uint32_t GetNumTrackedThreads() noexcept
+{
+	return std::min(g_numThreads.load(memory_order_relaxed), s_maxTrackedThreads);
+}
+
+
+AllocationStats ReadCounters(const TagCounters& counters) noexcept
+{
+	return {
+		counters.numAllocations.load(memory_order_relaxed),
+		counters.numBytes.load(memory_order_relaxed),
+		counters.numFrees.load(memory_order_relaxed) };
+}
+
+
+AllocationStats ReadCounters(const ThreadCounters& counters) noexcept
+{
+	AllocationStats stats;
+	for (const auto& tagCounters : counters.tags)
+	{
+		stats += ReadCounters(tagCounters);
+	}
+	return stats;
+}
+
+
+#if ENABLE_ALLOCATION_TRACKING
+
+void AddToCounter(atomic<uint64_t>& counter, uint64_t amount, bool isShared) noexcept
+{
+	if (isShared)
+	{
+		counter.fetch_add(amount, memory_order_relaxed);
+	}
+	else
+	{
+		counter.store(counter.load(memory_order_relaxed) + amount, memory_order_relaxed);
+	}
+}
+
+
+void RecordAllocation(size_t size) noexcept
+{
+	ThreadCounters& counters = GetThreadCounters();
+	TagCounters& tagCounters = counters.tags[(size_t)t_allocationTag];
+	const bool isShared = &counters == &g_overflowCounters;
+
+	AddToCounter(tagCounters.numAllocations, 1, isShared);
+	AddToCounter(tagCounters.numBytes, size, isShared);
+}
+
+
+void RecordFree() noexcept
+{
+	ThreadCounters& counters = GetThreadCounters();
+	AddToCounter(counters.tags[(size_t)t_allocationTag].numFrees, 1, &counters == &g_overflowCounters);
+}
+
+
+void* AllocateRaw(size_t size, size_t alignment) noexcept
+{
+	if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+	{
+		return malloc(size);
+	}
+
+#if defined(_WIN32)
+	return _aligned_malloc(size, alignment);
+#else
+	return aligned_alloc(alignment, Math::AlignUp(size, alignment));
+#endif
+}
+
+
+void FreeRaw(void* p, size_t alignment) noexcept
+{
+#if defined(_WIN32)
+	if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+	{
+		_aligned_free(p);
+		return;
+	}
+#endif
+	free(p);
+}
+
+
+// Same contract as the standard operator new: retry through the new handler, throw without one
+void* TrackedAllocate(size_t size, size_t alignment)
+{
+	size = std::max<size_t>(size, 1);
+
+	for (;;)
+	{
+		if (void* p = AllocateRaw(size, alignment))
+		{
+			RecordAllocation(size);
+			return p;
+		}
+
+		new_handler handler = get_new_handler();
+		if (handler == nullptr)
+		{
+			throw bad_alloc{};
+		}
+		handler();
+	}
+}
+
+
+void* TrackedAllocateNoThrow(size_t size, size_t alignment) noexcept
+{
+	try
+	{
+		return TrackedAllocate(size, alignment);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+
+void TrackedFree(void* p, size_t alignment) noexcept
+{
+	if (p != nullptr)
+	{
+		RecordFree();
+		FreeRaw(p, alignment);
+	}
+}
+
+#endif // ENABLE_ALLOCATION_TRACKING
+
+} // anonymous namespace
+
+
+ScopedAllocationTag::ScopedAllocationTag(AllocationTag allocationTag) noexcept
+	: m_previousTag{ t_allocationTag }
+{
+	t_allocationTag = allocationTag;
+}
+
+
+ScopedAllocationTag::~ScopedAllocationTag()
+{
+	t_allocationTag = m_previousTag;
+}
+
+
+AllocationStats Kodiak::GetAllocationTotals() noexcept
+{
+	AllocationStats totals;
+
+	const uint32_t numThreads = GetNumTrackedThreads();
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		totals += ReadCounters(g_threadCounters[i]);
+	}
+	totals += ReadCounters(g_overflowCounters);
+
+	return totals;
+}
+
+
+AllocationStats Kodiak::GetAllocationTotals(AllocationTag allocationTag) noexcept
+{
+	AllocationStats totals;
+
+	const uint32_t numThreads = GetNumTrackedThreads();
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		totals += ReadCounters(g_threadCounters[i].tags[(size_t)allocationTag]);
+	}
+	totals += ReadCounters(g_overflowCounters.tags[(size_t)allocationTag]);
+
+	return totals;
+}
+
+
+AllocationSnapshot Kodiak::GetAllocationSnapshot()
+{
+	AllocationSnapshot snapshot;
+
+	const uint32_t numThreads = GetNumTrackedThreads();
+	snapshot.threads.reserve(numThreads + 1);
+
+	auto addThread = [&snapshot](const ThreadCounters& counters, string threadName)
+	{
+		for (size_t tag = 0; tag < (size_t)AllocationTag::Count; ++tag)
+		{
+			snapshot.tags[tag] += ReadCounters(counters.tags[tag]);
+		}
+		snapshot.threads.push_back({ move(threadName), ReadCounters(counters) });
+	};
+
+	lock_guard<mutex> lock(g_threadNameMutex);
+
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		const ThreadCounters& counters = g_threadCounters[i];
+		addThread(counters, counters.threadName[0] != '\0' ? string{ counters.threadName } : format("Thread {}", i));
+	}
+	addThread(g_overflowCounters, "Other threads");
+
+	return snapshot;
+}
+
+
+void Kodiak::SetAllocationThreadName(string_view threadName)
+{
+	ThreadCounters& counters = GetThreadCounters();
+	if (&counters == &g_overflowCounters)
+	{
+		return;
+	}
+
+	lock_guard<mutex> lock(g_threadNameMutex);
+
+	const size_t length = std::min(threadName.size(), s_maxThreadNameLength - 1);
+	memcpy(counters.threadName, threadName.data(), length);
+	counters.threadName[length] = '\0';
+}
+
+
+#if ENABLE_ALLOCATION_TRACKING
+
+void* operator new(size_t size) { return TrackedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t size) { return TrackedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return TrackedAllocateNoThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return TrackedAllocateNoThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+
+void* operator new(size_t size, align_val_t alignment) { return TrackedAllocate(size, (size_t)alignment); }
+void* operator new[](size_t size, align_val_t alignment) { return TrackedAllocate(size, (size_t)alignment); }
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept { return TrackedAllocateNoThrow(size, (size_t)alignment); }
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept { return TrackedAllocateNoThrow(size, (size_t)alignment); }
+
+void operator delete(void* p) noexcept { TrackedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete[](void* p) noexcept { TrackedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete(void* p, size_t) noexcept { TrackedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete[](void* p, size_t) noexcept { TrackedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete(void* p, const nothrow_t&) noexcept { TrackedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void operator delete[](void* p, const nothrow_t&) noexcept { TrackedFree(p, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+
+void operator delete(void* p, align_val_t alignment) noexcept { TrackedFree(p, (size_t)alignment); }
+void operator delete[](void* p, align_val_t alignment) noexcept { TrackedFree(p, (size_t)alignment); }
+void operator delete(void* p, size_t, align_val_t alignment) noexcept { TrackedFree(p, (size_t)alignment); }
+void operator delete[](void* p, size_t, align_val_t alignment) noexcept { TrackedFree(p, (size_t)alignment); }
+void operator delete(void* p, align_val_t alignment, const nothrow_t&) noexcept { TrackedFree(p, (size_t)alignment); }
+void operator delete[](void* p, align_val_t alignment, const nothrow_t&) noexcept { TrackedFree(p, (size_t)alignment); }
+
+#endif // ENABLE_ALLOCATION_TRACKING
@@ -0,0 +1,120 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+// Heap allocation counting, for finding allocations in frames that shouldn't have any.  With
+// ENABLE_ALLOCATION_TRACKING set (see Stdafx.h) the global operator new and delete are replaced,
+// and every allocation and free is counted against the calling thread and the thread's current
+// AllocationTag.  Without it the tags compile away and every count reads zero.
+
+namespace Kodiak
+{
+
+enum class AllocationTag : uint8_t
+{
+	Untagged,
+	App,
+	Log,
+	FileSystem,
+	Graphics,
+
+	Count
+};
+
+
+inline std::string AllocationTagToString(AllocationTag allocationTag)
+{
+	switch (allocationTag)
+	{
+	case AllocationTag::App:
+		return "App";
+	case AllocationTag::Log:
+		return "Log";
+	case AllocationTag::FileSystem:
+		return "FileSystem";
+	case AllocationTag::Graphics:
+		return "Graphics";
+	default:
+		return "Untagged";
+	}
+}
+
+
+struct AllocationStats
+{
+	uint64_t numAllocations{ 0 };
+	uint64_t numBytes{ 0 };
+	uint64_t numFrees{ 0 };
+
+	AllocationStats& operator+=(const AllocationStats& other) noexcept
+	{
+		numAllocations += other.numAllocations;
+		numBytes += other.numBytes;
+		numFrees += other.numFrees;
+		return *this;
+	}
+
+	AllocationStats operator-(const AllocationStats& other) const noexcept
+	{
+		return { numAllocations - other.numAllocations, numBytes - other.numBytes, numFrees - other.numFrees };
+	}
+};
+
+
+struct ThreadAllocationStats
+{
+	std::string threadName;
+	AllocationStats stats;
+};
+
+
+struct AllocationSnapshot
+{
+	std::array<AllocationStats, (size_t)AllocationTag::Count> tags{};
+
+	// In the order the threads first allocated, so two snapshots line up by index
+	std::vector<ThreadAllocationStats> threads;
+};
+
+
+// Attributes the calling thread's allocations to a tag until the end of the scope, then goes back
+// to the enclosing scope's tag.  Use the ALLOCATION_TAG macro.
+class ScopedAllocationTag : NonCopyable, NonMovable
+{
+public:
+	explicit ScopedAllocationTag(AllocationTag allocationTag) noexcept;
+	~ScopedAllocationTag();
+
+private:
+	const AllocationTag m_previousTag{ AllocationTag::Untagged };
+};
+
+#if ENABLE_ALLOCATION_TRACKING
+// One per scope, e.g. ALLOCATION_TAG(Graphics);
+#define ALLOCATION_TAG(tag) const Kodiak::ScopedAllocationTag allocationTag{ Kodiak::AllocationTag::tag }
+#else
+#define ALLOCATION_TAG(tag)
+#endif
+
+
+// Everything counted since startup.  Doesn't allocate, cheap enough to call every frame.
+AllocationStats GetAllocationTotals() noexcept;
+
+// As above, for one tag
+AllocationStats GetAllocationTotals(AllocationTag allocationTag) noexcept;
+
+// Everything counted since startup, by tag and by thread
+AllocationSnapshot GetAllocationSnapshot();
+
+// Names the calling thread in snapshots
+void SetAllocationThreadName(std::string_view threadName);
+
+} // namespace Kodiak
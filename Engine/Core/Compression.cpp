@@ -0,0 +1,266 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Compression.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+constexpr size_t s_minMatch{ 4 };
+constexpr size_t s_maxOffset{ 65535 };
+// The format requires the last 5 bytes to be literals, and the last match to start 12 bytes before the end
+constexpr size_t s_lastLiterals{ 5 };
+constexpr size_t s_matchSearchLimit{ 12 };
+
+constexpr uint32_t s_hashBits{ 12 };
+
+
+uint32_t Read32(const uint8_t* ptr)
+{
+	uint32_t value;
+	memcpy(&value, ptr, sizeof(value));
+	return value;
+}
+
+
+uint32_t HashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761U) >> (32 - s_hashBits);
+}
+
+
+// Writes a 4 bit length nibble's overflow as a run of 255s and a remainder
+bool WriteLength(uint8_t*& out, const uint8_t* outEnd, size_t length)
+{
+	while (length >= 255)
+	{
+		if (out >= outEnd)
+		{
+			return false;
+		}
+		*out++ = 255;
+		length -= 255;
+	}
+
+	if (out >= outEnd)
+	{
+		return false;
+	}
+	*out++ = (uint8_t)length;
+	return true;
+}
+
+
+bool ReadLength(const uint8_t*& in, const uint8_t* inEnd, size_t& length)
+{
+	uint8_t value = 0;
+	do
+	{
+		if (in >= inEnd)
+		{
+			return false;
+		}
+		value = *in++;
+		length += value;
+	} while (value == 255);
+
+	return true;
+}
+
+
+bool WriteSequence(uint8_t*& out, const uint8_t* outEnd, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+	if (out >= outEnd)
+	{
+		return false;
+	}
+
+	uint8_t* token = out++;
+	*token = (uint8_t)(std::min<size_t>(literalLength, 15) << 4);
+
+	if (literalLength >= 15 && !WriteLength(out, outEnd, literalLength - 15))
+	{
+		return false;
+	}
+
+	if (out + literalLength > outEnd)
+	{
+		return false;
+	}
+	memcpy(out, literals, literalLength);
+	out += literalLength;
+
+	// The final sequence has literals only
+	if (matchLength == 0)
+	{
+		return true;
+	}
+
+	if (out + 2 > outEnd)
+	{
+		return false;
+	}
+	*out++ = (uint8_t)(offset & 0xFF);
+	*out++ = (uint8_t)(offset >> 8);
+
+	const size_t matchCode = matchLength - s_minMatch;
+	*token |= (uint8_t)std::min<size_t>(matchCode, 15);
+
+	if (matchCode >= 15 && !WriteLength(out, outEnd, matchCode - 15))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+} // anonymous namespace
+
+
+namespace Utility
+{
+
+size_t CompressBlock(span<const byte> src, span<byte> dst)
+{
+	const uint8_t* const inBegin = reinterpret_cast<const uint8_t*>(src.data());
+	const uint8_t* const inEnd = inBegin + src.size();
+	uint8_t* const outBegin = reinterpret_cast<uint8_t*>(dst.data());
+	const uint8_t* const outEnd = outBegin + dst.size();
+
+	uint8_t* out = outBegin;
+	const uint8_t* anchor = inBegin;
+
+	if (src.size() > s_matchSearchLimit)
+	{
+		// Positions of the last sequence seen with each hash
+		uint32_t hashTable[1 << s_hashBits];
+		fill(begin(hashTable), end(hashTable), UINT32_MAX);
+
+		const uint8_t* const matchLimit = inEnd - s_matchSearchLimit;
+		const uint8_t* in = inBegin;
+
+		while (in < matchLimit)
+		{
+			const uint32_t sequence = Read32(in);
+			const uint32_t hash = HashSequence(sequence);
+			const uint32_t candidatePos = hashTable[hash];
+			hashTable[hash] = (uint32_t)(in - inBegin);
+
+			const uint8_t* candidate = inBegin + candidatePos;
+			if (candidatePos == UINT32_MAX || (size_t)(in - candidate) > s_maxOffset || Read32(candidate) != sequence)
+			{
+				++in;
+				continue;
+			}
+
+			// Extend the match forward, stopping short of the trailing literals
+			const uint8_t* const extendLimit = inEnd - s_lastLiterals;
+			size_t matchLength = s_minMatch;
+			while (in + matchLength < extendLimit && candidate[matchLength] == in[matchLength])
+			{
+				++matchLength;
+			}
+
+			if (!WriteSequence(out, outEnd, anchor, (size_t)(in - anchor), (size_t)(in - candidate), matchLength))
+			{
+				return 0;
+			}
+
+			in += matchLength;
+			anchor = in;
+		}
+	}
+
+	if (!WriteSequence(out, outEnd, anchor, (size_t)(inEnd - anchor), 0, 0))
+	{
+		return 0;
+	}
+
+	return (size_t)(out - outBegin);
+}
+
+
+bool DecompressBlock(span<const byte> src, span<byte> dst)
+{
+	const uint8_t* in = reinterpret_cast<const uint8_t*>(src.data());
+	const uint8_t* const inEnd = in + src.size();
+	uint8_t* const outBegin = reinterpret_cast<uint8_t*>(dst.data());
+	uint8_t* out = outBegin;
+	uint8_t* const outEnd = outBegin + dst.size();
+
+	while (in < inEnd)
+	{
+		const uint8_t token = *in++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !ReadLength(in, inEnd, literalLength))
+		{
+			return false;
+		}
+
+		if ((size_t)(inEnd - in) < literalLength || (size_t)(outEnd - out) < literalLength)
+		{
+			return false;
+		}
+		memcpy(out, in, literalLength);
+		in += literalLength;
+		out += literalLength;
+
+		// The final sequence has no match
+		if (in == inEnd)
+		{
+			break;
+		}
+
+		if (inEnd - in < 2)
+		{
+			return false;
+		}
+		const size_t offset = (size_t)in[0] | ((size_t)in[1] << 8);
+		in += 2;
+
+		size_t matchLength = token & 0xF;
+		if (matchLength == 15 && !ReadLength(in, inEnd, matchLength))
+		{
+			return false;
+		}
+		matchLength += s_minMatch;
+
+		if (offset == 0 || offset > (size_t)(out - outBegin) || (size_t)(outEnd - out) < matchLength)
+		{
+			return false;
+		}
+
+		// Matches may overlap the bytes they produce, so copy forward a byte at a time when they do
+		const uint8_t* match = out - offset;
+		if (offset >= matchLength)
+		{
+			memcpy(out, match, matchLength);
+			out += matchLength;
+		}
+		else
+		{
+			for (size_t i = 0; i < matchLength; ++i)
+			{
+				*out++ = *match++;
+			}
+		}
+	}
+
+	return out == outEnd;
+}
+
+} // namespace Utility
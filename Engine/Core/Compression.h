@@ -0,0 +1,32 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+namespace Utility
+{
+
+// Fast LZ77 block codec using the LZ4 block format: a sequence of tokens, each with a run of literals
+// followed by a match of at least 4 bytes up to 64KB back.  Blocks are independent, so any number of
+// them can be decoded in parallel.  Programs\PackBuilder\BuildPack.py has a matching compressor.
+
+// Worst case compressed size for incompressible input
+constexpr size_t GetMaxCompressedSize(size_t srcSize) noexcept
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+// Returns the compressed size, or 0 if the result would not fit in dst
+size_t CompressBlock(std::span<const std::byte> src, std::span<std::byte> dst);
+
+// dst must be exactly the decompressed size.  Returns false if the block is malformed.
+bool DecompressBlock(std::span<const std::byte> src, std::span<std::byte> dst);
+
+} // namespace Utility
@@ -0,0 +1,864 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core\Hash.h"
+
+#include <bit>
+
+// Open-addressing hash containers in the style of Abseil's Swiss tables.  Each slot has a one byte
+// control word holding 7 bits of the key's hash (or an empty/deleted marker), and lookups compare
+// a 16 slot group of control bytes at once with SSE2, only touching slots whose hash bits match.
+// Entries are stored inline, so unlike std::unordered_map, pointers and iterators are invalidated
+// by any insert that grows the table.  Keep std::unordered_map where stable addresses are needed.
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define ENABLE_FLAT_HASH_SSE2 1
+#include <emmintrin.h>
+#else
+#define ENABLE_FLAT_HASH_SSE2 0
+#endif
+
+namespace Kodiak
+{
+
+// Default hasher.  std::hash is the identity for integers with some standard libraries, and the
+// tables need well mixed bits at both ends of the hash, so run it through a finalizer.
+template <typename Key>
+struct FlatHash
+{
+	size_t operator()(const Key& key) const noexcept
+	{
+		uint64_t hash = (uint64_t)std::hash<Key>{}(key);
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		return (size_t)hash;
+	}
+};
+
+
+template <>
+struct FlatHash<std::string_view>
+{
+	size_t operator()(std::string_view key) const noexcept
+	{
+		return Utility::HashRange(std::as_bytes(std::span{ key.data(), key.size() }));
+	}
+};
+
+
+template <>
+struct FlatHash<std::string> : FlatHash<std::string_view> {};
+
+
+// For keys that are already hashes, e.g. the result of Utility::HashState.  The table uses them as is.
+struct PrehashedHash
+{
+	size_t operator()(size_t key) const noexcept { return key; }
+};
+
+
+namespace Detail
+{
+
+using ControlByte = int8_t;
+
+// Full slots hold the low 7 bits of the hash, so they're never negative
+constexpr ControlByte s_controlEmpty{ -128 };
+constexpr ControlByte s_controlDeleted{ -2 };
+
+constexpr size_t s_flatGroupSize{ 16 };
+
+
+struct alignas(16) ControlGroup
+{
+	ControlByte bytes[s_flatGroupSize];
+
+	// Bitmask of the slots in the group whose control byte equals value
+	uint32_t Match(ControlByte value) const noexcept
+	{
+#if ENABLE_FLAT_HASH_SSE2
+		const __m128i group = _mm_load_si128(reinterpret_cast<const __m128i*>(bytes));
+		return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), group));
+#else
+		uint32_t mask = 0;
+		for (uint32_t i = 0; i < s_flatGroupSize; ++i)
+		{
+			mask |= (uint32_t)(bytes[i] == value) << i;
+		}
+		return mask;
+#endif
+	}
+
+	uint32_t MatchEmpty() const noexcept { return Match(s_controlEmpty); }
+
+	uint32_t MatchEmptyOrDeleted() const noexcept
+	{
+#if ENABLE_FLAT_HASH_SSE2
+		// Empty and deleted are the only control bytes below -1
+		const __m128i group = _mm_load_si128(reinterpret_cast<const __m128i*>(bytes));
+		return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), group));
+#else
+		uint32_t mask = 0;
+		for (uint32_t i = 0; i < s_flatGroupSize; ++i)
+		{
+			mask |= (uint32_t)(bytes[i] < -1) << i;
+		}
+		return mask;
+#endif
+	}
+};
+
+
+inline ControlByte HashToControl(size_t hash) noexcept { return (ControlByte)(hash & 0x7F); }
+inline size_t HashToGroup(size_t hash) noexcept { return hash >> 7; }
+
+
+template <typename Key, typename Value>
+struct FlatMapPolicy
+{
+	using SlotType = std::pair<Key, Value>;
+
+	static const Key& GetKey(const SlotType& slot) noexcept { return slot.first; }
+
+	template <typename K, typename... Args>
+	static void Construct(SlotType* slot, K&& key, Args&&... args)
+	{
+		new (slot) SlotType(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+};
+
+
+template <typename Key>
+struct FlatSetPolicy
+{
+	using SlotType = Key;
+
+	static const Key& GetKey(const SlotType& slot) noexcept { return slot; }
+
+	template <typename K>
+	static void Construct(SlotType* slot, K&& key)
+	{
+		new (slot) SlotType(std::forward<K>(key));
+	}
+};
+
+
+// Shared implementation of FlatHashMap and FlatHashSet.  Groups are probed quadratically; the
+// table grows at 7/8 load, so every probe sequence ends at a group with an empty slot.
+template <typename Key, typename Policy, typename Hash, typename KeyEqual>
+class FlatHashTable
+{
+public:
+	using key_type = Key;
+	using value_type = typename Policy::SlotType;
+	using size_type = size_t;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+
+	template <bool IsConst>
+	class Iterator
+	{
+		friend class FlatHashTable;
+		using TablePtr = std::conditional_t<IsConst, const FlatHashTable*, FlatHashTable*>;
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = typename Policy::SlotType;
+		using difference_type = ptrdiff_t;
+		using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+		using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+		Iterator() noexcept = default;
+		template <bool WasConst> requires (IsConst && !WasConst)
+		Iterator(const Iterator<WasConst>& other) noexcept
+			: m_table{ other.m_table }, m_index{ other.m_index } {}
+
+		reference operator*() const noexcept { return m_table->m_slots[m_index]; }
+		pointer operator->() const noexcept { return &m_table->m_slots[m_index]; }
+
+		Iterator& operator++() noexcept
+		{
+			m_index = m_table->NextFull(m_index + 1);
+			return *this;
+		}
+
+		Iterator operator++(int) noexcept
+		{
+			Iterator prev = *this;
+			++*this;
+			return prev;
+		}
+
+		bool operator==(const Iterator& other) const noexcept { return m_index == other.m_index; }
+
+	private:
+		Iterator(TablePtr table, size_t index) noexcept : m_table{ table }, m_index{ index } {}
+
+		friend class Iterator<!IsConst>;
+
+		TablePtr m_table{ nullptr };
+		size_t m_index{ 0 };
+	};
+
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	FlatHashTable() noexcept = default;
+
+	FlatHashTable(const FlatHashTable& other)
+	{
+		reserve(other.m_size);
+		for (const auto& slot : other)
+		{
+			const size_t hash = Hash{}(Policy::GetKey(slot));
+			const size_t index = PrepareInsert(hash);
+			new (&m_slots[index]) value_type(slot);
+			FinishInsert(index, hash);
+		}
+	}
+
+	FlatHashTable(FlatHashTable&& other) noexcept
+	{
+		Swap(other);
+	}
+
+	~FlatHashTable()
+	{
+		DestroySlots();
+	}
+
+	FlatHashTable& operator=(const FlatHashTable& other)
+	{
+		if (this != &other)
+		{
+			FlatHashTable copy{ other };
+			Swap(copy);
+		}
+		return *this;
+	}
+
+	FlatHashTable& operator=(FlatHashTable&& other) noexcept
+	{
+		if (this != &other)
+		{
+			FlatHashTable moved{ std::move(other) };
+			Swap(moved);
+		}
+		return *this;
+	}
+
+	iterator begin() noexcept { return iterator{ this, NextFull(0) }; }
+	iterator end() noexcept { return iterator{ this, m_capacity }; }
+	const_iterator begin() const noexcept { return const_iterator{ this, NextFull(0) }; }
+	const_iterator end() const noexcept { return const_iterator{ this, m_capacity }; }
+	const_iterator cbegin() const noexcept { return begin(); }
+	const_iterator cend() const noexcept { return end(); }
+
+	bool empty() const noexcept { return m_size == 0; }
+	size_t size() const noexcept { return m_size; }
+	size_t capacity() const noexcept { return m_capacity; }
+
+	iterator find(const Key& key) { return find(key, Hash{}(key)); }
+	const_iterator find(const Key& key) const { return find(key, Hash{}(key)); }
+
+	// Lookups with a hash the caller already computed.  It must equal Hash{}(key).
+	iterator find(const Key& key, size_t hash) { return iterator{ this, FindIndex(key, hash) }; }
+	const_iterator find(const Key& key, size_t hash) const { return const_iterator{ this, FindIndex(key, hash) }; }
+
+	bool contains(const Key& key) const { return FindIndex(key, Hash{}(key)) != m_capacity; }
+	bool contains(const Key& key, size_t hash) const { return FindIndex(key, hash) != m_capacity; }
+	size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+	size_t erase(const Key& key)
+	{
+		const size_t index = FindIndex(key, Hash{}(key));
+		if (index == m_capacity)
+		{
+			return 0;
+		}
+		EraseIndex(index);
+		return 1;
+	}
+
+	iterator erase(const_iterator it)
+	{
+		EraseIndex(it.m_index);
+		return iterator{ this, NextFull(it.m_index + 1) };
+	}
+
+	iterator erase(iterator it) { return erase(const_iterator{ it }); }
+
+	template <typename Predicate>
+	size_t erase_if(Predicate&& pred)
+	{
+		size_t numErased = 0;
+		for (size_t i = NextFull(0); i < m_capacity; i = NextFull(i + 1))
+		{
+			if (pred(m_slots[i]))
+			{
+				EraseIndex(i);
+				++numErased;
+			}
+		}
+		return numErased;
+	}
+
+	void clear() noexcept
+	{
+		if (m_size == 0 && m_deleted == 0)
+		{
+			return;
+		}
+
+		for (size_t i = NextFull(0); i < m_capacity; i = NextFull(i + 1))
+		{
+			m_slots[i].~value_type();
+		}
+
+		for (size_t i = 0; i < NumGroups(); ++i)
+		{
+			std::fill(std::begin(m_groups[i].bytes), std::end(m_groups[i].bytes), s_controlEmpty);
+		}
+		m_size = 0;
+		m_deleted = 0;
+	}
+
+	// Makes room for count entries without growing
+	void reserve(size_t count)
+	{
+		size_t capacity = s_flatGroupSize;
+		while (MaxLoad(capacity) < count)
+		{
+			capacity *= 2;
+		}
+
+		if (capacity > m_capacity)
+		{
+			Rehash(capacity);
+		}
+	}
+
+protected:
+	template <typename K, typename... Args>
+	std::pair<iterator, bool> EmplaceKey(size_t hash, K&& key, Args&&... args)
+	{
+		const size_t index = FindIndex(key, hash);
+		if (index != m_capacity)
+		{
+			return { iterator{ this, index }, false };
+		}
+		return { iterator{ this, InsertUnique(hash, std::forward<K>(key), std::forward<Args>(args)...) }, true };
+	}
+
+	value_type& SlotAt(const_iterator it) noexcept { return m_slots[it.m_index]; }
+
+private:
+	static constexpr size_t MaxLoad(size_t capacity) noexcept { return capacity - capacity / 8; }
+
+	size_t NumGroups() const noexcept { return m_capacity / s_flatGroupSize; }
+
+	bool IsFull(size_t index) const noexcept { return m_groups[index / s_flatGroupSize].bytes[index % s_flatGroupSize] >= 0; }
+
+	size_t NextFull(size_t index) const noexcept
+	{
+		while (index < m_capacity && !IsFull(index))
+		{
+			++index;
+		}
+		return index;
+	}
+
+	void SetControl(size_t index, ControlByte control) noexcept
+	{
+		m_groups[index / s_flatGroupSize].bytes[index % s_flatGroupSize] = control;
+	}
+
+	// Returns m_capacity if the key isn't present
+	size_t FindIndex(const Key& key, size_t hash) const
+	{
+		if (m_size == 0)
+		{
+			return m_capacity;
+		}
+
+		const ControlByte control = HashToControl(hash);
+		const size_t groupMask = NumGroups() - 1;
+		size_t group = HashToGroup(hash) & groupMask;
+
+		for (size_t probe = 1; ; ++probe)
+		{
+			const ControlGroup& controlGroup = m_groups[group];
+			for (uint32_t mask = controlGroup.Match(control); mask != 0; mask &= mask - 1)
+			{
+				const size_t index = group * s_flatGroupSize + std::countr_zero(mask);
+				if (KeyEqual{}(Policy::GetKey(m_slots[index]), key))
+				{
+					return index;
+				}
+			}
+
+			if (controlGroup.MatchEmpty() != 0)
+			{
+				return m_capacity;
+			}
+
+			group = (group + probe) & groupMask;
+		}
+	}
+
+	// First free slot on the key's probe sequence.  There's always one below the load limit.
+	size_t FindInsertIndex(size_t hash) const noexcept
+	{
+		const size_t groupMask = NumGroups() - 1;
+		size_t group = HashToGroup(hash) & groupMask;
+
+		for (size_t probe = 1; ; ++probe)
+		{
+			const uint32_t mask = m_groups[group].MatchEmptyOrDeleted();
+			if (mask != 0)
+			{
+				return group * s_flatGroupSize + std::countr_zero(mask);
+			}
+			group = (group + probe) & groupMask;
+		}
+	}
+
+	// Caller guarantees the key isn't already in the table
+	template <typename... Args>
+	size_t InsertUnique(size_t hash, Args&&... args)
+	{
+		const size_t index = PrepareInsert(hash);
+		Policy::Construct(&m_slots[index], std::forward<Args>(args)...);
+		FinishInsert(index, hash);
+		return index;
+	}
+
+	// Returns the slot to construct the new entry in, growing the table first if needed
+	size_t PrepareInsert(size_t hash)
+	{
+		if (m_size + m_deleted + 1 > MaxLoad(m_capacity))
+		{
+			// Grow if the table is really full, otherwise just clear out the tombstones
+			Rehash((m_capacity == 0) ? s_flatGroupSize : (m_size + 1 > MaxLoad(m_capacity) / 2) ? m_capacity * 2 : m_capacity);
+		}
+
+		const size_t index = FindInsertIndex(hash);
+		if (m_groups[index / s_flatGroupSize].bytes[index % s_flatGroupSize] == s_controlDeleted)
+		{
+			--m_deleted;
+		}
+		return index;
+	}
+
+	void FinishInsert(size_t index, size_t hash) noexcept
+	{
+		SetControl(index, HashToControl(hash));
+		++m_size;
+	}
+
+	void EraseIndex(size_t index) noexcept
+	{
+		m_slots[index].~value_type();
+		--m_size;
+
+		// Probes stop at groups with an empty slot, so a slot can only go back to empty if its group
+		// already has one.  Otherwise it's a tombstone, so probes continue past it.
+		const ControlGroup& group = m_groups[index / s_flatGroupSize];
+		if (group.MatchEmpty() != 0)
+		{
+			SetControl(index, s_controlEmpty);
+		}
+		else
+		{
+			SetControl(index, s_controlDeleted);
+			++m_deleted;
+		}
+	}
+
+	void Rehash(size_t newCapacity)
+	{
+		std::unique_ptr<ControlGroup[]> oldGroups = std::move(m_groups);
+		value_type* oldSlots = m_slots;
+		const size_t oldCapacity = m_capacity;
+
+		m_groups = std::make_unique<ControlGroup[]>(newCapacity / s_flatGroupSize);
+		m_slots = std::allocator<value_type>{}.allocate(newCapacity);
+		m_capacity = newCapacity;
+		m_size = 0;
+		m_deleted = 0;
+
+		for (size_t i = 0; i < NumGroups(); ++i)
+		{
+			std::fill(std::begin(m_groups[i].bytes), std::end(m_groups[i].bytes), s_controlEmpty);
+		}
+
+		for (size_t i = 0; i < oldCapacity; ++i)
+		{
+			if (oldGroups[i / s_flatGroupSize].bytes[i % s_flatGroupSize] < 0)
+			{
+				continue;
+			}
+
+			value_type& slot = oldSlots[i];
+			const size_t index = FindInsertIndex(Hash{}(Policy::GetKey(slot)));
+			new (&m_slots[index]) value_type(std::move(slot));
+			SetControl(index, HashToControl(Hash{}(Policy::GetKey(m_slots[index]))));
+			++m_size;
+			slot.~value_type();
+		}
+
+		if (oldSlots != nullptr)
+		{
+			std::allocator<value_type>{}.deallocate(oldSlots, oldCapacity);
+		}
+	}
+
+	void DestroySlots() noexcept
+	{
+		if (m_slots == nullptr)
+		{
+			return;
+		}
+
+		for (size_t i = NextFull(0); i < m_capacity; i = NextFull(i + 1))
+		{
+			m_slots[i].~value_type();
+		}
+		std::allocator<value_type>{}.deallocate(m_slots, m_capacity);
+		m_slots = nullptr;
+	}
+
+	void Swap(FlatHashTable& other) noexcept
+	{
+		std::swap(m_groups, other.m_groups);
+		std::swap(m_slots, other.m_slots);
+		std::swap(m_capacity, other.m_capacity);
+		std::swap(m_size, other.m_size);
+		std::swap(m_deleted, other.m_deleted);
+	}
+
+private:
+	std::unique_ptr<ControlGroup[]> m_groups;
+	value_type* m_slots{ nullptr };
+	size_t m_capacity{ 0 };
+	size_t m_size{ 0 };
+	size_t m_deleted{ 0 };
+};
+
+} // namespace Detail
+
+
+template <typename Key, typename Value, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap : public Detail::FlatHashTable<Key, Detail::FlatMapPolicy<Key, Value>, Hash, KeyEqual>
+{
+	using Base = Detail::FlatHashTable<Key, Detail::FlatMapPolicy<Key, Value>, Hash, KeyEqual>;
+
+public:
+	using mapped_type = Value;
+	using typename Base::iterator;
+	using typename Base::const_iterator;
+
+	using Base::find;
+
+	template <typename... Args>
+	std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+	{
+		return this->EmplaceKey(Hash{}(key), key, std::forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+	{
+		const size_t hash = Hash{}(key);
+		return this->EmplaceKey(hash, std::move(key), std::forward<Args>(args)...);
+	}
+
+	// Insert with a hash the caller already computed.  It must equal Hash{}(key).
+	template <typename K, typename... Args>
+	std::pair<iterator, bool> try_emplace_hashed(size_t hash, K&& key, Args&&... args)
+	{
+		return this->EmplaceKey(hash, std::forward<K>(key), std::forward<Args>(args)...);
+	}
+
+	template <typename K, typename V>
+	std::pair<iterator, bool> emplace(K&& key, V&& value)
+	{
+		return try_emplace(Key(std::forward<K>(key)), std::forward<V>(value));
+	}
+
+	std::pair<iterator, bool> insert(const std::pair<Key, Value>& entry)
+	{
+		return try_emplace(entry.first, entry.second);
+	}
+
+	template <typename V>
+	std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value)
+	{
+		auto result = try_emplace(key, std::forward<V>(value));
+		if (!result.second)
+		{
+			result.first->second = std::forward<V>(value);
+		}
+		return result;
+	}
+
+	Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+	Value& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+	Value& at(const Key& key)
+	{
+		auto it = find(key);
+		if (it == this->end())
+		{
+			throw std::out_of_range("FlatHashMap::at - key not found");
+		}
+		return it->second;
+	}
+
+	const Value& at(const Key& key) const
+	{
+		auto it = find(key);
+		if (it == this->end())
+		{
+			throw std::out_of_range("FlatHashMap::at - key not found");
+		}
+		return it->second;
+	}
+};
+
+
+template <typename Key, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashSet : public Detail::FlatHashTable<Key, Detail::FlatSetPolicy<Key>, Hash, KeyEqual>
+{
+	using Base = Detail::FlatHashTable<Key, Detail::FlatSetPolicy<Key>, Hash, KeyEqual>;
+
+public:
+	using typename Base::iterator;
+
+	FlatHashSet() noexcept = default;
+
+	FlatHashSet(std::initializer_list<Key> keys)
+	{
+		insert(keys.begin(), keys.end());
+	}
+
+	std::pair<iterator, bool> insert(const Key& key) { return this->EmplaceKey(Hash{}(key), key); }
+
+	std::pair<iterator, bool> insert(Key&& key)
+	{
+		const size_t hash = Hash{}(key);
+		return this->EmplaceKey(hash, std::move(key));
+	}
+
+	template <typename InputIt>
+	void insert(InputIt first, InputIt last)
+	{
+		for (; first != last; ++first)
+		{
+			insert(Key(*first));
+		}
+	}
+
+	template <typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		return insert(Key(std::forward<Args>(args)...));
+	}
+
+	// Insert with a hash the caller already computed.  It must equal Hash{}(key).
+	template <typename K>
+	std::pair<iterator, bool> insert_hashed(size_t hash, K&& key)
+	{
+		return this->EmplaceKey(hash, std::forward<K>(key));
+	}
+};
+
+
+// FlatHashMap split into independently locked shards, picked by the high bits of the hash, so
+// threads working on different keys rarely contend.  Lookups take a shared lock on one shard.
+// Entries move when a shard grows, so values are copied out, or visited under the shard lock.
+template <typename Key, typename Value, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<Key>, size_t NumShards = 16>
+class ConcurrentFlatHashMap : NonCopyable, NonMovable
+{
+	static_assert(std::has_single_bit(NumShards), "NumShards must be a power of 2");
+
+public:
+	bool find(const Key& key, Value& value) const { return find(key, Hash{}(key), value); }
+
+	bool find(const Key& key, size_t hash, Value& value) const
+	{
+		const Shard& shard = GetShard(hash);
+		std::shared_lock lock(shard.mutex);
+
+		auto it = shard.map.find(key, hash);
+		if (it == shard.map.end())
+		{
+			return false;
+		}
+		value = it->second;
+		return true;
+	}
+
+	bool contains(const Key& key) const
+	{
+		const size_t hash = Hash{}(key);
+		const Shard& shard = GetShard(hash);
+		std::shared_lock lock(shard.mutex);
+		return shard.map.contains(key, hash);
+	}
+
+	// Calls func(const Value&) under a shared lock if the key is present
+	template <typename Func>
+	bool visit(const Key& key, Func&& func) const
+	{
+		const size_t hash = Hash{}(key);
+		const Shard& shard = GetShard(hash);
+		std::shared_lock lock(shard.mutex);
+
+		auto it = shard.map.find(key, hash);
+		if (it == shard.map.end())
+		{
+			return false;
+		}
+		func(it->second);
+		return true;
+	}
+
+	// Calls func(Value&) under an exclusive lock if the key is present
+	template <typename Func>
+	bool visit(const Key& key, Func&& func)
+	{
+		const size_t hash = Hash{}(key);
+		Shard& shard = GetShard(hash);
+		std::lock_guard lock(shard.mutex);
+
+		auto it = shard.map.find(key, hash);
+		if (it == shard.map.end())
+		{
+			return false;
+		}
+		func(it->second);
+		return true;
+	}
+
+	// Returns false if the key was already present, leaving the existing value alone
+	template <typename V>
+	bool insert(const Key& key, V&& value)
+	{
+		const size_t hash = Hash{}(key);
+		Shard& shard = GetShard(hash);
+		std::lock_guard lock(shard.mutex);
+		return shard.map.try_emplace_hashed(hash, key, std::forward<V>(value)).second;
+	}
+
+	template <typename V>
+	void insert_or_assign(const Key& key, V&& value)
+	{
+		const size_t hash = Hash{}(key);
+		Shard& shard = GetShard(hash);
+		std::lock_guard lock(shard.mutex);
+
+		auto [it, inserted] = shard.map.try_emplace_hashed(hash, key, std::forward<V>(value));
+		if (!inserted)
+		{
+			it->second = std::forward<V>(value);
+		}
+	}
+
+	// Returns the existing value, or inserts the result of create().  create runs under the shard
+	// lock, so concurrent callers for the same key create exactly one value.
+	template <typename Func>
+	Value find_or_create(const Key& key, Func&& create)
+	{
+		const size_t hash = Hash{}(key);
+		Value value{};
+		if (find(key, hash, value))
+		{
+			return value;
+		}
+
+		Shard& shard = GetShard(hash);
+		std::lock_guard lock(shard.mutex);
+
+		auto it = shard.map.find(key, hash);
+		if (it == shard.map.end())
+		{
+			it = shard.map.try_emplace_hashed(hash, key, create()).first;
+		}
+		return it->second;
+	}
+
+	size_t erase(const Key& key)
+	{
+		Shard& shard = GetShard(Hash{}(key));
+		std::lock_guard lock(shard.mutex);
+		return shard.map.erase(key);
+	}
+
+	// pred(const std::pair<Key, Value>&) is called with each shard locked in turn
+	template <typename Predicate>
+	size_t erase_if(Predicate&& pred)
+	{
+		size_t numErased = 0;
+		for (auto& shard : m_shards)
+		{
+			std::lock_guard lock(shard.mutex);
+			numErased += shard.map.erase_if(pred);
+		}
+		return numErased;
+	}
+
+	void clear()
+	{
+		for (auto& shard : m_shards)
+		{
+			std::lock_guard lock(shard.mutex);
+			shard.map.clear();
+		}
+	}
+
+	// Only a snapshot if other threads are inserting
+	size_t size() const
+	{
+		size_t total = 0;
+		for (const auto& shard : m_shards)
+		{
+			std::shared_lock lock(shard.mutex);
+			total += shard.map.size();
+		}
+		return total;
+	}
+
+private:
+	// Padded to a cache line, so the locks of neighboring shards don't share one
+	struct alignas(64) Shard
+	{
+		mutable std::shared_mutex mutex;
+		FlatHashMap<Key, Value, Hash, KeyEqual> map;
+	};
+
+	// The tables index groups with the low bits, so shards use the top ones.  32-bit hashes (e.g.
+	// CRC32) leave the upper half of a 64-bit size_t empty, so fold it in first.
+	static size_t ShardIndex(size_t hash) noexcept
+	{
+		const uint32_t folded = (uint32_t)(hash ^ ((uint64_t)hash >> 32));
+		return (folded >> (32 - std::countr_zero(NumShards))) & (NumShards - 1);
+	}
+
+	Shard& GetShard(size_t hash) noexcept { return m_shards[ShardIndex(hash)]; }
+	const Shard& GetShard(size_t hash) const noexcept { return m_shards[ShardIndex(hash)]; }
+
+private:
+	std::array<Shard, NumShards> m_shards;
+};
+
+} // namespace Kodiak
@@ -0,0 +1,177 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "FrameArena.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr size_t s_blockAlignment{ 64 };
+
+atomic<uint64_t> g_arenaHeapAllocations{ 0 };
+atomic<uint64_t> g_frameNumber{ 0 };
+
+
+struct ThreadFrameArenas
+{
+	LinearArena arenas[2];
+	ArenaResource resources[2]{ ArenaResource{ arenas[0] }, ArenaResource{ arenas[1] } };
+	uint64_t frameNumbers[2]{ 0, 0 };
+
+	// Set by SetThreadFrameNumber
+	bool hasOwnFrameNumber{ false };
+	uint64_t ownFrameNumber{ 0 };
+};
+
+thread_local ThreadFrameArenas t_frameArenas;
+
+
+uint32_t GetCurrentFrameArenaIndex()
+{
+	const uint64_t frameNumber = t_frameArenas.hasOwnFrameNumber
+		? t_frameArenas.ownFrameNumber
+		: g_frameNumber.load(memory_order_acquire);
+	const uint32_t index = (uint32_t)(frameNumber & 1);
+
+	// Last used two frames ago, which the frame graph has finished with
+	if (t_frameArenas.frameNumbers[index] != frameNumber)
+	{
+		t_frameArenas.arenas[index].Reset();
+		t_frameArenas.frameNumbers[index] = frameNumber;
+	}
+
+	return index;
+}
+
+} // anonymous namespace
+
+
+LinearArena::LinearArena(size_t initialBlockSize)
+	: m_initialBlockSize{ std::max(initialBlockSize, s_blockAlignment) }
+{}
+
+
+LinearArena::~LinearArena()
+{
+	FreeBlocks();
+}
+
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0);
+
+	size = std::max<size_t>(size, 1);
+
+	if (!m_blocks.empty())
+	{
+		Block& block = m_blocks[m_currentBlock];
+		const size_t alignedOffset = Math::AlignUp((size_t)block.data + m_offset, alignment) - (size_t)block.data;
+		if (alignedOffset + size <= block.size)
+		{
+			m_offset = alignedOffset + size;
+			m_bytesUsed += size;
+			return block.data + alignedOffset;
+		}
+	}
+
+	// Blocks are aligned to s_blockAlignment, anything stricter needs the slack
+	AddBlock(size + (alignment > s_blockAlignment ? alignment : 0));
+
+	Block& block = m_blocks[m_currentBlock];
+	const size_t alignedOffset = Math::AlignUp((size_t)block.data, alignment) - (size_t)block.data;
+	m_offset = alignedOffset + size;
+	m_bytesUsed += size;
+	return block.data + alignedOffset;
+}
+
+
+void LinearArena::Reset()
+{
+	if (m_blocks.size() > 1)
+	{
+		const size_t capacity = m_capacity;
+		FreeBlocks();
+		AddBlock(capacity);
+	}
+
+	m_currentBlock = 0;
+	m_offset = 0;
+	m_bytesUsed = 0;
+}
+
+
+void LinearArena::AddBlock(size_t minSize)
+{
+	const size_t growSize = m_blocks.empty() ? m_initialBlockSize : m_blocks.back().size * 2;
+	const size_t size = Math::AlignUp(std::max(minSize, growSize), s_blockAlignment);
+
+	Block block{};
+	block.data = static_cast<byte*>(::operator new(size, align_val_t{ s_blockAlignment }));
+	block.size = size;
+
+	m_blocks.push_back(block);
+	m_currentBlock = m_blocks.size() - 1;
+	m_offset = 0;
+	m_capacity += size;
+
+	g_arenaHeapAllocations.fetch_add(1, memory_order_relaxed);
+}
+
+
+void LinearArena::FreeBlocks()
+{
+	for (auto& block : m_blocks)
+	{
+		::operator delete(block.data, align_val_t{ s_blockAlignment });
+	}
+	m_blocks.clear();
+	m_currentBlock = 0;
+	m_offset = 0;
+	m_capacity = 0;
+}
+
+
+LinearArena& Kodiak::GetFrameArena()
+{
+	return t_frameArenas.arenas[GetCurrentFrameArenaIndex()];
+}
+
+
+pmr::memory_resource* Kodiak::GetFrameResource()
+{
+	return &t_frameArenas.resources[GetCurrentFrameArenaIndex()];
+}
+
+
+void Kodiak::AdvanceFrameArenas(uint64_t frameNumber)
+{
+	g_frameNumber.store(frameNumber, memory_order_release);
+}
+
+
+void Kodiak::SetThreadFrameNumber(uint64_t frameNumber)
+{
+	t_frameArenas.hasOwnFrameNumber = true;
+	t_frameArenas.ownFrameNumber = frameNumber;
+}
+
+
+uint64_t Kodiak::GetArenaHeapAllocations()
+{
+	return g_arenaHeapAllocations.load(memory_order_relaxed);
+}
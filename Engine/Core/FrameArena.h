@@ -0,0 +1,108 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <memory_resource>
+
+namespace Kodiak
+{
+
+// Bump allocator, freed all at once by Reset.  Destructors are never run, so only put trivially
+// destructible objects (or containers using an ArenaResource) in it.  Not thread safe.
+class LinearArena : NonCopyable, NonMovable
+{
+public:
+	explicit LinearArena(size_t initialBlockSize = 64 * 1024);
+	~LinearArena();
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template <typename T>
+	std::span<T> AllocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>);
+		T* data = static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+		std::uninitialized_value_construct_n(data, count);
+		return { data, count };
+	}
+
+	template <typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible_v<T>);
+		return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	// Frees everything.  An arena that needed more than one block replaces them with a single
+	// block of the combined size, so a steady workload stops touching the heap.
+	void Reset();
+
+	size_t GetBytesUsed() const noexcept { return m_bytesUsed; }
+	size_t GetCapacity() const noexcept { return m_capacity; }
+
+private:
+	struct Block
+	{
+		std::byte* data{ nullptr };
+		size_t size{ 0 };
+	};
+
+	void AddBlock(size_t minSize);
+	void FreeBlocks();
+
+private:
+	std::vector<Block> m_blocks;
+	size_t m_currentBlock{ 0 };
+	size_t m_offset{ 0 };
+	size_t m_initialBlockSize{ 0 };
+	size_t m_bytesUsed{ 0 };
+	size_t m_capacity{ 0 };
+};
+
+
+// Lets std::pmr containers allocate from a LinearArena.  Deallocation does nothing, the memory
+// comes back when the arena is reset.
+class ArenaResource : public std::pmr::memory_resource
+{
+public:
+	explicit ArenaResource(LinearArena& arena) noexcept : m_arena{ arena } {}
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) final { return m_arena.Allocate(bytes, alignment); }
+	void do_deallocate(void* p, size_t bytes, size_t alignment) final {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept final { return this == &other; }
+
+private:
+	LinearArena& m_arena;
+};
+
+
+// Each thread has a pair of frame arenas, used for alternate frames.  Memory from the calling
+// thread's frame arena stays valid until the end of the next frame, which is as far as the frame
+// graph lets frames overlap, and is then reused without being freed.  Containers using the frame
+// resource must only grow on the thread that created them, and must not outlive the next frame.
+LinearArena& GetFrameArena();
+std::pmr::memory_resource* GetFrameResource();
+
+// Starts a new frame for every thread's frame arenas.  Each thread resets its arena lazily, on
+// its first allocation in the new frame.  The application's frame graph calls this from Kick.
+void AdvanceFrameArenas(uint64_t frameNumber);
+
+// For a thread running its own frame loop behind the frame graph, like the render thread.  Its
+// frame arenas follow the frame numbers passed here instead.
+void SetThreadFrameNumber(uint64_t frameNumber);
+
+// Blocks taken from the heap by every LinearArena, frame arenas included.  Stops rising once
+// each arena has grown to fit its frame.  Only the arenas' own growth, the rest of the heap is
+// checked frame by frame with ENABLE_ALLOCATION_TRACKING (see GetAllocationTotals).
+uint64_t GetArenaHeapAllocations();
+
+} // namespace Kodiak
@@ -11,10 +11,55 @@
 
 #include "Hash.h"
 
+#if ENABLE_ARM64_CRC32 && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+
+namespace
+{
+
+bool CpuHasCrc32()
+{
+#if ENABLE_X64_CRC32 && defined(_MSC_VER) && !defined(__clang__)
+	int cpuInfo[4]{};
+	__cpuid(cpuInfo, 1);
+	return (cpuInfo[2] & (1 << 20)) != 0;
+#elif ENABLE_X64_CRC32
+	return __builtin_cpu_supports("sse4.2");
+#elif ENABLE_ARM64_CRC32 && defined(_WIN32)
+	return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != FALSE;
+#elif ENABLE_ARM64_CRC32 && defined(__linux__)
+	return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#elif ENABLE_ARM64_CRC32 && defined(__ARM_FEATURE_CRC32)
+	return true;
+#else
+	return false;
+#endif
+}
+
+} // anonymous namespace
+
 
 namespace Utility
 {
 
 const size_t g_hashStart = 2166136261U;
 
+namespace Detail
+{
+
+constinit std::atomic<uint8_t> g_hardwareCrc32State{ 0 };
+
+// Threads racing here all store the same answer
+bool DetectHardwareCrc32() noexcept
+{
+	const bool hasCrc32 = CpuHasCrc32();
+	g_hardwareCrc32State.store(hasCrc32 ? 2 : 1, std::memory_order_relaxed);
+	return hasCrc32;
+}
+
+} // namespace Detail
+
 } // namespace Utility
\ No newline at end of file
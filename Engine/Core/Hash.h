@@ -14,52 +14,222 @@
 
 #include "Math\CommonMath.h"
 
-// This requires SSE4.2 which is present on Intel Nehalem (Nov. 2008)
-// and AMD Bulldozer (Oct. 2011) processors.  I could put a runtime
-// check for this, but I'm just going to assume people playing with
-// DirectX 12 on Windows 10 have fairly recent machines.
-#ifdef _M_X64
-#define ENABLE_SSE_CRC32 1
+// HashRange uses the hardware CRC32C instruction when the CPU has one (SSE4.2 on x64, the CRC
+// extension on ARMv8), and a 64-bit multiply-mix hash otherwise.  Support is detected once at
+// startup, not at compile time, so GCC and Clang builds get the fast path too.  Both CRC paths
+// produce identical hashes, the fallback does not.  Record GetHashKind() next to any hash that
+// is persisted.
+#if defined(_M_X64) || defined(__x86_64__)
+#define ENABLE_X64_CRC32 1
 #else
-#define ENABLE_SSE_CRC32 0
+#define ENABLE_X64_CRC32 0
 #endif
 
-#if ENABLE_SSE_CRC32
-#pragma intrinsic(_mm_crc32_u32)
-#pragma intrinsic(_mm_crc32_u64)
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define ENABLE_ARM64_CRC32 1
+#else
+#define ENABLE_ARM64_CRC32 0
+#endif
+
+#define ENABLE_HARDWARE_CRC32 (ENABLE_X64_CRC32 || ENABLE_ARM64_CRC32)
+
+// GCC and Clang only allow CRC intrinsics in functions compiled for the extension
+#if defined(_MSC_VER) && !defined(__clang__)
+#define HASH_TARGET_CRC32
+#elif ENABLE_X64_CRC32
+#define HASH_TARGET_CRC32 __attribute__((target("sse4.2")))
+#else
+#define HASH_TARGET_CRC32 __attribute__((target("crc")))
+#endif
+
+#if ENABLE_X64_CRC32
+#include <nmmintrin.h>
+#elif ENABLE_ARM64_CRC32 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#elif ENABLE_ARM64_CRC32
+#include <arm_acle.h>
 #endif
 
 namespace Utility
 {
 
+enum class HashKind : uint32_t
+{
+	Crc32c,
+	MultiplyMix
+};
+
 extern const size_t g_hashStart;
 
-inline size_t HashRange(const uint32_t* const Begin, const uint32_t* const End, size_t Hash)
+namespace Detail
+{
+
+// 0 until detected, then 1 without hardware CRC32C and 2 with it.  Constant-initialized, so a hash
+// taken during static initialization (interned names) detects first instead of reading an unset
+// flag and hashing differently from everything after it.
+extern constinit std::atomic<uint8_t> g_hardwareCrc32State;
+bool DetectHardwareCrc32() noexcept;
+
+} // namespace Detail
+
+inline bool HasHardwareCrc32() noexcept
+{
+	const uint8_t state = Detail::g_hardwareCrc32State.load(std::memory_order_relaxed);
+	return (state != 0) ? (state == 2) : Detail::DetectHardwareCrc32();
+}
+
+inline HashKind GetHashKind() noexcept
+{
+	return HasHardwareCrc32() ? HashKind::Crc32c : HashKind::MultiplyMix;
+}
+
+namespace Detail
+{
+
+#if ENABLE_HARDWARE_CRC32
+HASH_TARGET_CRC32 inline size_t Crc32U8(size_t Hash, uint8_t Value)
+{
+#if ENABLE_X64_CRC32
+	return _mm_crc32_u8((uint32_t)Hash, Value);
+#else
+	return __crc32cb((uint32_t)Hash, Value);
+#endif
+}
+
+
+HASH_TARGET_CRC32 inline size_t Crc32U32(size_t Hash, uint32_t Value)
+{
+#if ENABLE_X64_CRC32
+	return _mm_crc32_u32((uint32_t)Hash, Value);
+#else
+	return __crc32cw((uint32_t)Hash, Value);
+#endif
+}
+
+
+HASH_TARGET_CRC32 inline size_t Crc32U64(size_t Hash, uint64_t Value)
+{
+#if ENABLE_X64_CRC32
+	return (size_t)_mm_crc32_u64((uint64_t)Hash, Value);
+#else
+	return __crc32cd((uint32_t)Hash, Value);
+#endif
+}
+
+
+HASH_TARGET_CRC32 inline size_t HashRangeCrc32(const uint32_t* const Begin, const uint32_t* const End, size_t Hash)
 {
-#if ENABLE_SSE_CRC32
 	const uint64_t* Iter64 = (const uint64_t*)Math::AlignUp(Begin, 8);
 	const uint64_t* const End64 = (const uint64_t* const)Math::AlignDown(End, 8);
 
 	// If not 64-bit aligned, start with a single u32
-	if ((uint32_t*)Iter64 > Begin)
-		Hash = _mm_crc32_u32((uint32_t)Hash, *Begin);
+	if ((uint32_t*)Iter64 > Begin && Begin < End)
+		Hash = Crc32U32(Hash, *Begin);
 
 	// Iterate over consecutive u64 values
 	while (Iter64 < End64)
-		Hash = _mm_crc32_u64((uint64_t)Hash, *Iter64++);
+		Hash = Crc32U64(Hash, *Iter64++);
 
 	// If there is a 32-bit remainder, accumulate that
 	if ((uint32_t*)Iter64 < End)
-		Hash = _mm_crc32_u32((uint32_t)Hash, *(uint32_t*)Iter64);
-#else
-	// An inexpensive hash for CPUs lacking SSE4.2
-	for (const uint32_t* Iter = Begin; Iter < End; ++Iter)
-		Hash = 16777619U * Hash ^ *Iter;
-#endif
+		Hash = Crc32U32(Hash, *(uint32_t*)Iter64);
 
 	return Hash;
 }
 
+
+HASH_TARGET_CRC32 inline size_t HashBytesCrc32(const uint8_t* Iter, const uint8_t* const End, size_t Hash)
+{
+	for (; End - Iter >= 8; Iter += 8)
+	{
+		uint64_t Value;
+		memcpy(&Value, Iter, sizeof(Value));
+		Hash = Crc32U64(Hash, Value);
+	}
+
+	for (; Iter < End; ++Iter)
+		Hash = Crc32U8(Hash, *Iter);
+
+	return Hash;
+}
+#endif // ENABLE_HARDWARE_CRC32
+
+
+// Fallback for CPUs without CRC instructions.  Mixes a 64-bit word per multiply, rather than the
+// 32-bit FNV-style step this replaced, which was far slower and collided on similar inputs.
+inline uint64_t MixWord(uint64_t Hash, uint64_t Value)
+{
+	Hash = (Hash ^ Value) * 0x9E3779B97F4A7C15ull;
+	return Hash ^ (Hash >> 32);
+}
+
+
+inline size_t HashRangeMix(const uint32_t* Iter, const uint32_t* const End, size_t Hash)
+{
+	for (; End - Iter >= 2; Iter += 2)
+	{
+		uint64_t Value;
+		memcpy(&Value, Iter, sizeof(Value));
+		Hash = (size_t)MixWord(Hash, Value);
+	}
+
+	if (Iter < End)
+		Hash = (size_t)MixWord(Hash, *Iter);
+
+	return Hash;
+}
+
+
+inline size_t HashBytesMix(const uint8_t* Iter, const uint8_t* const End, size_t Hash)
+{
+	for (; End - Iter >= 8; Iter += 8)
+	{
+		uint64_t Value;
+		memcpy(&Value, Iter, sizeof(Value));
+		Hash = (size_t)MixWord(Hash, Value);
+	}
+
+	if (Iter < End)
+	{
+		// Length goes in the top byte, so trailing zeros still change the hash
+		uint64_t Value = (uint64_t)(End - Iter) << 56;
+		memcpy(&Value, Iter, (size_t)(End - Iter));
+		Hash = (size_t)MixWord(Hash, Value);
+	}
+
+	return Hash;
+}
+
+} // namespace Detail
+
+
+inline size_t HashRange(const uint32_t* const Begin, const uint32_t* const End, size_t Hash)
+{
+#if ENABLE_HARDWARE_CRC32
+	if (HasHardwareCrc32())
+		return Detail::HashRangeCrc32(Begin, End, Hash);
+#endif
+
+	return Detail::HashRangeMix(Begin, End, Hash);
+}
+
+
+// For data with no alignment or size guarantees, such as strings.  Doesn't match the word
+// overload on the same bytes.
+inline size_t HashRange(std::span<const std::byte> Bytes, size_t Hash = g_hashStart)
+{
+	const uint8_t* Begin = (const uint8_t*)Bytes.data();
+	const uint8_t* End = Begin + Bytes.size();
+
+#if ENABLE_HARDWARE_CRC32
+	if (HasHardwareCrc32())
+		return Detail::HashBytesCrc32(Begin, End, Hash);
+#endif
+
+	return Detail::HashBytesMix(Begin, End, Hash);
+}
+
+
 template <typename T> inline size_t HashState(const T* StateDesc, size_t Count = 1, size_t Hash = 2166136261U)
 {
 	static_assert((sizeof(T) & 3) == 0 && alignof(T) >= 4, "State object is not word-aligned");
@@ -0,0 +1,93 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "IObjectRegistry.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+struct Registry
+{
+	mutex registryMutex;
+	vector<unique_ptr<Detail::IObjectTypeEntry>> entries;
+};
+
+
+// Never destroyed, objects can outlive static destructors
+Registry& GetRegistry()
+{
+	static Registry* s_registry = new Registry;
+	return *s_registry;
+}
+
+
+// typeid names are "class Kodiak::VK::CVkImage" with MSVC
+string_view StripTypeKeyword(string_view typeName)
+{
+	for (string_view keyword : { "class ", "struct " })
+	{
+		if (typeName.starts_with(keyword))
+		{
+			return typeName.substr(keyword.size());
+		}
+	}
+	return typeName;
+}
+
+} // anonymous namespace
+
+
+Detail::IObjectTypeEntry& Detail::RegisterIObjectType(const char* typeName, size_t typeSize)
+{
+	Registry& registry = GetRegistry();
+
+	lock_guard<mutex> lock(registry.registryMutex);
+
+	auto entry = make_unique<IObjectTypeEntry>();
+	entry->typeName = typeName;
+	entry->typeSize = typeSize;
+	registry.entries.push_back(move(entry));
+
+	return *registry.entries.back();
+}
+
+
+vector<IObjectTypeStats> Kodiak::GetIObjectStats()
+{
+	vector<IObjectTypeStats> stats;
+
+	{
+		Registry& registry = GetRegistry();
+
+		lock_guard<mutex> lock(registry.registryMutex);
+
+		stats.reserve(registry.entries.size());
+		for (const auto& entry : registry.entries)
+		{
+			const uint64_t numLive = entry->numLive.load(memory_order_relaxed);
+			stats.push_back({
+				string{ StripTypeKeyword(entry->typeName) },
+				numLive,
+				numLive * entry->typeSize,
+				entry->numCreated.load(memory_order_relaxed) });
+		}
+	}
+
+	sort(stats.begin(), stats.end(), [](const auto& a, const auto& b) { return a.numLiveBytes > b.numLiveBytes; });
+
+	return stats;
+}
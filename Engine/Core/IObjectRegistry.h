@@ -0,0 +1,101 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <typeinfo>
+
+// Live IObject counts by type, for finding leaked objects and reference cycles.  With
+// ENABLE_IOBJECT_REGISTRY set (see Stdafx.h), IMPLEMENT_IOBJECT gives each object a member that
+// counts it in and out of its type's entry.  The type is the class that uses IMPLEMENT_IOBJECT,
+// classes derived from it are counted with it.
+
+namespace Kodiak
+{
+
+struct IObjectTypeStats
+{
+	std::string typeName;
+	uint64_t numLive{ 0 };
+	uint64_t numLiveBytes{ 0 };
+	uint64_t numCreated{ 0 };
+};
+
+
+namespace Detail
+{
+
+struct IObjectTypeEntry
+{
+	const char* typeName{ nullptr };
+	size_t typeSize{ 0 };
+	std::atomic<uint64_t> numLive{ 0 };
+	std::atomic<uint64_t> numCreated{ 0 };
+};
+
+IObjectTypeEntry& RegisterIObjectType(const char* typeName, size_t typeSize);
+
+template <typename T>
+IObjectTypeEntry& GetIObjectTypeEntry()
+{
+	static IObjectTypeEntry& s_entry = RegisterIObjectType(typeid(T).name(), sizeof(T));
+	return s_entry;
+}
+
+} // namespace Detail
+
+
+class IObjectRegistration
+{
+public:
+	explicit IObjectRegistration(Detail::IObjectTypeEntry& entry) noexcept
+		: m_entry{ &entry }
+	{
+		Add();
+	}
+
+	IObjectRegistration(const IObjectRegistration& other) noexcept
+		: m_entry{ other.m_entry }
+	{
+		Add();
+	}
+
+	IObjectRegistration& operator=(const IObjectRegistration&) noexcept { return *this; }
+
+	~IObjectRegistration()
+	{
+		m_entry->numLive.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+private:
+	void Add() noexcept
+	{
+		m_entry->numLive.fetch_add(1, std::memory_order_relaxed);
+		m_entry->numCreated.fetch_add(1, std::memory_order_relaxed);
+	}
+
+private:
+	Detail::IObjectTypeEntry* m_entry{ nullptr };
+};
+
+
+#if ENABLE_IOBJECT_REGISTRY
+#define IMPLEMENT_IOBJECT_REGISTRATION \
+private: \
+	Kodiak::IObjectRegistration m_objectRegistration{ Kodiak::Detail::GetIObjectTypeEntry<std::remove_cvref_t<decltype(*this)>>() };
+#else
+#define IMPLEMENT_IOBJECT_REGISTRATION
+#endif
+
+
+// Every type that has had an object, most live bytes first.  Empty without ENABLE_IOBJECT_REGISTRY.
+std::vector<IObjectTypeStats> GetIObjectStats();
+
+} // namespace Kodiak
@@ -10,6 +10,9 @@
 
 #pragma once
 
+#include "IObjectRegistry.h"
+#include "SlabAllocator.h"
+
 
 namespace Kodiak
 {
@@ -21,6 +24,9 @@ public:
 	using InterfaceType = T;
 
 protected:
+	template <typename U>
+	friend class IntrusivePtr;
+
 	InterfaceType* m_ptr{ nullptr };
 
 	void InternalAddRef() const noexcept
@@ -67,7 +73,7 @@ public:
 
 
 	template <class U>
-	IntrusivePtr(const IntrusivePtr<U>& other, typename std::enable_if<std::is_convertible<U*, T*>::chrono_literals, void*>::type* = nullptr) noexcept
+	IntrusivePtr(const IntrusivePtr<U>& other, typename std::enable_if<std::is_convertible<U*, T*>::value, void*>::type* = nullptr) noexcept
 		: m_ptr{ other.m_ptr }
 	{
 		InternalAddRef();
@@ -75,12 +81,9 @@ public:
 
 
 	IntrusivePtr(IntrusivePtr&& other) noexcept
-		: m_ptr{ nullptr }
+		: m_ptr{ other.m_ptr }
 	{
-		if (this != reinterpret_cast<IntrusivePtr*>(&reinterpret_cast<unsigned char&>(other)))
-		{
-			Swap(other);
-		}
+		other.m_ptr = nullptr;
 	}
 
 
@@ -152,6 +155,7 @@ public:
 	IntrusivePtr& operator=(IntrusivePtr<U>&& other) noexcept
 	{
 		IntrusivePtr(static_cast<IntrusivePtr<U>&&>(other)).Swap(*this);
+		return *this;
 	}
 
 
@@ -251,23 +255,51 @@ public:
 };
 
 
+// Reference counting for an IObject.  The object is allocated from the slab allocator, so
+// creating and destroying the small wrapper objects doesn't go through the global heap.
+// AddRef only needs to be atomic, the caller already holds a reference.  Release is acquire-release
+// so the thread that drops the last reference sees every other thread's writes before deleting.
 #define IMPLEMENT_IOBJECT \
+	IMPLEMENT_SLAB_ALLOCATION \
+	IMPLEMENT_IOBJECT_REGISTRATION \
 private: \
 	std::atomic_ulong m_refCount = 1; \
 public: \
 	unsigned long AddRef() noexcept final \
 	{ \
-		++m_refCount; \
-		return m_refCount; \
+		return m_refCount.fetch_add(1, std::memory_order_relaxed) + 1; \
+	} \
+	unsigned long Release() noexcept final \
+	{ \
+		const unsigned long refCount = m_refCount.fetch_sub(1, std::memory_order_acq_rel) - 1; \
+		if (0 == refCount) \
+		{ \
+			delete this; \
+		} \
+		return refCount; \
+	}
+
+
+// For objects whose references are only ever taken and dropped on one thread at a time, like
+// an object owned by a single parent.  Plain integer reference count, no atomics.
+#define IMPLEMENT_IOBJECT_SINGLE_THREADED \
+	IMPLEMENT_SLAB_ALLOCATION \
+	IMPLEMENT_IOBJECT_REGISTRATION \
+private: \
+	unsigned long m_refCount = 1; \
+public: \
+	unsigned long AddRef() noexcept final \
+	{ \
+		return ++m_refCount; \
 	} \
 	unsigned long Release() noexcept final \
 	{ \
-		unsigned long ulRefCount = --m_refCount; \
-		if (0 == m_refCount) \
+		const unsigned long refCount = --m_refCount; \
+		if (0 == refCount) \
 		{ \
 			delete this; \
 		} \
-		return ulRefCount; \
+		return refCount; \
 	}
 
 } // namespace Kodiak
\ No newline at end of file
@@ -0,0 +1,334 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <bit>
+
+// Bounded lock-free queues.  The capacity is fixed at construction and rounded up to a power of
+// two.  Pushing to a full queue or popping an empty one fails instead of waiting, so callers
+// decide whether to retry, drop or block.  The read and write indices sit on their own cache
+// lines.  The batch calls move as many values as fit, from the front of the span, and return
+// how many that was.
+
+namespace Kodiak
+{
+
+// One producer thread, one consumer thread.  Each side keeps a copy of the other side's index
+// and only reloads it when the queue looks full (or empty), so most calls touch no shared
+// cache line but the slots themselves.
+template <typename T>
+class SpscRingBuffer : NonCopyable, NonMovable
+{
+	static_assert(std::is_nothrow_move_constructible_v<T>);
+
+public:
+	explicit SpscRingBuffer(size_t capacity)
+		: m_capacity{ std::bit_ceil(std::max<size_t>(capacity, 2)) }
+		, m_mask{ m_capacity - 1 }
+		, m_slots{ std::allocator<T>{}.allocate(m_capacity) }
+	{}
+
+	~SpscRingBuffer()
+	{
+		for (size_t index = m_readIndex.load(std::memory_order_relaxed); index != m_writeIndex.load(std::memory_order_relaxed); ++index)
+		{
+			std::destroy_at(&m_slots[index & m_mask]);
+		}
+		std::allocator<T>{}.deallocate(m_slots, m_capacity);
+	}
+
+	// Producer only
+	template <typename... Args>
+	bool TryEmplace(Args&&... args)
+	{
+		const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+		if (writeIndex - m_cachedReadIndex == m_capacity)
+		{
+			m_cachedReadIndex = m_readIndex.load(std::memory_order_acquire);
+			if (writeIndex - m_cachedReadIndex == m_capacity)
+			{
+				return false;
+			}
+		}
+
+		std::construct_at(&m_slots[writeIndex & m_mask], std::forward<Args>(args)...);
+		m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPush(const T& value) { return TryEmplace(value); }
+	bool TryPush(T&& value) { return TryEmplace(std::move(value)); }
+
+	// Producer only
+	size_t TryPushBatch(std::span<T> values)
+	{
+		const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+		if (m_capacity - (writeIndex - m_cachedReadIndex) < values.size())
+		{
+			m_cachedReadIndex = m_readIndex.load(std::memory_order_acquire);
+		}
+
+		const size_t count = std::min(values.size(), m_capacity - (writeIndex - m_cachedReadIndex));
+		for (size_t i = 0; i < count; ++i)
+		{
+			std::construct_at(&m_slots[(writeIndex + i) & m_mask], std::move(values[i]));
+		}
+		m_writeIndex.store(writeIndex + count, std::memory_order_release);
+		return count;
+	}
+
+	// Consumer only
+	bool TryPop(T& value)
+	{
+		const size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+		if (readIndex == m_cachedWriteIndex)
+		{
+			m_cachedWriteIndex = m_writeIndex.load(std::memory_order_acquire);
+			if (readIndex == m_cachedWriteIndex)
+			{
+				return false;
+			}
+		}
+
+		T& slot = m_slots[readIndex & m_mask];
+		value = std::move(slot);
+		std::destroy_at(&slot);
+		m_readIndex.store(readIndex + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only
+	size_t TryPopBatch(std::span<T> values)
+	{
+		const size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+		if (m_cachedWriteIndex - readIndex < values.size())
+		{
+			m_cachedWriteIndex = m_writeIndex.load(std::memory_order_acquire);
+		}
+
+		const size_t count = std::min(values.size(), m_cachedWriteIndex - readIndex);
+		for (size_t i = 0; i < count; ++i)
+		{
+			T& slot = m_slots[(readIndex + i) & m_mask];
+			values[i] = std::move(slot);
+			std::destroy_at(&slot);
+		}
+		m_readIndex.store(readIndex + count, std::memory_order_release);
+		return count;
+	}
+
+	// Exact from the consumer, a hint anywhere else
+	bool IsEmpty() const noexcept
+	{
+		return m_readIndex.load(std::memory_order_acquire) == m_writeIndex.load(std::memory_order_acquire);
+	}
+
+	size_t GetCapacity() const noexcept { return m_capacity; }
+
+private:
+	const size_t m_capacity{ 0 };
+	const size_t m_mask{ 0 };
+	T* const m_slots{ nullptr };
+
+	// Producer's cache line
+	alignas(64) std::atomic<size_t> m_writeIndex{ 0 };
+	size_t m_cachedReadIndex{ 0 };
+
+	// Consumer's cache line
+	alignas(64) std::atomic<size_t> m_readIndex{ 0 };
+	size_t m_cachedWriteIndex{ 0 };
+};
+
+
+// Any number of producer and consumer threads (Vyukov's bounded queue).  Each slot has a sequence
+// number that says whether it's ready to be written or read on the current lap, so producers and
+// consumers only contend on their own index, with one compare-exchange per call (or per batch).
+template <typename T>
+class MpmcRingBuffer : NonCopyable, NonMovable
+{
+	static_assert(std::is_nothrow_move_constructible_v<T>);
+
+public:
+	explicit MpmcRingBuffer(size_t capacity)
+		: m_capacity{ std::bit_ceil(std::max<size_t>(capacity, 2)) }
+		, m_mask{ m_capacity - 1 }
+		, m_slots{ std::make_unique<Slot[]>(m_capacity) }
+	{
+		for (size_t i = 0; i < m_capacity; ++i)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~MpmcRingBuffer()
+	{
+		for (size_t index = m_readIndex.load(std::memory_order_relaxed); index != m_writeIndex.load(std::memory_order_relaxed); ++index)
+		{
+			std::destroy_at(m_slots[index & m_mask].GetValue());
+		}
+	}
+
+	template <typename... Args>
+	bool TryEmplace(Args&&... args)
+	{
+		size_t writeIndex = 0;
+		if (ClaimWrite(1, writeIndex) == 0)
+		{
+			return false;
+		}
+
+		Slot& slot = m_slots[writeIndex & m_mask];
+		std::construct_at(slot.GetValue(), std::forward<Args>(args)...);
+		slot.sequence.store(writeIndex + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPush(const T& value) { return TryEmplace(value); }
+	bool TryPush(T&& value) { return TryEmplace(std::move(value)); }
+
+	size_t TryPushBatch(std::span<T> values)
+	{
+		size_t writeIndex = 0;
+		const size_t count = ClaimWrite(values.size(), writeIndex);
+		for (size_t i = 0; i < count; ++i)
+		{
+			Slot& slot = m_slots[(writeIndex + i) & m_mask];
+			std::construct_at(slot.GetValue(), std::move(values[i]));
+			slot.sequence.store(writeIndex + i + 1, std::memory_order_release);
+		}
+		return count;
+	}
+
+	bool TryPop(T& value)
+	{
+		size_t readIndex = 0;
+		if (ClaimRead(1, readIndex) == 0)
+		{
+			return false;
+		}
+
+		ReleaseRead(readIndex, value);
+		return true;
+	}
+
+	size_t TryPopBatch(std::span<T> values)
+	{
+		size_t readIndex = 0;
+		const size_t count = ClaimRead(values.size(), readIndex);
+		for (size_t i = 0; i < count; ++i)
+		{
+			ReleaseRead(readIndex + i, values[i]);
+		}
+		return count;
+	}
+
+	// A hint, other threads can change it at any time
+	bool IsEmpty() const noexcept
+	{
+		const size_t readIndex = m_readIndex.load(std::memory_order_acquire);
+		return m_slots[readIndex & m_mask].sequence.load(std::memory_order_acquire) != readIndex + 1;
+	}
+
+	size_t GetCapacity() const noexcept { return m_capacity; }
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence{ 0 };
+		alignas(T) std::byte storage[sizeof(T)];
+
+		T* GetValue() noexcept { return reinterpret_cast<T*>(storage); }
+	};
+
+	// Counts the slots from index on that are ready for this lap, up to maxCount
+	size_t CountReady(size_t index, size_t maxCount, size_t lapOffset) const noexcept
+	{
+		size_t count = 0;
+		while (count < maxCount && count < m_capacity
+			&& m_slots[(index + count) & m_mask].sequence.load(std::memory_order_acquire) == index + count + lapOffset)
+		{
+			++count;
+		}
+		return count;
+	}
+
+	// Slots ready for writing have sequence == index.  Once ready, a slot stays ready until some
+	// producer moves the write index past it, which fails everyone else's compare-exchange.
+	size_t ClaimWrite(size_t maxCount, size_t& writeIndex) noexcept
+	{
+		writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			const size_t count = CountReady(writeIndex, maxCount, 0);
+			if (count == 0)
+			{
+				// Full, unless another producer already moved the index on
+				const size_t currentIndex = m_writeIndex.load(std::memory_order_relaxed);
+				if (currentIndex == writeIndex)
+				{
+					return 0;
+				}
+				writeIndex = currentIndex;
+				continue;
+			}
+
+			if (m_writeIndex.compare_exchange_weak(writeIndex, writeIndex + count, std::memory_order_relaxed))
+			{
+				return count;
+			}
+		}
+	}
+
+	// Slots ready for reading have sequence == index + 1
+	size_t ClaimRead(size_t maxCount, size_t& readIndex) noexcept
+	{
+		readIndex = m_readIndex.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			const size_t count = CountReady(readIndex, maxCount, 1);
+			if (count == 0)
+			{
+				const size_t currentIndex = m_readIndex.load(std::memory_order_relaxed);
+				if (currentIndex == readIndex)
+				{
+					return 0;
+				}
+				readIndex = currentIndex;
+				continue;
+			}
+
+			if (m_readIndex.compare_exchange_weak(readIndex, readIndex + count, std::memory_order_relaxed))
+			{
+				return count;
+			}
+		}
+	}
+
+	// Moves the value out and hands the slot to the producers' next lap
+	void ReleaseRead(size_t readIndex, T& value) noexcept
+	{
+		Slot& slot = m_slots[readIndex & m_mask];
+		T* slotValue = slot.GetValue();
+		value = std::move(*slotValue);
+		std::destroy_at(slotValue);
+		slot.sequence.store(readIndex + m_capacity, std::memory_order_release);
+	}
+
+private:
+	const size_t m_capacity{ 0 };
+	const size_t m_mask{ 0 };
+	const std::unique_ptr<Slot[]> m_slots;
+
+	alignas(64) std::atomic<size_t> m_writeIndex{ 0 };
+	alignas(64) std::atomic<size_t> m_readIndex{ 0 };
+};
+
+} // namespace Kodiak
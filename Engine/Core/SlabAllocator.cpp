@@ -0,0 +1,219 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "SlabAllocator.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr size_t s_granularity{ 16 };
+constexpr size_t s_numSizeClasses{ s_maxSlabAllocationSize / s_granularity };
+constexpr size_t s_slabSize{ 64 * 1024 };
+
+// Blocks moved between a thread's free list and the shared list at a time
+constexpr uint32_t s_batchSize{ 32 };
+
+
+struct FreeBlock
+{
+	FreeBlock* next;
+};
+
+
+struct SizeClass
+{
+	mutex classMutex;
+	FreeBlock* freeList{ nullptr };
+	vector<byte*> slabs;
+};
+
+
+// Never destroyed, objects can be freed from static destructors
+SizeClass* GetSizeClasses()
+{
+	static SizeClass* s_sizeClasses = new SizeClass[s_numSizeClasses];
+	return s_sizeClasses;
+}
+
+
+size_t GetSizeClassIndex(size_t size) noexcept
+{
+	return (std::max<size_t>(size, 1) - 1) / s_granularity;
+}
+
+
+// Moves up to count blocks from the shared list to a chain, carving a new slab if needed
+FreeBlock* TakeBatch(size_t classIndex, uint32_t count, uint32_t& numTaken)
+{
+	SizeClass& sizeClass = GetSizeClasses()[classIndex];
+	const size_t blockSize = (classIndex + 1) * s_granularity;
+
+	lock_guard<mutex> lock(sizeClass.classMutex);
+
+	if (sizeClass.freeList == nullptr)
+	{
+		byte* slab = static_cast<byte*>(::operator new(s_slabSize, align_val_t{ s_granularity }));
+		sizeClass.slabs.push_back(slab);
+
+		const size_t numBlocks = s_slabSize / blockSize;
+		for (size_t i = numBlocks; i > 0; --i)
+		{
+			auto* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * blockSize);
+			block->next = sizeClass.freeList;
+			sizeClass.freeList = block;
+		}
+	}
+
+	FreeBlock* head = sizeClass.freeList;
+	FreeBlock* tail = head;
+	numTaken = 1;
+	while (numTaken < count && tail->next != nullptr)
+	{
+		tail = tail->next;
+		++numTaken;
+	}
+
+	sizeClass.freeList = tail->next;
+	tail->next = nullptr;
+	return head;
+}
+
+
+void ReturnChain(size_t classIndex, FreeBlock* head, FreeBlock* tail)
+{
+	SizeClass& sizeClass = GetSizeClasses()[classIndex];
+
+	lock_guard<mutex> lock(sizeClass.classMutex);
+	tail->next = sizeClass.freeList;
+	sizeClass.freeList = head;
+}
+
+
+struct ThreadCache
+{
+	struct FreeList
+	{
+		FreeBlock* head{ nullptr };
+		uint32_t count{ 0 };
+	};
+
+	array<FreeList, s_numSizeClasses> freeLists{};
+
+	~ThreadCache();
+};
+
+thread_local ThreadCache t_threadCache;
+
+// Frees can arrive after the cache is destroyed, from other thread_local or static destructors
+thread_local bool t_threadCacheDestroyed{ false };
+
+
+ThreadCache::~ThreadCache()
+{
+	t_threadCacheDestroyed = true;
+
+	for (size_t classIndex = 0; classIndex < s_numSizeClasses; ++classIndex)
+	{
+		FreeList& freeList = freeLists[classIndex];
+		if (freeList.head == nullptr)
+		{
+			continue;
+		}
+
+		FreeBlock* tail = freeList.head;
+		while (tail->next != nullptr)
+		{
+			tail = tail->next;
+		}
+		ReturnChain(classIndex, freeList.head, tail);
+		freeList = {};
+	}
+}
+
+} // anonymous namespace
+
+
+void* Kodiak::SlabAllocate(size_t size)
+{
+	if (size > s_maxSlabAllocationSize)
+	{
+		return ::operator new(size);
+	}
+
+	const size_t classIndex = GetSizeClassIndex(size);
+
+	if (t_threadCacheDestroyed)
+	{
+		uint32_t numTaken = 0;
+		return TakeBatch(classIndex, 1, numTaken);
+	}
+
+	auto& freeList = t_threadCache.freeLists[classIndex];
+	if (freeList.head == nullptr)
+	{
+		freeList.head = TakeBatch(classIndex, s_batchSize, freeList.count);
+	}
+
+	FreeBlock* block = freeList.head;
+	freeList.head = block->next;
+	--freeList.count;
+	return block;
+}
+
+
+void Kodiak::SlabFree(void* p, size_t size) noexcept
+{
+	if (p == nullptr)
+	{
+		return;
+	}
+
+	if (size > s_maxSlabAllocationSize)
+	{
+		::operator delete(p);
+		return;
+	}
+
+	const size_t classIndex = GetSizeClassIndex(size);
+	auto* block = static_cast<FreeBlock*>(p);
+
+	if (t_threadCacheDestroyed)
+	{
+		ReturnChain(classIndex, block, block);
+		return;
+	}
+
+	auto& freeList = t_threadCache.freeLists[classIndex];
+	block->next = freeList.head;
+	freeList.head = block;
+	++freeList.count;
+
+	// Hand a batch back once this thread holds two, so a thread that only frees doesn't hoard
+	if (freeList.count >= 2 * s_batchSize)
+	{
+		FreeBlock* tail = freeList.head;
+		for (uint32_t i = 1; i < s_batchSize; ++i)
+		{
+			tail = tail->next;
+		}
+
+		FreeBlock* head = freeList.head;
+		freeList.head = tail->next;
+		freeList.count -= s_batchSize;
+		ReturnChain(classIndex, head, tail);
+	}
+}
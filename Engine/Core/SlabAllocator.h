@@ -0,0 +1,37 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+namespace Kodiak
+{
+
+// Small fixed-size allocations, like the IObject wrappers.  Sizes are rounded up to a multiple of
+// 16 bytes and each size class carves its blocks from 64KB slabs.  Every thread keeps a short
+// free list per size class, so most allocations and frees don't take a lock.  The free lists
+// trade blocks with a shared list per class in batches, so objects freed on another thread are
+// reused there.  Slabs are never returned to the OS.  Anything over s_maxSlabAllocationSize goes
+// to the global heap.
+constexpr size_t s_maxSlabAllocationSize{ 512 };
+
+void* SlabAllocate(size_t size);
+void SlabFree(void* p, size_t size) noexcept;
+
+
+// Class-level allocation functions that route a class, and classes derived from it, through
+// the slab allocator.  Over-aligned classes use the global heap.
+#define IMPLEMENT_SLAB_ALLOCATION \
+public: \
+	static void* operator new(size_t size) { return Kodiak::SlabAllocate(size); } \
+	static void operator delete(void* p, size_t size) noexcept { Kodiak::SlabFree(p, size); } \
+	static void* operator new(size_t size, std::align_val_t alignment) { return ::operator new(size, alignment); } \
+	static void operator delete(void* p, size_t size, std::align_val_t alignment) noexcept { ::operator delete(p, size, alignment); }
+
+} // namespace Kodiak
@@ -0,0 +1,188 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <tuple>
+
+namespace Kodiak
+{
+
+// A 32-bit slot index plus the generation the slot had when the handle was made.  Reusing a
+// slot bumps its generation, so stale handles are detected instead of aliasing the new occupant.
+// The tag keeps handles for different tables apart.
+template <typename Tag>
+struct SlotHandle
+{
+	static constexpr uint32_t s_invalidIndex{ ~0u };
+
+	uint32_t index{ s_invalidIndex };
+	uint32_t generation{ 0 };
+
+	constexpr bool IsValid() const noexcept { return index != s_invalidIndex; }
+	constexpr explicit operator bool() const noexcept { return IsValid(); }
+
+	constexpr bool operator==(const SlotHandle&) const noexcept = default;
+};
+
+
+// Generational slot map with its values kept dense, one array per column (structure of arrays).
+// Handles stay valid until erased.  Erasing moves the last value into the hole, so dense indices
+// (and any pointers into a column) aren't stable, but every column can be walked as a contiguous
+// span.  Not thread safe.
+template <typename Handle, typename... Columns>
+class SlotMap
+{
+	static_assert(sizeof...(Columns) > 0);
+	static_assert((!std::is_same_v<Columns, bool> && ...), "std::vector<bool> columns can't be viewed as spans");
+
+public:
+	template <size_t Column>
+	using ColumnType = std::tuple_element_t<Column, std::tuple<Columns...>>;
+
+	Handle Insert(Columns... values)
+	{
+		uint32_t slotIndex = m_freeHead;
+		if (slotIndex == Handle::s_invalidIndex)
+		{
+			slotIndex = (uint32_t)m_slots.size();
+			m_slots.emplace_back();
+		}
+		else
+		{
+			m_freeHead = m_slots[slotIndex].denseOrNextFree;
+		}
+
+		Slot& slot = m_slots[slotIndex];
+		slot.denseOrNextFree = (uint32_t)m_denseToSlot.size();
+		slot.occupied = true;
+
+		m_denseToSlot.push_back(slotIndex);
+		PushBack(std::index_sequence_for<Columns...>{}, std::move(values)...);
+
+		return Handle{ slotIndex, slot.generation };
+	}
+
+	// Returns false for a stale or invalid handle
+	bool Erase(Handle handle)
+	{
+		if (!Contains(handle))
+		{
+			return false;
+		}
+
+		Slot& slot = m_slots[handle.index];
+		const uint32_t denseIndex = slot.denseOrNextFree;
+		const uint32_t lastIndex = (uint32_t)m_denseToSlot.size() - 1;
+
+		if (denseIndex != lastIndex)
+		{
+			MoveDense(std::index_sequence_for<Columns...>{}, lastIndex, denseIndex);
+			m_denseToSlot[denseIndex] = m_denseToSlot[lastIndex];
+			m_slots[m_denseToSlot[denseIndex]].denseOrNextFree = denseIndex;
+		}
+
+		PopBack(std::index_sequence_for<Columns...>{});
+		m_denseToSlot.pop_back();
+
+		++slot.generation;
+		slot.occupied = false;
+		slot.denseOrNextFree = m_freeHead;
+		m_freeHead = handle.index;
+
+		return true;
+	}
+
+	bool Contains(Handle handle) const noexcept
+	{
+		return handle.index < m_slots.size()
+			&& m_slots[handle.index].occupied
+			&& m_slots[handle.index].generation == handle.generation;
+	}
+
+	// Position of the handle's values in the columns.  The handle must be live.
+	uint32_t GetDenseIndex(Handle handle) const noexcept
+	{
+		assert(Contains(handle));
+		return m_slots[handle.index].denseOrNextFree;
+	}
+
+	Handle GetHandle(uint32_t denseIndex) const noexcept
+	{
+		const uint32_t slotIndex = m_denseToSlot[denseIndex];
+		return Handle{ slotIndex, m_slots[slotIndex].generation };
+	}
+
+	template <size_t Column>
+	ColumnType<Column>& Get(Handle handle) noexcept { return std::get<Column>(m_columns)[GetDenseIndex(handle)]; }
+
+	template <size_t Column>
+	const ColumnType<Column>& Get(Handle handle) const noexcept { return std::get<Column>(m_columns)[GetDenseIndex(handle)]; }
+
+	template <size_t Column>
+	std::span<ColumnType<Column>> GetColumn() noexcept { return std::get<Column>(m_columns); }
+
+	template <size_t Column>
+	std::span<const ColumnType<Column>> GetColumn() const noexcept { return std::get<Column>(m_columns); }
+
+	uint32_t GetSize() const noexcept { return (uint32_t)m_denseToSlot.size(); }
+	bool IsEmpty() const noexcept { return m_denseToSlot.empty(); }
+
+	void Reserve(size_t capacity)
+	{
+		m_slots.reserve(capacity);
+		m_denseToSlot.reserve(capacity);
+		std::apply([capacity](auto&... column) { (column.reserve(capacity), ...); }, m_columns);
+	}
+
+	// Invalidates every handle
+	void Clear()
+	{
+		for (uint32_t denseIndex = GetSize(); denseIndex > 0; --denseIndex)
+		{
+			Erase(GetHandle(denseIndex - 1));
+		}
+	}
+
+private:
+	template <size_t... I>
+	void PushBack(std::index_sequence<I...>, Columns&&... values)
+	{
+		(std::get<I>(m_columns).push_back(std::move(values)), ...);
+	}
+
+	template <size_t... I>
+	void MoveDense(std::index_sequence<I...>, uint32_t from, uint32_t to)
+	{
+		((std::get<I>(m_columns)[to] = std::move(std::get<I>(m_columns)[from])), ...);
+	}
+
+	template <size_t... I>
+	void PopBack(std::index_sequence<I...>)
+	{
+		(std::get<I>(m_columns).pop_back(), ...);
+	}
+
+private:
+	struct Slot
+	{
+		// Dense index while occupied, next free slot otherwise
+		uint32_t denseOrNextFree{ Handle::s_invalidIndex };
+		uint32_t generation{ 0 };
+		bool occupied{ false };
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_denseToSlot;
+	std::tuple<std::vector<Columns>...> m_columns;
+	uint32_t m_freeHead{ Handle::s_invalidIndex };
+};
+
+} // namespace Kodiak
@@ -0,0 +1,217 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <initializer_list>
+
+namespace Kodiak
+{
+
+// A std::vector with room for N elements inside the object itself.  Lists that usually stay small,
+// like the barriers batched between flushes, never touch the heap and sit next to the rest of
+// their owner's data.  Past N the elements move to the heap, and stay there (clear keeps the
+// capacity).  Like std::vector, any insert that grows the storage invalidates pointers and
+// iterators, and so does moving a SmallVector that's still using its inline storage.
+template <typename T, size_t N>
+class SmallVector
+{
+	static_assert(N > 0);
+
+public:
+	using value_type = T;
+	using size_type = size_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	SmallVector() noexcept = default;
+
+	SmallVector(std::initializer_list<T> values)
+	{
+		reserve(values.size());
+		for (const auto& value : values)
+		{
+			push_back(value);
+		}
+	}
+
+	SmallVector(const SmallVector& other)
+	{
+		reserve(other.m_size);
+		std::uninitialized_copy_n(other.m_data, other.m_size, m_data);
+		m_size = other.m_size;
+	}
+
+	SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		MoveFrom(other);
+	}
+
+	~SmallVector()
+	{
+		clear();
+		FreeHeap();
+	}
+
+	SmallVector& operator=(const SmallVector& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			reserve(other.m_size);
+			std::uninitialized_copy_n(other.m_data, other.m_size, m_data);
+			m_size = other.m_size;
+		}
+		return *this;
+	}
+
+	SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		if (this != &other)
+		{
+			clear();
+			FreeHeap();
+			m_data = GetInlineData();
+			m_capacity = N;
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	T* data() noexcept { return m_data; }
+	const T* data() const noexcept { return m_data; }
+
+	size_t size() const noexcept { return m_size; }
+	size_t capacity() const noexcept { return m_capacity; }
+	bool empty() const noexcept { return m_size == 0; }
+
+	// True while the elements are in the inline storage
+	bool IsInline() const noexcept { return m_data == GetInlineData(); }
+
+	iterator begin() noexcept { return m_data; }
+	iterator end() noexcept { return m_data + m_size; }
+	const_iterator begin() const noexcept { return m_data; }
+	const_iterator end() const noexcept { return m_data + m_size; }
+
+	T& operator[](size_t index) noexcept { assert(index < m_size); return m_data[index]; }
+	const T& operator[](size_t index) const noexcept { assert(index < m_size); return m_data[index]; }
+
+	T& front() noexcept { assert(m_size > 0); return m_data[0]; }
+	const T& front() const noexcept { assert(m_size > 0); return m_data[0]; }
+	T& back() noexcept { assert(m_size > 0); return m_data[m_size - 1]; }
+	const T& back() const noexcept { assert(m_size > 0); return m_data[m_size - 1]; }
+
+	void push_back(const T& value) { emplace_back(value); }
+	void push_back(T&& value) { emplace_back(std::move(value)); }
+
+	template <typename... Args>
+	T& emplace_back(Args&&... args)
+	{
+		if (m_size < m_capacity)
+		{
+			T* element = std::construct_at(m_data + m_size, std::forward<Args>(args)...);
+			++m_size;
+			return *element;
+		}
+
+		// Construct the new element before moving the old ones, the arguments may refer to them
+		const size_t newCapacity = m_capacity * 2;
+		T* newData = Allocate(newCapacity);
+		T* element = std::construct_at(newData + m_size, std::forward<Args>(args)...);
+		Relocate(newData, newCapacity);
+		++m_size;
+		return *element;
+	}
+
+	void pop_back() noexcept
+	{
+		assert(m_size > 0);
+		std::destroy_at(m_data + --m_size);
+	}
+
+	void clear() noexcept
+	{
+		std::destroy_n(m_data, m_size);
+		m_size = 0;
+	}
+
+	void reserve(size_t newCapacity)
+	{
+		if (newCapacity > m_capacity)
+		{
+			Relocate(Allocate(newCapacity), newCapacity);
+		}
+	}
+
+	void resize(size_t newSize)
+	{
+		if (newSize < m_size)
+		{
+			std::destroy(m_data + newSize, m_data + m_size);
+		}
+		else
+		{
+			reserve(newSize);
+			std::uninitialized_value_construct(m_data + m_size, m_data + newSize);
+		}
+		m_size = newSize;
+	}
+
+private:
+	T* GetInlineData() noexcept { return reinterpret_cast<T*>(m_inlineStorage); }
+	const T* GetInlineData() const noexcept { return reinterpret_cast<const T*>(m_inlineStorage); }
+
+	static T* Allocate(size_t capacity) { return std::allocator<T>{}.allocate(capacity); }
+
+	void FreeHeap() noexcept
+	{
+		if (!IsInline())
+		{
+			std::allocator<T>{}.deallocate(m_data, m_capacity);
+		}
+	}
+
+	// Moves the elements to newly allocated storage and frees the old storage
+	void Relocate(T* newData, size_t newCapacity)
+	{
+		std::uninitialized_move_n(m_data, m_size, newData);
+		std::destroy_n(m_data, m_size);
+		FreeHeap();
+		m_data = newData;
+		m_capacity = newCapacity;
+	}
+
+	// Expects this to be empty and inline
+	void MoveFrom(SmallVector& other)
+	{
+		if (other.IsInline())
+		{
+			std::uninitialized_move_n(other.m_data, other.m_size, m_data);
+			m_size = other.m_size;
+			other.clear();
+		}
+		else
+		{
+			m_data = std::exchange(other.m_data, other.GetInlineData());
+			m_size = std::exchange(other.m_size, 0);
+			m_capacity = std::exchange(other.m_capacity, N);
+		}
+	}
+
+private:
+	T* m_data{ GetInlineData() };
+	size_t m_size{ 0 };
+	size_t m_capacity{ N };
+	alignas(T) std::byte m_inlineStorage[N * sizeof(T)];
+};
+
+} // namespace Kodiak
@@ -0,0 +1,256 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "StringId.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr size_t s_storageBlockSize{ 64 * 1024 };
+constexpr uint32_t s_segmentSize{ 4096 };
+constexpr uint32_t s_maxSegments{ 4096 };
+constexpr uint32_t s_initialTableCapacity{ 1024 };
+
+
+// Fixed, so a string hashes the same on every machine and every run, whatever the CPU supports.
+// Eight bytes per multiply, then the splitmix64 finalizer so the low bits the table probes with
+// depend on every byte.  Names are short, this doesn't need to be the fastest hash around.
+uint64_t HashString(string_view str) noexcept
+{
+	constexpr uint64_t s_multiplier{ 0x9E3779B97F4A7C15ull };
+
+	uint64_t hash = str.size() * s_multiplier;
+
+	size_t offset = 0;
+	for (; offset + 8 <= str.size(); offset += 8)
+	{
+		uint64_t word = 0;
+		memcpy(&word, str.data() + offset, 8);
+		hash = (hash ^ word) * s_multiplier;
+		hash ^= hash >> 32;
+	}
+
+	if (offset < str.size())
+	{
+		uint64_t word = 0;
+		memcpy(&word, str.data() + offset, str.size() - offset);
+		hash = (hash ^ word) * s_multiplier;
+	}
+
+	hash ^= hash >> 30;
+	hash *= 0xBF58476D1CE4E5B9ull;
+	hash ^= hash >> 27;
+	hash *= 0x94D049BB133111EBull;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+
+// Followed by the characters and a null terminator
+struct InternedString
+{
+	uint64_t hash{ 0 };
+	uint32_t length{ 0 };
+
+	string_view GetString() const noexcept { return { reinterpret_cast<const char*>(this + 1), length }; }
+};
+
+
+// Open addressing, slots hold string ids with 0 for empty.  Never more than half full.
+struct HashTable
+{
+	explicit HashTable(uint32_t capacity)
+		: capacity{ capacity }
+		, slots{ make_unique<atomic<uint32_t>[]>(capacity) }
+	{}
+
+	const uint32_t capacity{ 0 };
+	unique_ptr<atomic<uint32_t>[]> slots;
+};
+
+
+// Readers never lock.  They find strings through the current hash table, and ids through an array
+// of fixed size segments.  Segments never move, and a table that's outgrown is replaced but not
+// freed, so a reader can finish a lookup in the old one.  Writers take the mutex.
+class StringInterner : NonCopyable, NonMovable
+{
+public:
+	StringInterner()
+	{
+		m_table.store(new HashTable(s_initialTableCapacity), memory_order_relaxed);
+	}
+
+	uint32_t Intern(string_view str)
+	{
+		if (str.empty())
+		{
+			return 0;
+		}
+
+		const uint64_t hash = HashString(str);
+
+		if (const uint32_t id = Find(*m_table.load(memory_order_acquire), str, hash))
+		{
+			return id;
+		}
+
+		lock_guard<mutex> lock(m_insertMutex);
+
+		HashTable* table = m_table.load(memory_order_relaxed);
+		if (const uint32_t id = Find(*table, str, hash))
+		{
+			return id;
+		}
+
+		assert_msg(m_numStrings + 1 < s_maxSegments * s_segmentSize, "Too many interned strings");
+		const uint32_t id = ++m_numStrings;
+
+		const uint32_t segmentIndex = id / s_segmentSize;
+		auto* segment = m_segments[segmentIndex].load(memory_order_relaxed);
+		if (segment == nullptr)
+		{
+			segment = new atomic<const InternedString*>[s_segmentSize] {};
+			m_segments[segmentIndex].store(segment, memory_order_release);
+		}
+		segment[id % s_segmentSize].store(Store(str, hash), memory_order_release);
+
+		if (2 * m_numStrings > table->capacity)
+		{
+			table = Grow(*table);
+		}
+		else
+		{
+			InsertId(*table, id, hash);
+		}
+
+		return id;
+	}
+
+	string_view GetString(uint32_t id) const noexcept
+	{
+		return id == 0 ? string_view{ "" } : GetEntry(id).GetString();
+	}
+
+private:
+	const InternedString& GetEntry(uint32_t id) const noexcept
+	{
+		const auto* segment = m_segments[id / s_segmentSize].load(memory_order_acquire);
+		return *segment[id % s_segmentSize].load(memory_order_acquire);
+	}
+
+	uint32_t Find(const HashTable& table, string_view str, uint64_t hash) const noexcept
+	{
+		const uint32_t mask = table.capacity - 1;
+		for (uint32_t slot = (uint32_t)hash & mask; ; slot = (slot + 1) & mask)
+		{
+			const uint32_t id = table.slots[slot].load(memory_order_acquire);
+			if (id == 0)
+			{
+				return 0;
+			}
+
+			const InternedString& entry = GetEntry(id);
+			if (entry.hash == hash && entry.GetString() == str)
+			{
+				return id;
+			}
+		}
+	}
+
+	static void InsertId(HashTable& table, uint32_t id, uint64_t hash) noexcept
+	{
+		const uint32_t mask = table.capacity - 1;
+		uint32_t slot = (uint32_t)hash & mask;
+		while (table.slots[slot].load(memory_order_relaxed) != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+		table.slots[slot].store(id, memory_order_release);
+	}
+
+	// Builds a table twice the size holding every id, including the one just added
+	HashTable* Grow(const HashTable& table)
+	{
+		auto* newTable = new HashTable(table.capacity * 2);
+		for (uint32_t id = 1; id <= m_numStrings; ++id)
+		{
+			InsertId(*newTable, id, GetEntry(id).hash);
+		}
+
+		// The old table is leaked on purpose, readers may still be probing it
+		m_table.store(newTable, memory_order_release);
+		return newTable;
+	}
+
+	const InternedString* Store(string_view str, uint64_t hash)
+	{
+		const size_t size = Math::AlignUp(sizeof(InternedString) + str.size() + 1, alignof(InternedString));
+
+		byte* storage{ nullptr };
+		if (size > s_storageBlockSize / 4)
+		{
+			storage = new byte[size];
+		}
+		else
+		{
+			if (m_storageBlock == nullptr || m_storageOffset + size > s_storageBlockSize)
+			{
+				m_storageBlock = new byte[s_storageBlockSize];
+				m_storageOffset = 0;
+			}
+			storage = m_storageBlock + m_storageOffset;
+			m_storageOffset += size;
+		}
+
+		auto* entry = new (storage) InternedString{ hash, (uint32_t)str.size() };
+		char* chars = reinterpret_cast<char*>(entry + 1);
+		memcpy(chars, str.data(), str.size());
+		chars[str.size()] = '\0';
+		return entry;
+	}
+
+private:
+	atomic<HashTable*> m_table{ nullptr };
+	array<atomic<atomic<const InternedString*>*>, s_maxSegments> m_segments{};
+
+	// Writers only
+	mutex m_insertMutex;
+	uint32_t m_numStrings{ 0 };
+	byte* m_storageBlock{ nullptr };
+	size_t m_storageOffset{ 0 };
+};
+
+
+// Never destroyed, names can be looked up from static destructors
+StringInterner& GetStringInterner()
+{
+	static StringInterner* s_interner = new StringInterner;
+	return *s_interner;
+}
+
+} // anonymous namespace
+
+
+StringId::StringId(string_view str)
+	: m_id{ GetStringInterner().Intern(str) }
+{}
+
+
+string_view StringId::GetString() const noexcept
+{
+	return GetStringInterner().GetString(m_id);
+}
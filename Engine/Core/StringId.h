@@ -0,0 +1,52 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+namespace Kodiak
+{
+
+// An interned string.  Equal strings get the same 32-bit id, so a StringId compares, hashes and
+// copies as an integer, and works as a map key.  Ids are handed out in order from 1, id 0 is the
+// empty string.  Interned strings are never freed, so only intern names from a bounded set
+// (categories, resource and scope names), not arbitrary text.
+//
+// Looking up a string that's already interned, and getting a StringId's string, don't take a
+// lock.  Interning a new string does.
+class StringId
+{
+public:
+	constexpr StringId() noexcept = default;
+	explicit StringId(std::string_view str);
+
+	bool IsValid() const noexcept { return m_id != 0; }
+	uint32_t GetId() const noexcept { return m_id; }
+
+	// Null terminated, and valid for the life of the process
+	std::string_view GetString() const noexcept;
+	const char* c_str() const noexcept { return GetString().data(); }
+
+	constexpr auto operator<=>(const StringId&) const noexcept = default;
+
+private:
+	uint32_t m_id{ 0 };
+};
+
+} // namespace Kodiak
+
+
+template <>
+struct std::hash<Kodiak::StringId>
+{
+	size_t operator()(Kodiak::StringId stringId) const noexcept
+	{
+		return std::hash<uint32_t>{}(stringId.GetId());
+	}
+};
@@ -0,0 +1,89 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <condition_variable>
+
+namespace Kodiak
+{
+
+// Hands values from one producer thread to one consumer thread.  The producer fills the write
+// slot while the consumer works on the read slot, with a third slot holding a published value
+// the consumer hasn't taken yet.  Nothing is dropped: Publish waits if the previous value is
+// still unclaimed, so the producer runs at most two values ahead.
+template <typename T>
+class TripleBuffer : NonCopyable, NonMovable
+{
+public:
+	explicit TripleBuffer(const std::function<T()>& create)
+		: m_slots{ create(), create(), create() }
+	{}
+
+	// Producer only
+	T& GetWriteSlot() noexcept { return m_slots[m_writeIndex]; }
+
+	// Producer only.  Returns false, without publishing, once the buffer is closed.
+	bool Publish()
+	{
+		std::unique_lock lock(m_mutex);
+		m_condition.wait(lock, [this] { return !m_hasPublished || m_closed; });
+
+		if (m_closed)
+		{
+			return false;
+		}
+
+		std::swap(m_writeIndex, m_publishedIndex);
+		m_hasPublished = true;
+		m_condition.notify_all();
+		return true;
+	}
+
+	// Consumer only.  Waits for the next published value, or returns nullptr once the buffer
+	// is closed and drained.  The value stays valid until the next Acquire.
+	T* Acquire()
+	{
+		std::unique_lock lock(m_mutex);
+		m_condition.wait(lock, [this] { return m_hasPublished || m_closed; });
+
+		if (!m_hasPublished)
+		{
+			return nullptr;
+		}
+
+		std::swap(m_readIndex, m_publishedIndex);
+		m_hasPublished = false;
+		m_condition.notify_all();
+		return &m_slots[m_readIndex];
+	}
+
+	// Wakes both sides.  A value already published is still handed to the consumer.
+	void Close()
+	{
+		std::lock_guard lock(m_mutex);
+		m_closed = true;
+		m_condition.notify_all();
+	}
+
+private:
+	std::array<T, 3> m_slots;
+
+	uint32_t m_writeIndex{ 0 };
+	uint32_t m_publishedIndex{ 1 };
+	uint32_t m_readIndex{ 2 };
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_hasPublished{ false };
+	bool m_closed{ false };
+};
+
+} // namespace Kodiak
@@ -0,0 +1,525 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "CpuTopology.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+#if defined(_WIN32)
+
+using NativeThreadHandle = HANDLE;
+
+
+// Calls func(record) for every record of the given relationship
+template <typename Func>
+void ForEachRecord(const vector<uint8_t>& buffer, LOGICAL_PROCESSOR_RELATIONSHIP relationship, Func&& func)
+{
+	size_t offset = 0;
+	while (offset < buffer.size())
+	{
+		const auto* record = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+		if (record->Relationship == relationship)
+		{
+			func(*record);
+		}
+		offset += record->Size;
+	}
+}
+
+
+template <typename Func>
+void ForEachProcessorIn(vector<LogicalProcessor>& processors, const GROUP_AFFINITY& groupAffinity, Func&& func)
+{
+	for (auto& processor : processors)
+	{
+		if (processor.osGroup == groupAffinity.Group && (groupAffinity.Mask & ((KAFFINITY)1 << processor.osIndex)) != 0)
+		{
+			func(processor);
+		}
+	}
+}
+
+#elif defined(__linux__)
+
+using NativeThreadHandle = pthread_t;
+
+const filesystem::path s_sysCpuPath{ "/sys/devices/system/cpu" };
+
+
+string ReadSysFile(const filesystem::path& path)
+{
+	ifstream file(path);
+	string line;
+	getline(file, line);
+	return line;
+}
+
+
+uint32_t ReadSysUInt(const filesystem::path& path, uint32_t defaultValue)
+{
+	const string text = ReadSysFile(path);
+	if (text.empty() || !isdigit((unsigned char)text[0]))
+	{
+		return defaultValue;
+	}
+	return (uint32_t)stoul(text);
+}
+
+
+// Parses the kernel's cpu list format, like "0-3,8,10-11"
+vector<uint32_t> ParseCpuList(const string& text)
+{
+	vector<uint32_t> cpus;
+
+	stringstream stream(text);
+	string range;
+	while (getline(stream, range, ','))
+	{
+		if (range.empty() || !isdigit((unsigned char)range[0]))
+		{
+			continue;
+		}
+
+		const size_t dash = range.find('-');
+		const uint32_t first = (uint32_t)stoul(range.substr(0, dash));
+		const uint32_t last = (dash == string::npos) ? first : (uint32_t)stoul(range.substr(dash + 1));
+		for (uint32_t cpu = first; cpu <= last; ++cpu)
+		{
+			cpus.push_back(cpu);
+		}
+	}
+
+	return cpus;
+}
+
+#endif
+
+
+bool SetNativeThreadAffinity(NativeThreadHandle thread, const CpuSet& cpuSet)
+{
+	const auto& topology = GetCpuTopology();
+
+#if defined(_WIN32)
+	// A thread can only be confined to a single group, pick the one with most of the set
+	map<uint16_t, KAFFINITY> groupMasks;
+	cpuSet.ForEach([&](uint32_t processor)
+		{
+			if (processor < topology.GetNumLogicalProcessors())
+			{
+				const auto& logicalProcessor = topology.GetLogicalProcessor(processor);
+				groupMasks[logicalProcessor.osGroup] |= (KAFFINITY)1 << logicalProcessor.osIndex;
+			}
+		});
+
+	if (groupMasks.empty())
+	{
+		return false;
+	}
+
+	auto best = groupMasks.begin();
+	for (auto it = groupMasks.begin(); it != groupMasks.end(); ++it)
+	{
+		if (popcount((uint64_t)it->second) > popcount((uint64_t)best->second))
+		{
+			best = it;
+		}
+	}
+
+	GROUP_AFFINITY groupAffinity{};
+	groupAffinity.Group = best->first;
+	groupAffinity.Mask = best->second;
+	return SetThreadGroupAffinity(thread, &groupAffinity, nullptr) != FALSE;
+#elif defined(__linux__)
+	cpu_set_t nativeSet;
+	CPU_ZERO(&nativeSet);
+
+	uint32_t count = 0;
+	cpuSet.ForEach([&](uint32_t processor)
+		{
+			if (processor < topology.GetNumLogicalProcessors())
+			{
+				const uint32_t cpu = topology.GetLogicalProcessor(processor).osIndex;
+				if (cpu < CPU_SETSIZE)
+				{
+					CPU_SET(cpu, &nativeSet);
+					++count;
+				}
+			}
+		});
+
+	return count != 0 && pthread_setaffinity_np(thread, sizeof(nativeSet), &nativeSet) == 0;
+#else
+	return false;
+#endif
+}
+
+} // anonymous namespace
+
+
+CpuTopology::CpuTopology()
+{
+	Enumerate();
+	Finalize();
+}
+
+
+void CpuTopology::Enumerate()
+{
+#if defined(_WIN32)
+	DWORD length = 0;
+	GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+	if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+	{
+		return;
+	}
+
+	vector<uint8_t> buffer(length);
+	if (!GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data()), &length))
+	{
+		return;
+	}
+	buffer.resize(length);
+
+	// Cores first, the caches and NUMA nodes name their processors by group and mask
+	uint32_t numCores = 0;
+	ForEachRecord(buffer, RelationProcessorCore, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& record)
+		{
+			const uint32_t core = numCores++;
+			for (WORD group = 0; group < record.Processor.GroupCount; ++group)
+			{
+				const GROUP_AFFINITY& groupAffinity = record.Processor.GroupMask[group];
+				for (uint32_t bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit)
+				{
+					if ((groupAffinity.Mask & ((KAFFINITY)1 << bit)) != 0)
+					{
+						LogicalProcessor processor{};
+						processor.core = core;
+						processor.efficiencyClass = record.Processor.EfficiencyClass;
+						processor.osGroup = groupAffinity.Group;
+						processor.osIndex = bit;
+						m_processors.push_back(processor);
+					}
+				}
+			}
+		});
+
+	uint32_t l3Domain = 0;
+	ForEachRecord(buffer, RelationCache, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& record)
+		{
+			if (record.Cache.Level == 3)
+			{
+				ForEachProcessorIn(m_processors, record.Cache.GroupMask, [l3Domain](LogicalProcessor& processor) { processor.l3Domain = l3Domain; });
+				++l3Domain;
+			}
+		});
+
+	ForEachRecord(buffer, RelationNumaNode, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& record)
+		{
+			const uint32_t numaNode = record.NumaNode.NodeNumber;
+			ForEachProcessorIn(m_processors, record.NumaNode.GroupMask, [numaNode](LogicalProcessor& processor) { processor.numaNode = numaNode; });
+		});
+#elif defined(__linux__)
+	const vector<uint32_t> onlineCpus = ParseCpuList(ReadSysFile(s_sysCpuPath / "online"));
+
+	// Intel hybrid parts list their efficiency cores here, ARM reports a capacity per cpu instead
+	CpuSet atomCpus;
+	const bool hasAtomCpus = filesystem::exists("/sys/devices/cpu_atom/cpus");
+	for (uint32_t cpu : ParseCpuList(ReadSysFile("/sys/devices/cpu_atom/cpus")))
+	{
+		atomCpus.Add(cpu);
+	}
+
+	map<pair<uint32_t, uint32_t>, uint32_t> coreIds;
+	map<uint32_t, uint32_t> l3Ids;
+
+	for (uint32_t cpu : onlineCpus)
+	{
+		const filesystem::path cpuPath = s_sysCpuPath / format("cpu{}", cpu);
+
+		LogicalProcessor processor{};
+		processor.osIndex = cpu;
+
+		// Core ids are only unique within a package
+		const uint32_t package = ReadSysUInt(cpuPath / "topology" / "physical_package_id", 0);
+		const uint32_t coreId = ReadSysUInt(cpuPath / "topology" / "core_id", cpu);
+		processor.core = coreIds.try_emplace({ package, coreId }, (uint32_t)coreIds.size()).first->second;
+
+		// An L3 domain is named by the first cpu sharing it
+		error_code ec;
+		for (const auto& entry : filesystem::directory_iterator(cpuPath / "cache", ec))
+		{
+			if (entry.path().filename().string().starts_with("index") && ReadSysUInt(entry.path() / "level", 0) == 3)
+			{
+				const vector<uint32_t> sharedCpus = ParseCpuList(ReadSysFile(entry.path() / "shared_cpu_list"));
+				const uint32_t key = sharedCpus.empty() ? cpu : sharedCpus.front();
+				processor.l3Domain = l3Ids.try_emplace(key, (uint32_t)l3Ids.size()).first->second;
+				break;
+			}
+		}
+
+		// The cpu directory links to its NUMA node as nodeN
+		for (const auto& entry : filesystem::directory_iterator(cpuPath, ec))
+		{
+			const string name = entry.path().filename().string();
+			if (name.size() > 4 && name.starts_with("node") && isdigit((unsigned char)name[4]))
+			{
+				processor.numaNode = (uint32_t)stoul(name.substr(4));
+				break;
+			}
+		}
+
+		if (filesystem::exists(cpuPath / "cpu_capacity"))
+		{
+			processor.efficiencyClass = ReadSysUInt(cpuPath / "cpu_capacity", 0);
+		}
+		else if (hasAtomCpus)
+		{
+			processor.efficiencyClass = atomCpus.Contains(cpu) ? 0 : 1;
+		}
+
+		m_processors.push_back(processor);
+	}
+#endif
+}
+
+
+void CpuTopology::Finalize()
+{
+	// Nothing from the OS, assume one core per hardware thread
+	if (m_processors.empty())
+	{
+		const uint32_t numProcessors = std::max(thread::hardware_concurrency(), 1u);
+		for (uint32_t i = 0; i < numProcessors; ++i)
+		{
+			LogicalProcessor processor{};
+			processor.core = i;
+#if defined(_WIN32)
+			processor.osGroup = (uint16_t)(i / 64);
+			processor.osIndex = i % 64;
+#else
+			processor.osIndex = i;
+#endif
+			m_processors.push_back(processor);
+		}
+	}
+
+	uint32_t numRawCores = 0;
+	for (const auto& processor : m_processors)
+	{
+		numRawCores = std::max(numRawCores, processor.core + 1);
+	}
+
+	vector<vector<LogicalProcessor>> rawCores(numRawCores);
+	for (const auto& processor : m_processors)
+	{
+		rawCores[processor.core].push_back(processor);
+	}
+	erase_if(rawCores, [](const auto& rawCore) { return rawCore.empty(); });
+
+	// Fastest cores first, otherwise keep the OS order
+	stable_sort(rawCores.begin(), rawCores.end(),
+		[](const auto& a, const auto& b) { return a.front().efficiencyClass > b.front().efficiencyClass; });
+
+	// Renumber the L3 domains and NUMA nodes densely, in core order
+	map<uint32_t, uint32_t> l3Ids;
+	map<uint32_t, uint32_t> numaIds;
+
+	m_processors.clear();
+	m_cores.clear();
+	for (auto& rawCore : rawCores)
+	{
+		const uint32_t coreIndex = (uint32_t)m_cores.size();
+		CpuCore& core = m_cores.emplace_back();
+		core.l3Domain = l3Ids.try_emplace(rawCore.front().l3Domain, (uint32_t)l3Ids.size()).first->second;
+		core.numaNode = numaIds.try_emplace(rawCore.front().numaNode, (uint32_t)numaIds.size()).first->second;
+		core.efficiencyClass = rawCore.front().efficiencyClass;
+
+		uint32_t smtIndex = 0;
+		for (auto& processor : rawCore)
+		{
+			processor.core = coreIndex;
+			processor.l3Domain = core.l3Domain;
+			processor.numaNode = core.numaNode;
+			processor.smtIndex = smtIndex++;
+
+			core.processors.Add((uint32_t)m_processors.size());
+			m_processors.push_back(processor);
+		}
+	}
+
+	m_numL3Domains = std::max((uint32_t)l3Ids.size(), 1u);
+	m_numNumaNodes = std::max((uint32_t)numaIds.size(), 1u);
+	m_isHybrid = m_cores.front().efficiencyClass != m_cores.back().efficiencyClass;
+}
+
+
+const CpuTopology& Kodiak::GetCpuTopology()
+{
+	static const CpuTopology s_topology;
+	return s_topology;
+}
+
+
+ThreadPlacement::ThreadPlacement(const CpuTopology& topology, ThreadAffinity affinity, bool reserveRenderCore)
+{
+	const uint32_t numCores = topology.GetNumCores();
+	const uint32_t numReservedCores = reserveRenderCore ? 2 : 1;
+
+	// Reserving cores only helps if at least one is left for everything else
+	if (affinity == ThreadAffinity::Float || numCores <= numReservedCores)
+	{
+		return;
+	}
+
+	m_affinity = affinity;
+
+	const CpuCore& mainCore = topology.GetCore(0);
+	m_mainSet = mainCore.processors;
+
+	// Keep the render thread on the main thread's L3 domain, they share the frame data
+	vector<bool> reserved(numCores, false);
+	reserved[0] = true;
+	if (reserveRenderCore)
+	{
+		uint32_t renderCore = 1;
+		for (uint32_t core = 1; core < numCores; ++core)
+		{
+			const CpuCore& candidate = topology.GetCore(core);
+			if (candidate.l3Domain == mainCore.l3Domain && candidate.efficiencyClass == mainCore.efficiencyClass)
+			{
+				renderCore = core;
+				break;
+			}
+		}
+		reserved[renderCore] = true;
+		m_renderSet = topology.GetCore(renderCore).processors;
+	}
+
+	// Workers prefer fast cores, then cores sharing the main thread's L3
+	vector<uint32_t> workerCores;
+	for (uint32_t core = 0; core < numCores; ++core)
+	{
+		if (!reserved[core])
+		{
+			workerCores.push_back(core);
+			m_workerSet.Add(topology.GetCore(core).processors);
+		}
+	}
+
+	stable_sort(workerCores.begin(), workerCores.end(),
+		[&topology, &mainCore](uint32_t a, uint32_t b)
+		{
+			const CpuCore& coreA = topology.GetCore(a);
+			const CpuCore& coreB = topology.GetCore(b);
+			if (coreA.efficiencyClass != coreB.efficiencyClass)
+			{
+				return coreA.efficiencyClass > coreB.efficiencyClass;
+			}
+			return (coreA.l3Domain == mainCore.l3Domain) && (coreB.l3Domain != mainCore.l3Domain);
+		});
+
+	// One worker per core before any doubles up on an SMT sibling
+	for (uint32_t smtIndex = 0; m_workerOrder.size() < m_workerSet.Count(); ++smtIndex)
+	{
+		for (uint32_t core : workerCores)
+		{
+			topology.GetCore(core).processors.ForEach([&](uint32_t processor)
+				{
+					if (topology.GetLogicalProcessor(processor).smtIndex == smtIndex)
+					{
+						m_workerOrder.push_back(processor);
+					}
+				});
+		}
+	}
+
+	m_numJobWorkers = (uint32_t)m_workerOrder.size();
+
+	// The log worker mostly sleeps, give it the slowest cores
+	if (topology.IsHybrid())
+	{
+		const uint32_t slowestClass = topology.GetCore(workerCores.back()).efficiencyClass;
+		for (uint32_t core : workerCores)
+		{
+			if (topology.GetCore(core).efficiencyClass == slowestClass)
+			{
+				m_logSet.Add(topology.GetCore(core).processors);
+			}
+		}
+	}
+	else
+	{
+		m_logSet = m_workerSet;
+	}
+}
+
+
+CpuSet ThreadPlacement::GetCpuSet(ThreadRole role, uint32_t threadIndex) const
+{
+	switch (role)
+	{
+	case ThreadRole::Main:
+		return m_mainSet;
+
+	case ThreadRole::Render:
+		return m_renderSet;
+
+	case ThreadRole::Log:
+		return m_logSet;
+
+	case ThreadRole::JobWorker:
+		// Thread 0 is the thread that created the JobSystem
+		if (threadIndex == 0)
+		{
+			return m_mainSet;
+		}
+		if (m_affinity == ThreadAffinity::Pin && !m_workerOrder.empty())
+		{
+			CpuSet cpuSet;
+			cpuSet.Add(m_workerOrder[(threadIndex - 1) % m_workerOrder.size()]);
+			return cpuSet;
+		}
+		return m_workerSet;
+
+	default:
+		return {};
+	}
+}
+
+
+bool Kodiak::SetThreadAffinity(thread& thread, const CpuSet& cpuSet)
+{
+	return thread.joinable() && SetNativeThreadAffinity(thread.native_handle(), cpuSet);
+}
+
+
+bool Kodiak::SetCurrentThreadAffinity(const CpuSet& cpuSet)
+{
+#if defined(_WIN32)
+	return SetNativeThreadAffinity(GetCurrentThread(), cpuSet);
+#elif defined(__linux__)
+	return SetNativeThreadAffinity(pthread_self(), cpuSet);
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,209 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <bit>
+
+namespace Kodiak
+{
+
+// A set of logical processors, by index into CpuTopology
+class CpuSet
+{
+public:
+	void Add(uint32_t processor)
+	{
+		const size_t word = processor / 64;
+		if (word >= m_bits.size())
+		{
+			m_bits.resize(word + 1, 0);
+		}
+		m_bits[word] |= 1ull << (processor % 64);
+	}
+
+	void Add(const CpuSet& other)
+	{
+		if (other.m_bits.size() > m_bits.size())
+		{
+			m_bits.resize(other.m_bits.size(), 0);
+		}
+		for (size_t i = 0; i < other.m_bits.size(); ++i)
+		{
+			m_bits[i] |= other.m_bits[i];
+		}
+	}
+
+	bool Contains(uint32_t processor) const noexcept
+	{
+		const size_t word = processor / 64;
+		return word < m_bits.size() && (m_bits[word] & (1ull << (processor % 64))) != 0;
+	}
+
+	uint32_t Count() const noexcept
+	{
+		uint32_t count = 0;
+		for (uint64_t bits : m_bits)
+		{
+			count += (uint32_t)std::popcount(bits);
+		}
+		return count;
+	}
+
+	bool IsEmpty() const noexcept { return Count() == 0; }
+
+	// Calls func(processor) in ascending order
+	template <typename Func>
+	void ForEach(Func&& func) const
+	{
+		for (size_t word = 0; word < m_bits.size(); ++word)
+		{
+			uint64_t bits = m_bits[word];
+			while (bits != 0)
+			{
+				func((uint32_t)(word * 64 + std::countr_zero(bits)));
+				bits &= bits - 1;
+			}
+		}
+	}
+
+private:
+	std::vector<uint64_t> m_bits;
+};
+
+
+struct LogicalProcessor
+{
+	uint32_t core{ 0 };
+	uint32_t l3Domain{ 0 };
+	uint32_t numaNode{ 0 };
+
+	// 0 for the first hardware thread of its core
+	uint32_t smtIndex{ 0 };
+
+	// Higher is faster.  Only differs between cores on hybrid CPUs.
+	uint32_t efficiencyClass{ 0 };
+
+	// Processor group and number within the group on Windows, CPU number on Linux
+	uint16_t osGroup{ 0 };
+	uint32_t osIndex{ 0 };
+};
+
+
+struct CpuCore
+{
+	CpuSet processors;
+	uint32_t l3Domain{ 0 };
+	uint32_t numaNode{ 0 };
+	uint32_t efficiencyClass{ 0 };
+};
+
+
+// Physical cores, their SMT siblings, L3 cache domains and NUMA nodes, as reported by the OS
+// (GetLogicalProcessorInformationEx on Windows, /sys/devices/system/cpu on Linux).  Cores are
+// sorted fastest first, so on hybrid CPUs the performance cores come before the efficiency cores.
+// Logical processors are numbered core by core.
+class CpuTopology : NonCopyable, NonMovable
+{
+public:
+	CpuTopology();
+
+	uint32_t GetNumLogicalProcessors() const noexcept { return (uint32_t)m_processors.size(); }
+	uint32_t GetNumCores() const noexcept { return (uint32_t)m_cores.size(); }
+	uint32_t GetNumL3Domains() const noexcept { return m_numL3Domains; }
+	uint32_t GetNumNumaNodes() const noexcept { return m_numNumaNodes; }
+	bool IsHybrid() const noexcept { return m_isHybrid; }
+
+	const LogicalProcessor& GetLogicalProcessor(uint32_t processor) const { return m_processors[processor]; }
+	const CpuCore& GetCore(uint32_t core) const { return m_cores[core]; }
+
+private:
+	void Enumerate();
+	void Finalize();
+
+private:
+	std::vector<LogicalProcessor> m_processors;
+	std::vector<CpuCore> m_cores;
+	uint32_t m_numL3Domains{ 1 };
+	uint32_t m_numNumaNodes{ 1 };
+	bool m_isHybrid{ false };
+};
+
+const CpuTopology& GetCpuTopology();
+
+
+enum class ThreadAffinity
+{
+	// The OS schedules every thread anywhere
+	Float,
+	// The main and render threads get a core each, everything else shares the remaining cores
+	Group,
+	// As Group, with each job worker pinned to its own logical processor
+	Pin
+};
+
+inline std::string ThreadAffinityToString(ThreadAffinity threadAffinity)
+{
+	switch (threadAffinity)
+	{
+	case ThreadAffinity::Group:
+		return "Group";
+	case ThreadAffinity::Pin:
+		return "Pin";
+	default:
+		return "Float";
+	}
+}
+
+
+enum class ThreadRole
+{
+	Main,
+	Render,
+	JobWorker,
+	Log
+};
+
+
+// Decides where the engine's threads run, so the job workers and the log worker stay off the
+// cores the main and render threads use.  Job workers fill the first hardware thread of each
+// remaining core before doubling up on SMT siblings.  On hybrid CPUs the main and render threads
+// get performance cores and the log worker an efficiency core.
+class ThreadPlacement
+{
+public:
+	ThreadPlacement(const CpuTopology& topology, ThreadAffinity affinity, bool reserveRenderCore);
+
+	ThreadAffinity GetAffinity() const noexcept { return m_affinity; }
+
+	// One per logical processor left after the reserved cores, or 0 for the JobSystem default
+	uint32_t GetNumJobWorkers() const noexcept { return m_numJobWorkers; }
+
+	// Empty when the thread should float.  Job workers are numbered as JobSystem thread indices.
+	CpuSet GetCpuSet(ThreadRole role, uint32_t threadIndex = 0) const;
+
+private:
+	ThreadAffinity m_affinity{ ThreadAffinity::Float };
+	CpuSet m_mainSet;
+	CpuSet m_renderSet;
+	CpuSet m_workerSet;
+	CpuSet m_logSet;
+	std::vector<uint32_t> m_workerOrder;
+	uint32_t m_numJobWorkers{ 0 };
+};
+
+
+// Both return false, and leave the thread where it was, if the set is empty or the OS refuses.
+// On Windows a thread can only be confined to one processor group, the one with the most
+// processors from the set.
+bool SetThreadAffinity(std::thread& thread, const CpuSet& cpuSet);
+bool SetCurrentThreadAffinity(const CpuSet& cpuSet);
+
+} // namespace Kodiak
@@ -12,6 +12,8 @@
 
 #include "FileSystem.h"
 
+#include "JobSystem.h"
+
 
 using namespace Kodiak;
 using namespace std;
@@ -32,12 +34,17 @@ FileSystem::FileSystem(const string& appName)
 	: m_appName(appName)
 {
 	Initialize();
+	m_asyncReader = make_unique<AsyncFileReader>();
+	m_fileWatcher = make_unique<FileWatcher>([this](span<const FileChange> changes) { OnFilesChanged(changes); });
 	g_filesystem = this;
 }
 
 
 FileSystem::~FileSystem()
 {
+	// Stop the watcher thread before anything it calls back into goes away
+	m_fileWatcher.reset();
+
 	g_filesystem = nullptr;
 }
 
@@ -67,6 +74,8 @@ void FileSystem::SetRootPath(const string& rootPathStr)
 	}
 
 	RemoveAllSearchPaths();
+	InvalidateIndex();
+	UpdateWatchedDirectories();
 
 	m_rootPath = rootPathStr;
 	m_logPath = m_rootPath / "Logs";
@@ -83,6 +92,8 @@ void FileSystem::SetRootPath(const filesystem::path& rootPath)
 	}
 
 	RemoveAllSearchPaths();
+	InvalidateIndex();
+	UpdateWatchedDirectories();
 
 	m_rootPath = rootPath;
 	m_logPath = m_rootPath / "Logs";
@@ -91,26 +102,11 @@ void FileSystem::SetRootPath(const filesystem::path& rootPath)
 
 void FileSystem::AddSearchPath(const string& searchPathStr, bool appendPath)
 {
-	PathDesc* pathPtr = nullptr;
-	PathDesc* cur = m_searchPaths;
-	PathDesc* prev = nullptr;
-
 	const filesystem::path searchPath{ searchPathStr };
 
 	unique_lock<shared_mutex> CS(s_mutex);
 
-	while (cur)
-	{
-		if (cur->localPath == searchPath)
-		{
-			pathPtr = cur;
-			break;
-		}
-		prev = cur;
-		cur = cur->next;
-	}
-
-	if (pathPtr)
+	if (HasSearchPath(searchPath))
 	{
 		return;
 	}
@@ -127,22 +123,7 @@ void FileSystem::AddSearchPath(const string& searchPathStr, bool appendPath)
 	newPathDesc->localPath = searchPath;
 	newPathDesc->fullPath = fullSearchPath;
 
-	if (appendPath)
-	{
-		if (prev == nullptr)
-		{
-			m_searchPaths = newPathDesc;
-		}
-		else
-		{
-			prev->next = newPathDesc;
-		}
-	}
-	else
-	{
-		newPathDesc->next = m_searchPaths;
-		m_searchPaths = newPathDesc;
-	}
+	InsertSearchPath(newPathDesc, appendPath);
 }
 
 
@@ -173,6 +154,8 @@ void FileSystem::RemoveSearchPath(const string& searchPathStr)
 				prev->next = cur->next;
 			}
 			delete cur;
+			InvalidateIndex();
+			UpdateWatchedDirectories();
 			break;
 		}
 		prev = cur;
@@ -181,6 +164,53 @@ void FileSystem::RemoveSearchPath(const string& searchPathStr)
 }
 
 
+bool FileSystem::MountPackFile(const string& packPathStr, bool appendPath)
+{
+	const filesystem::path packPath{ packPathStr };
+
+	filesystem::path fullPackPath;
+	{
+		shared_lock<shared_mutex> CS(s_mutex);
+
+		if (HasSearchPath(packPath))
+		{
+			return true;
+		}
+		fullPackPath = packPath.is_absolute() ? packPath : m_rootPath / packPath;
+	}
+
+	// Map and validate the pack before taking the lock
+	auto mappedFile = MapFile(fullPackPath.string(), MapFileHint::None);
+	if (!mappedFile)
+	{
+		assert_msg(false, "Pack file %s could not be mapped.", fullPackPath.c_str());
+		return false;
+	}
+
+	auto pack = PackFileHandle::Create(new PackFile(fullPackPath.string(), mappedFile));
+	if (!pack->Initialize())
+	{
+		return false;
+	}
+
+	unique_lock<shared_mutex> CS(s_mutex);
+
+	if (HasSearchPath(packPath))
+	{
+		return true;
+	}
+
+	PathDesc* newPathDesc = new PathDesc;
+	newPathDesc->localPath = packPath;
+	newPathDesc->fullPath = fullPackPath;
+	newPathDesc->pack = pack;
+
+	InsertSearchPath(newPathDesc, appendPath);
+
+	return true;
+}
+
+
 vector<filesystem::path> FileSystem::GetSearchPaths() const
 {
 	shared_lock<shared_mutex> CS(s_mutex);
@@ -200,26 +230,19 @@ vector<filesystem::path> FileSystem::GetSearchPaths() const
 
 bool FileSystem::Exists(const string& fname) const
 {
-	const filesystem::path filePath{ fname };
-
-	shared_lock<shared_mutex> CS(s_mutex);
-
-	PathDesc* cur = m_searchPaths;
-	while (cur)
-	{
-		auto fullPath = cur->fullPath / filePath;
-		if (filesystem::exists(fullPath))
-		{
-			return true;
-		}
-		cur = cur->next;
-	}
-	return false;
+	return FindFile(fname, nullptr);
 }
 
 
 bool FileSystem::IsRegularFile(const string& fname) const
 {
+	FileInfo info{};
+	if (FindFile(fname, &info))
+	{
+		return !info.isDirectory;
+	}
+
+	// Not beneath a search path, check it as a plain path
 	const filesystem::path filePath{ fname };
 
 	shared_lock<shared_mutex> CS(s_mutex);
@@ -249,19 +272,10 @@ bool FileSystem::IsDirectory(const string& dname) const
 
 string FileSystem::GetFullPath(const string& fname)
 {
-	const filesystem::path filePath{ fname };
-
-	shared_lock<shared_mutex> CS(s_mutex);
-
-	PathDesc* cur = m_searchPaths;
-	while (cur)
+	FileInfo info{};
+	if (FindFile(fname, &info))
 	{
-		auto fullPath = cur->fullPath / filePath;
-		if (filesystem::exists(fullPath))
-		{
-			return fullPath.string();
-		}
-		cur = cur->next;
+		return info.fullPath;
 	}
 	return "";
 }
@@ -277,6 +291,199 @@ string FileSystem::GetFileExtension(const string& fname)
 }
 
 
+bool FileSystem::GetFileInfo(const string& fname, FileInfo& info) const
+{
+	return FindFile(fname, &info);
+}
+
+
+MappedFileHandle FileSystem::MapFile(const string& fname, MapFileHint hints) const
+{
+	ALLOCATION_TAG(FileSystem);
+
+	FileInfo info{};
+	if (!FindFile(fname, &info) || info.isDirectory)
+	{
+		return nullptr;
+	}
+
+	if (info.pack)
+	{
+		return info.pack->MapEntry(info.packEntry);
+	}
+
+	const DWORD accessFlags = HasFlag(hints, MapFileHint::Sequential) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+	ScopedHandle fileHandle{ SafeHandle(CreateFileA(info.fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | accessFlags, nullptr)) };
+	if (!fileHandle)
+	{
+		LogWarning(LogFileSystem) << "Failed to open " << info.fullPath << " for mapping.  Error code: " << GetLastError() << endl;
+		return nullptr;
+	}
+
+	LARGE_INTEGER fileSize{};
+	GetFileSizeEx(fileHandle.get(), &fileSize);
+	if (fileSize.QuadPart == 0)
+	{
+		// Empty files can't be mapped, return an empty view
+		return MappedFileHandle::Create(new MappedFile());
+	}
+
+	// The view keeps the mapping and the file open, so both handles can be closed once it exists
+	ScopedHandle mappingHandle{ CreateFileMappingA(fileHandle.get(), nullptr, PAGE_READONLY, 0, 0, nullptr) };
+	if (!mappingHandle)
+	{
+		LogWarning(LogFileSystem) << "Failed to create file mapping for " << info.fullPath << ".  Error code: " << GetLastError() << endl;
+		return nullptr;
+	}
+
+	void* view = MapViewOfFile(mappingHandle.get(), FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		LogWarning(LogFileSystem) << "Failed to map view of " << info.fullPath << ".  Error code: " << GetLastError() << endl;
+		return nullptr;
+	}
+
+	if (HasFlag(hints, MapFileHint::WillNeed))
+	{
+		WIN32_MEMORY_RANGE_ENTRY range{ view, (SIZE_T)fileSize.QuadPart };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+
+	return MappedFileHandle::Create(new MappedFile(reinterpret_cast<const std::byte*>(view), (size_t)fileSize.QuadPart));
+}
+
+
+AsyncReadHandle FileSystem::ReadAsync(const string& fname, uint64_t offset, size_t size, void* destination) const
+{
+	ALLOCATION_TAG(FileSystem);
+
+	FileInfo info{};
+	if (!FindFile(fname, &info) || info.isDirectory)
+	{
+		return AsyncFileReader::MakeFailedRead(ERROR_FILE_NOT_FOUND);
+	}
+
+	if (info.pack)
+	{
+		// Clamp to the entry, so reads can't run into the next payload
+		const PackEntry& entry = info.pack->GetEntry(info.packEntry);
+		const uint64_t readOffset = std::min(offset, entry.size);
+		const size_t readSize = (size_t)std::min<uint64_t>(size, entry.size - readOffset);
+
+		if (info.pack->IsCompressed(info.packEntry))
+		{
+			// Decompression can't be done by the file system, decode the blocks on the thread pool
+			return m_asyncReader->Execute(
+				[pack = info.pack, packEntry = info.packEntry, readOffset, readSize, destination](size_t& bytesRead) -> uint32_t
+				{
+					if (!pack->ReadEntry(packEntry, readOffset, { static_cast<byte*>(destination), readSize }))
+					{
+						return ERROR_INVALID_DATA;
+					}
+					bytesRead = readSize;
+					return ERROR_SUCCESS;
+				});
+		}
+
+		return m_asyncReader->Read(info.pack->GetPath(), entry.dataOffset + readOffset, readSize, destination);
+	}
+
+	return m_asyncReader->Read(info.fullPath, offset, size, destination);
+}
+
+
+vector<AsyncReadHandle> FileSystem::ReadAsync(span<const AsyncReadDesc> reads) const
+{
+	ALLOCATION_TAG(FileSystem);
+
+	vector<AsyncReadHandle> handles;
+	handles.reserve(reads.size());
+
+	for (const auto& read : reads)
+	{
+		handles.push_back(ReadAsync(read.fname, read.offset, read.size, read.destination));
+	}
+
+	return handles;
+}
+
+
+void FileSystem::EnableFileWatching(bool enable)
+{
+	unique_lock<shared_mutex> CS(s_mutex);
+
+	if (m_fileWatchingEnabled == enable)
+	{
+		return;
+	}
+
+	m_fileWatchingEnabled = enable;
+
+	if (enable)
+	{
+		UpdateWatchedDirectories();
+	}
+	else
+	{
+		m_fileWatcher->Watch({});
+	}
+}
+
+
+void FileSystem::RebuildIndex()
+{
+	{
+		unique_lock<shared_mutex> CS(s_mutex);
+		InvalidateIndex();
+	}
+
+	EnsureIndex();
+}
+
+
+string FileSystem::NormalizePath(const string& pathStr)
+{
+	string normalized;
+	normalized.reserve(pathStr.size());
+
+	for (char c : pathStr)
+	{
+		if (c == '\\')
+		{
+			c = '/';
+		}
+		normalized.push_back((char)::tolower((unsigned char)c));
+	}
+
+	// Most names have no "." or ".." segments or doubled separators, skip the path round trip for them
+	const bool needsLexicalNormal = normalized.starts_with('.')
+		|| normalized.find("/.") != string::npos
+		|| normalized.find("//") != string::npos;
+	if (needsLexicalNormal)
+	{
+		normalized = filesystem::path{ normalized }.lexically_normal().generic_string();
+		if (normalized == ".")
+		{
+			return "";
+		}
+	}
+
+	size_t firstChar = normalized.find_first_not_of('/');
+	if (firstChar == string::npos)
+	{
+		return "";
+	}
+	normalized.erase(0, firstChar);
+
+	while (normalized.ends_with('/'))
+	{
+		normalized.pop_back();
+	}
+
+	return normalized;
+}
+
+
 bool FileSystem::EnsureDirectory(const string& pathStr)
 {
 	shared_lock<shared_mutex> CS(s_mutex);
@@ -317,6 +524,43 @@ void FileSystem::Initialize()
 }
 
 
+// Caller must hold s_mutex
+bool FileSystem::HasSearchPath(const filesystem::path& localPath) const
+{
+	for (PathDesc* cur = m_searchPaths; cur != nullptr; cur = cur->next)
+	{
+		if (cur->localPath == localPath)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// Caller must hold s_mutex exclusively
+void FileSystem::InsertSearchPath(PathDesc* newPathDesc, bool appendPath)
+{
+	if (appendPath)
+	{
+		PathDesc** tail = &m_searchPaths;
+		while (*tail != nullptr)
+		{
+			tail = &(*tail)->next;
+		}
+		*tail = newPathDesc;
+	}
+	else
+	{
+		newPathDesc->next = m_searchPaths;
+		m_searchPaths = newPathDesc;
+	}
+
+	InvalidateIndex();
+	UpdateWatchedDirectories();
+}
+
+
 void FileSystem::RemoveAllSearchPaths()
 {
 	PathDesc* cur = m_searchPaths;
@@ -330,6 +574,499 @@ void FileSystem::RemoveAllSearchPaths()
 }
 
 
+bool FileSystem::FindFile(const string& fname, FileInfo* info) const
+{
+	ALLOCATION_TAG(FileSystem);
+
+	// Fast path, previously resolved
+	{
+		// Copy the entry under the cache lock, which erasing an index entry also has to take.  The
+		// const visit takes it shared, m_resolvedPaths is mutable and would pick the exclusive one.
+		bool found{ false };
+		const bool cached = std::as_const(m_resolvedPaths).visit(fname,
+			[info, &found](const FileInfo* entry)
+			{
+				if (entry && info)
+				{
+					*info = *entry;
+				}
+				found = entry != nullptr;
+			});
+
+		if (cached)
+		{
+			return found;
+		}
+	}
+
+	// Absolute paths aren't beneath a search path
+	const filesystem::path filePath{ fname };
+	if (filePath.is_absolute())
+	{
+		if (FindInPackFiles(filePath, info))
+		{
+			return true;
+		}
+
+		error_code ec;
+		auto status = filesystem::status(filePath, ec);
+		if (!filesystem::exists(status))
+		{
+			return false;
+		}
+
+		if (info)
+		{
+			info->fullPath = filePath.string();
+			info->isDirectory = filesystem::is_directory(status);
+			info->size = info->isDirectory ? 0 : filesystem::file_size(filePath, ec);
+			info->lastWriteTime = filesystem::last_write_time(filePath, ec);
+		}
+		return true;
+	}
+
+	const string key = NormalizePath(fname);
+
+	for (;;)
+	{
+		EnsureIndex();
+
+		// Hold the search path lock until the result is cached, so a concurrent
+		// search path change can't leave a stale entry behind
+		shared_lock<shared_mutex> CS(s_mutex);
+
+		if (m_indexDirty)
+		{
+			// Search paths changed again before we got the lock
+			continue;
+		}
+
+		const FileInfo* entry{ nullptr };
+		auto it = m_index.find(key);
+		if (it != m_index.end())
+		{
+			entry = &it->second;
+		}
+
+		if (entry == nullptr && (key.starts_with("../") || key == ".."))
+		{
+			// Names that climb out of the search paths ("../shared/x") aren't indexed.  Look on
+			// disk, like before there was an index, and don't cache the result: there's no index
+			// entry to point at, and nothing watches those directories to invalidate it.
+			FileInfo probedInfo{};
+			if (!ProbeSearchPaths(key, filePath, probedInfo))
+			{
+				return false;
+			}
+
+			if (info)
+			{
+				*info = move(probedInfo);
+			}
+			return true;
+		}
+
+		// Anything else missing from the index doesn't exist, so cache the miss too.  The watcher
+		// clears cached misses when files change, without it RebuildIndex picks up new files.
+		m_resolvedPaths.insert(fname, entry);
+
+		if (entry && info)
+		{
+			*info = *entry;
+		}
+		return entry != nullptr;
+	}
+}
+
+
+bool FileSystem::FindInPackFiles(const filesystem::path& filePath, FileInfo* info) const
+{
+	shared_lock<shared_mutex> CS(s_mutex);
+
+	for (PathDesc* cur = m_searchPaths; cur != nullptr; cur = cur->next)
+	{
+		if (!cur->pack)
+		{
+			continue;
+		}
+
+		const auto relativePath = filePath.lexically_relative(cur->fullPath);
+		if (relativePath.empty() || *relativePath.begin() == "..")
+		{
+			continue;
+		}
+
+		uint32_t index = 0;
+		if (cur->pack->Find(NormalizePath(relativePath.string()), index))
+		{
+			if (info)
+			{
+				error_code ec;
+				info->fullPath = filePath.string();
+				info->size = cur->pack->GetEntry(index).size;
+				info->lastWriteTime = filesystem::last_write_time(cur->fullPath, ec);
+				info->isDirectory = false;
+				info->pack = cur->pack;
+				info->packEntry = index;
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void FileSystem::EnsureIndex() const
+{
+	ALLOCATION_TAG(FileSystem);
+
+	for (;;)
+	{
+		// Walk a copy of the search paths without holding s_mutex.  The walk runs on the JobSystem,
+		// and while this thread waits for it, it runs other jobs, which may call back in here.
+		vector<IndexSource> sources;
+		uint64_t generation = 0;
+		{
+			shared_lock<shared_mutex> CS(s_mutex);
+			if (!m_indexDirty)
+			{
+				return;
+			}
+
+			for (PathDesc* cur = m_searchPaths; cur != nullptr; cur = cur->next)
+			{
+				sources.push_back({ cur->fullPath, cur->pack });
+			}
+			generation = m_indexGeneration;
+			m_numIndexBuilds.fetch_add(1);
+		}
+
+		auto index = BuildIndex(sources);
+
+		unique_lock<shared_mutex> CS(s_mutex);
+		m_numIndexBuilds.fetch_sub(1);
+
+		// Another thread got there first, or the search paths changed underneath the walk
+		if (!m_indexDirty || generation != m_indexGeneration)
+		{
+			continue;
+		}
+
+		m_index = move(index);
+		m_indexDirty = false;
+
+		const vector<FileChange> changes = move(m_deferredChanges);
+		m_deferredChanges.clear();
+		ApplyFileChanges(changes);
+	}
+}
+
+
+// Called without s_mutex held
+unordered_map<string, FileInfo> FileSystem::BuildIndex(span<const IndexSource> sources)
+{
+	ALLOCATION_TAG(FileSystem);
+
+	struct IndexWorkItem
+	{
+		uint32_t searchPathIndex{ 0 };
+		size_t rootLength{ 0 };
+		filesystem::path directory;
+		vector<pair<string, FileInfo>> entries;
+	};
+
+	auto makeEntry = [](const filesystem::directory_entry& dirEntry, size_t rootLength)
+	{
+		error_code ec;
+
+		string fullPath = dirEntry.path().string();
+		string key = NormalizePath(fullPath.substr(rootLength));
+
+		FileInfo info{};
+		info.isDirectory = dirEntry.is_directory(ec);
+		info.size = info.isDirectory ? 0 : dirEntry.file_size(ec);
+		info.lastWriteTime = dirEntry.last_write_time(ec);
+		info.fullPath = move(fullPath);
+
+		return make_pair(move(key), move(info));
+	};
+
+	// Split the walk into one work item per search path, plus one per top-level subdirectory
+	vector<IndexWorkItem> workItems;
+
+	for (uint32_t searchPathIndex = 0; searchPathIndex < (uint32_t)sources.size(); ++searchPathIndex)
+	{
+		const IndexSource& source = sources[searchPathIndex];
+
+		IndexWorkItem rootItem{};
+		rootItem.searchPathIndex = searchPathIndex;
+		rootItem.rootLength = source.fullPath.string().size();
+
+		error_code ec;
+
+		// Pack contents come straight from the mapped table of contents
+		if (source.pack)
+		{
+			const PackFile* pack = source.pack.Get();
+			const auto packWriteTime = filesystem::last_write_time(source.fullPath, ec);
+
+			rootItem.entries.reserve(pack->GetNumEntries());
+			for (uint32_t i = 0; i < pack->GetNumEntries(); ++i)
+			{
+				string name{ pack->GetName(i) };
+
+				FileInfo info{};
+				info.fullPath = (source.fullPath / name).string();
+				info.size = pack->GetEntry(i).size;
+				info.lastWriteTime = packWriteTime;
+				info.pack = source.pack;
+				info.packEntry = i;
+
+				rootItem.entries.emplace_back(move(name), move(info));
+			}
+
+			workItems.emplace_back(move(rootItem));
+			continue;
+		}
+
+		// Advance with increment(ec), the operator++ behind a range-for throws when a directory
+		// vanishes or can't be read mid-walk, and an exception escaping a job ends the process
+		for (filesystem::directory_iterator it{ source.fullPath, filesystem::directory_options::skip_permission_denied, ec }, end; !ec && it != end; it.increment(ec))
+		{
+			rootItem.entries.emplace_back(makeEntry(*it, rootItem.rootLength));
+
+			error_code dirEc;
+			if (it->is_directory(dirEc))
+			{
+				IndexWorkItem dirItem{};
+				dirItem.searchPathIndex = searchPathIndex;
+				dirItem.rootLength = rootItem.rootLength;
+				dirItem.directory = it->path();
+				workItems.emplace_back(move(dirItem));
+			}
+		}
+
+		workItems.emplace_back(move(rootItem));
+	}
+
+	ParallelFor(0, workItems.size(), 1,
+		[&workItems, &makeEntry](size_t i)
+		{
+			IndexWorkItem& item = workItems[i];
+			if (item.directory.empty())
+			{
+				return;
+			}
+
+			error_code ec;
+			for (filesystem::recursive_directory_iterator it{ item.directory, filesystem::directory_options::skip_permission_denied, ec }, end; !ec && it != end; it.increment(ec))
+			{
+				item.entries.emplace_back(makeEntry(*it, item.rootLength));
+			}
+		});
+
+	// Merge in search path priority order, so the first search path containing a name wins
+	stable_sort(workItems.begin(), workItems.end(),
+		[](const IndexWorkItem& a, const IndexWorkItem& b) { return a.searchPathIndex < b.searchPathIndex; });
+
+	size_t numEntries = 0;
+	for (const auto& item : workItems)
+	{
+		numEntries += item.entries.size();
+	}
+
+	unordered_map<string, FileInfo> index;
+	index.reserve(numEntries);
+	for (auto& item : workItems)
+	{
+		for (auto& entry : item.entries)
+		{
+			index.emplace(move(entry));
+		}
+	}
+
+	return index;
+}
+
+
+// Caller must hold s_mutex exclusively
+void FileSystem::InvalidateIndex() const
+{
+	m_resolvedPaths.clear();
+
+	m_index.clear();
+	m_indexDirty = true;
+
+	// Changes seen so far are on disk by now, where the next walk will find them
+	++m_indexGeneration;
+	m_deferredChanges.clear();
+}
+
+
+// Caller must hold s_mutex
+bool FileSystem::ProbeSearchPaths(string_view name, const filesystem::path& relativePath, FileInfo& info) const
+{
+	// Same priority order as BuildIndex, the first search path containing the name wins
+	for (PathDesc* cur = m_searchPaths; cur != nullptr; cur = cur->next)
+	{
+		if (cur->pack)
+		{
+			uint32_t index = 0;
+			if (cur->pack->Find(name, index))
+			{
+				error_code ec;
+				info = FileInfo{};
+				info.fullPath = (cur->fullPath / string{ cur->pack->GetName(index) }).string();
+				info.size = cur->pack->GetEntry(index).size;
+				info.lastWriteTime = filesystem::last_write_time(cur->fullPath, ec);
+				info.pack = cur->pack;
+				info.packEntry = index;
+				return true;
+			}
+			continue;
+		}
+
+		error_code ec;
+		const filesystem::directory_entry dirEntry{ cur->fullPath / relativePath, ec };
+		if (!dirEntry.exists(ec))
+		{
+			continue;
+		}
+
+		info = FileInfo{};
+		info.fullPath = dirEntry.path().string();
+		info.isDirectory = dirEntry.is_directory(ec);
+		info.size = info.isDirectory ? 0 : dirEntry.file_size(ec);
+		info.lastWriteTime = dirEntry.last_write_time(ec);
+		return true;
+	}
+
+	return false;
+}
+
+
+// Called on the file watcher thread
+void FileSystem::OnFilesChanged(span<const FileChange> changes)
+{
+	ALLOCATION_TAG(FileSystem);
+
+	unique_lock<shared_mutex> CS(s_mutex);
+
+	if (m_indexDirty)
+	{
+		// Nothing to patch.  A walk in progress may have passed these files already, so hold on
+		// to them for it, otherwise the next lookup's walk sees them anyway.
+		if (m_numIndexBuilds.load() != 0)
+		{
+			m_deferredChanges.insert(m_deferredChanges.end(), changes.begin(), changes.end());
+		}
+		return;
+	}
+
+	ApplyFileChanges(changes);
+}
+
+
+// Caller must hold s_mutex exclusively
+void FileSystem::ApplyFileChanges(span<const FileChange> changes) const
+{
+	bool needsRebuild = false;
+
+	for (const auto& change : changes)
+	{
+		if (change.type == FileChangeType::Rescan)
+		{
+			needsRebuild = true;
+			break;
+		}
+
+		auto it = m_index.find(change.name);
+
+		FileInfo info{};
+		const bool found = ProbeSearchPaths(change.name, change.relativePath, info);
+
+		// Cached async read handles may still point at the old file (save by rename)
+		if (it != m_index.end())
+		{
+			m_asyncReader->InvalidateFile(it->second.fullPath);
+		}
+		if (found && (it == m_index.end() || info.fullPath != it->second.fullPath))
+		{
+			m_asyncReader->InvalidateFile(info.fullPath);
+		}
+
+		// A directory appearing, disappearing or moving changes everything beneath it, and only
+		// the directory itself is reported.  Contents changing just touches its write time.
+		const bool wasDirectory = (it != m_index.end()) && it->second.isDirectory;
+		const bool isDirectory = found && info.isDirectory;
+		if (wasDirectory || isDirectory)
+		{
+			if (change.type == FileChangeType::Modified && wasDirectory == isDirectory)
+			{
+				continue;
+			}
+			needsRebuild = true;
+			break;
+		}
+
+		if (found)
+		{
+			if (it != m_index.end())
+			{
+				// FindFile copies cached entries holding only the cache's shard lock, so unlink the
+				// entry from the cache (which waits out any copy in progress) before rewriting it
+				const FileInfo* changedEntry = &it->second;
+				m_resolvedPaths.erase_if([changedEntry](const auto& resolved) { return resolved.second == changedEntry; });
+				it->second = move(info);
+			}
+			else
+			{
+				m_index.emplace(change.name, move(info));
+			}
+		}
+		else if (it != m_index.end())
+		{
+			const FileInfo* removedEntry = &it->second;
+			m_resolvedPaths.erase_if([removedEntry](const auto& resolved) { return resolved.second == removedEntry; });
+			m_index.erase(it);
+		}
+	}
+
+	if (needsRebuild)
+	{
+		m_asyncReader->InvalidateAllFiles();
+		InvalidateIndex();
+		return;
+	}
+
+	// Names that didn't resolve before may resolve now
+	m_resolvedPaths.erase_if([](const auto& resolved) { return resolved.second == nullptr; });
+}
+
+
+// Caller must hold s_mutex
+void FileSystem::UpdateWatchedDirectories()
+{
+	if (!m_fileWatchingEnabled)
+	{
+		return;
+	}
+
+	// Packs can't change underneath us, they are mapped and opened without write sharing
+	vector<filesystem::path> directories;
+	for (PathDesc* cur = m_searchPaths; cur != nullptr; cur = cur->next)
+	{
+		if (!cur->pack)
+		{
+			directories.push_back(cur->fullPath);
+		}
+	}
+
+	m_fileWatcher->Watch(directories);
+}
+
+
 Kodiak::FileSystem* Kodiak::GetFileSystem()
 {
 	return g_filesystem;
@@ -10,9 +10,30 @@
 
 #pragma once
 
+#include "Core\FlatHashMap.h"
+
+#include "AsyncFileReader.h"
+#include "FileWatcher.h"
+#include "MappedFile.h"
+#include "PackFile.h"
+
+
 namespace Kodiak
 {
 
+struct FileInfo
+{
+	std::string fullPath;
+	uint64_t size{ 0 };
+	std::filesystem::file_time_type lastWriteTime{};
+	bool isDirectory{ false };
+
+	// Set when the file lives inside a mounted pack
+	PackFileHandle pack;
+	uint32_t packEntry{ 0 };
+};
+
+
 class FileSystem : NonCopyable, NonMovable
 {
 public:
@@ -31,6 +52,10 @@ public:
 	void AddSearchPath(const std::string& searchPathStr, bool appendPath = false);
 	void RemoveSearchPath(const std::string& searchPathStr);
 
+	// Mounts a pack file as a search path.  Files inside the pack resolve like files beneath a
+	// search path directory, with the same priority rules.  Unmount it with RemoveSearchPath.
+	bool MountPackFile(const std::string& packPathStr, bool appendPath = false);
+
 	std::vector<std::filesystem::path> GetSearchPaths() const;
 
 	bool Exists(const std::string& fname) const;
@@ -38,13 +63,55 @@ public:
 	bool IsDirectory(const std::string& dname) const;
 	std::string GetFullPath(const std::string& pathStr);
 	std::string GetFileExtension(const std::string& fname);
+	bool GetFileInfo(const std::string& fname, FileInfo& info) const;
+
+	// Maps a file beneath the search paths read-only.  Returns nullptr if the file can't be found or mapped.
+	MappedFileHandle MapFile(const std::string& fname, MapFileHint hints = MapFileHint::None) const;
+
+	// Reads size bytes at offset into destination without blocking.  The destination must stay
+	// valid until the returned read completes.  Names that can't be found, and reads over 4GB,
+	// return a failed read.
+	AsyncReadHandle ReadAsync(const std::string& fname, uint64_t offset, size_t size, void* destination) const;
+	// Submits every read in the list before returning, so they are all in flight together
+	std::vector<AsyncReadHandle> ReadAsync(std::span<const AsyncReadDesc> reads) const;
+
+	// The search path index is rebuilt lazily after search path changes.  Call this
+	// to pick up files created or removed beneath the search paths since the last build.
+	void RebuildIndex();
+
+	// Watches the search path directories for changes.  Changed files are updated in the index
+	// without a full rebuild, then subscribers are notified.  Callbacks run on the watcher thread.
+	void EnableFileWatching(bool enable);
+	bool IsFileWatchingEnabled() const { return m_fileWatchingEnabled; }
+	uint32_t SubscribeToFileChanges(FileChangeCallback callback) { return m_fileWatcher->Subscribe(std::move(callback)); }
+	void UnsubscribeFromFileChanges(uint32_t subscriptionId) { m_fileWatcher->Unsubscribe(subscriptionId); }
+
+	// Lowercase, forward slashes, no leading or trailing separator, and "." and ".." segments
+	// resolved lexically.  A ".." that climbs above the start is kept.
+	static std::string NormalizePath(const std::string& pathStr);
 
 	bool EnsureDirectory(const std::string& pathStr);
 	bool EnsureLogDirectory();
 
 private:
+	struct PathDesc;
+
 	void Initialize();
 	void RemoveAllSearchPaths();
+	bool HasSearchPath(const std::filesystem::path& localPath) const;
+	void InsertSearchPath(PathDesc* newPathDesc, bool appendPath);
+
+	bool FindFile(const std::string& fname, FileInfo* info) const;
+	bool FindInPackFiles(const std::filesystem::path& filePath, FileInfo* info) const;
+	struct IndexSource;
+
+	void EnsureIndex() const;
+	static std::unordered_map<std::string, FileInfo> BuildIndex(std::span<const IndexSource> sources);
+	void InvalidateIndex() const;
+	bool ProbeSearchPaths(std::string_view name, const std::filesystem::path& relativePath, FileInfo& info) const;
+	void OnFilesChanged(std::span<const FileChange> changes);
+	void ApplyFileChanges(std::span<const FileChange> changes) const;
+	void UpdateWatchedDirectories();
 
 private:
 	std::string m_appName;
@@ -59,11 +126,49 @@ private:
 	{
 		std::filesystem::path localPath;
 		std::filesystem::path fullPath;
+		PackFileHandle pack;
 		PathDesc* next{ nullptr };
 	};
 	PathDesc* m_searchPaths{ nullptr };
+
+	// A search path as the index build sees it.  Copied out of the list, so the directory walk
+	// can run without holding the search path lock.
+	struct IndexSource
+	{
+		std::filesystem::path fullPath;
+		PackFileHandle pack;
+	};
+
+	std::unique_ptr<AsyncFileReader> m_asyncReader;
+
+	std::unique_ptr<FileWatcher> m_fileWatcher;
+	bool m_fileWatchingEnabled{ false };
+
+	// Normalized relative path -> file entry from the highest priority search path.
+	// Built in one parallel directory walk the first time it is needed after the
+	// search paths or the root path change.
+	mutable std::unordered_map<std::string, FileInfo> m_index;
+	mutable bool m_indexDirty{ true };
+
+	// The walk runs unlocked.  Bumped whenever the search paths change, so a walk of the old
+	// ones is thrown away instead of installed.
+	mutable uint64_t m_indexGeneration{ 0 };
+
+	// Walks in progress, and the file changes seen meanwhile.  The walk may already have passed
+	// a changed file, so the changes are replayed on the index it builds.
+	mutable std::atomic<uint32_t> m_numIndexBuilds{ 0 };
+	mutable std::vector<FileChange> m_deferredChanges;
+
+	// Relative name as passed in -> index entry, or nullptr if the name was not found.
+	// Cleared whenever the index is invalidated.  Sharded, so concurrent lookups of
+	// different names don't serialize on one lock.  m_index stays node based, since
+	// this cache points into it.
+	mutable ConcurrentFlatHashMap<std::string, const FileInfo*> m_resolvedPaths;
 };
 
 FileSystem* GetFileSystem();
 
+
+inline LogCategory LogFileSystem{ "LogFileSystem" };
+
 } // namespace Kodiak
@@ -0,0 +1,389 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "FileWatcher.h"
+
+#include "FileSystem.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+constexpr ULONG_PTR s_quitKey{ 1 };
+constexpr ULONG_PTR s_updateKey{ 2 };
+
+// How long shutdown waits for cancelled reads to drain
+constexpr DWORD s_shutdownTimeoutMs{ 1000 };
+
+constexpr DWORD s_notifyFilter{ FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE |
+	FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION };
+
+} // anonymous namespace
+
+
+struct FileWatcher::WatchedDirectory
+{
+	OVERLAPPED overlapped{};
+	filesystem::path path;
+	HANDLE handle{ INVALID_HANDLE_VALUE };
+	bool readPending{ false };
+
+	// ReadDirectoryChangesW requires DWORD alignment, and fails over the network above 64KB
+	alignas(DWORD) byte buffer[64 * 1024];
+};
+
+
+FileWatcher::FileWatcher(FileChangeCallback onChanges)
+	: m_onChanges{ move(onChanges) }
+{
+	m_completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+	if (m_completionPort == nullptr)
+	{
+		LogWarning(LogFileSystem) << "Failed to create I/O completion port, file watching is disabled.  Error code: " << GetLastError() << endl;
+		return;
+	}
+
+	m_watcherLoop = async(launch::async, [this] { WatcherLoop(); });
+}
+
+
+FileWatcher::~FileWatcher()
+{
+	if (m_completionPort == nullptr)
+	{
+		return;
+	}
+
+	PostQueuedCompletionStatus(m_completionPort, 0, s_quitKey, nullptr);
+	m_watcherLoop.get();
+
+	// Reads that never reported their cancellation may still write to their buffers, so leak them
+	for (auto& dir : m_retiredDirectories)
+	{
+		dir.release();
+	}
+	m_retiredDirectories.clear();
+
+	CloseHandle(m_completionPort);
+	m_completionPort = nullptr;
+}
+
+
+void FileWatcher::Watch(const vector<filesystem::path>& directories)
+{
+	if (m_completionPort == nullptr)
+	{
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock(m_watchMutex);
+		m_requestedDirectories = directories;
+	}
+
+	PostQueuedCompletionStatus(m_completionPort, 0, s_updateKey, nullptr);
+}
+
+
+uint32_t FileWatcher::Subscribe(FileChangeCallback callback)
+{
+	lock_guard<mutex> lock(m_subscriberMutex);
+
+	const uint32_t subscriptionId = m_nextSubscriptionId++;
+	m_subscribers.emplace(subscriptionId, move(callback));
+
+	return subscriptionId;
+}
+
+
+void FileWatcher::Unsubscribe(uint32_t subscriptionId)
+{
+	lock_guard<mutex> lock(m_subscriberMutex);
+
+	m_subscribers.erase(subscriptionId);
+}
+
+
+void FileWatcher::WatcherLoop()
+{
+	bool quitting = false;
+
+	while (!quitting || !m_retiredDirectories.empty())
+	{
+		DWORD timeout = INFINITE;
+		if (quitting)
+		{
+			timeout = s_shutdownTimeoutMs;
+		}
+		else if (!m_pendingChanges.empty() || m_pendingRescan)
+		{
+			// Wait out the rest of the debounce interval
+			const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - m_lastEventTime).count();
+			const DWORD debounceMs = m_debounceMs.load(memory_order_relaxed);
+			timeout = (elapsed >= (long long)debounceMs) ? 0 : debounceMs - (DWORD)elapsed;
+		}
+
+		DWORD bytesTransferred{ 0 };
+		ULONG_PTR completionKey{ 0 };
+		OVERLAPPED* overlapped{ nullptr };
+
+		const BOOL result = GetQueuedCompletionStatus(m_completionPort, &bytesTransferred, &completionKey, &overlapped, timeout);
+
+		if (overlapped == nullptr)
+		{
+			if (result && completionKey == s_quitKey)
+			{
+				quitting = true;
+				lock_guard<mutex> lock(m_watchMutex);
+				m_requestedDirectories.clear();
+				UpdateWatchedDirectories();
+			}
+			else if (result && completionKey == s_updateKey)
+			{
+				if (!quitting)
+				{
+					lock_guard<mutex> lock(m_watchMutex);
+					UpdateWatchedDirectories();
+				}
+			}
+			else if (quitting)
+			{
+				// Timed out waiting for cancelled reads
+				break;
+			}
+			else
+			{
+				// No new events for the debounce interval
+				PublishChanges();
+			}
+			continue;
+		}
+
+		WatchedDirectory* dir = CONTAINING_RECORD(overlapped, WatchedDirectory, overlapped);
+		dir->readPending = false;
+
+		auto retired = find_if(m_retiredDirectories.begin(), m_retiredDirectories.end(), [dir](const auto& retiredDir) { return retiredDir.get() == dir; });
+		if (retired != m_retiredDirectories.end())
+		{
+			m_retiredDirectories.erase(retired);
+			continue;
+		}
+
+		m_lastEventTime = chrono::steady_clock::now();
+
+		if (!result)
+		{
+			// Usually the watched directory itself was deleted
+			LogWarning(LogFileSystem) << "Stopped watching " << dir->path.string() << ".  Error code: " << GetLastError() << endl;
+			m_pendingRescan = true;
+			continue;
+		}
+
+		if (bytesTransferred == 0)
+		{
+			// The buffer overflowed and the changes were lost
+			m_pendingRescan = true;
+		}
+		else
+		{
+			CollectChanges(dir, bytesTransferred);
+		}
+
+		IssueRead(dir);
+	}
+}
+
+
+// Caller must hold m_watchMutex
+void FileWatcher::UpdateWatchedDirectories()
+{
+	const auto& requested = m_requestedDirectories;
+
+	// Stop watching directories that are no longer requested
+	for (auto it = m_directories.begin(); it != m_directories.end();)
+	{
+		if (find(requested.begin(), requested.end(), (*it)->path) != requested.end())
+		{
+			++it;
+			continue;
+		}
+
+		auto& dir = *it;
+		CancelIoEx(dir->handle, &dir->overlapped);
+		CloseHandle(dir->handle);
+		dir->handle = INVALID_HANDLE_VALUE;
+
+		// The buffer has to live until the cancelled read completes
+		if (dir->readPending)
+		{
+			m_retiredDirectories.emplace_back(move(dir));
+		}
+		it = m_directories.erase(it);
+	}
+
+	// Start watching new ones
+	for (const auto& path : requested)
+	{
+		auto watched = find_if(m_directories.begin(), m_directories.end(), [&path](const auto& dir) { return dir->path == path; });
+		if (watched != m_directories.end())
+		{
+			continue;
+		}
+
+		auto dir = make_unique<WatchedDirectory>();
+		dir->path = path;
+		dir->handle = CreateFileW(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (dir->handle == INVALID_HANDLE_VALUE)
+		{
+			LogWarning(LogFileSystem) << "Failed to watch " << path.string() << ".  Error code: " << GetLastError() << endl;
+			continue;
+		}
+
+		CreateIoCompletionPort(dir->handle, m_completionPort, 0, 0);
+
+		if (IssueRead(dir.get()))
+		{
+			m_directories.emplace_back(move(dir));
+		}
+		else
+		{
+			CloseHandle(dir->handle);
+		}
+	}
+}
+
+
+bool FileWatcher::IssueRead(WatchedDirectory* dir)
+{
+	if (!ReadDirectoryChangesW(dir->handle, dir->buffer, (DWORD)sizeof(dir->buffer), TRUE, s_notifyFilter, nullptr, &dir->overlapped, nullptr))
+	{
+		LogWarning(LogFileSystem) << "Failed to read changes to " << dir->path.string() << ".  Error code: " << GetLastError() << endl;
+		return false;
+	}
+
+	dir->readPending = true;
+	return true;
+}
+
+
+void FileWatcher::CollectChanges(WatchedDirectory* dir, DWORD bytesTransferred)
+{
+	const byte* cur = dir->buffer;
+	const byte* end = dir->buffer + bytesTransferred;
+
+	while (cur + sizeof(FILE_NOTIFY_INFORMATION) <= end)
+	{
+		const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cur);
+		const wstring fileName{ info->FileName, info->FileNameLength / sizeof(WCHAR) };
+
+		switch (info->Action)
+		{
+		case FILE_ACTION_ADDED:
+		case FILE_ACTION_RENAMED_NEW_NAME:
+			AddChange(MakeStr(fileName), FileChangeType::Added);
+			break;
+
+		case FILE_ACTION_REMOVED:
+		case FILE_ACTION_RENAMED_OLD_NAME:
+			AddChange(MakeStr(fileName), FileChangeType::Removed);
+			break;
+
+		case FILE_ACTION_MODIFIED:
+			AddChange(MakeStr(fileName), FileChangeType::Modified);
+			break;
+		}
+
+		if (info->NextEntryOffset == 0)
+		{
+			break;
+		}
+		cur += info->NextEntryOffset;
+	}
+}
+
+
+void FileWatcher::AddChange(string relativePath, FileChangeType type)
+{
+	string name = FileSystem::NormalizePath(relativePath);
+
+	auto it = m_pendingChangeIndex.find(name);
+	if (it == m_pendingChangeIndex.end())
+	{
+		m_pendingChangeIndex.emplace(name, m_pendingChanges.size());
+		m_pendingChanges.push_back({ move(name), move(relativePath), type });
+		return;
+	}
+
+	// Coalesce with the change already pending for this name
+	FileChange& pending = m_pendingChanges[it->second];
+	if (pending.type == FileChangeType::Added && type == FileChangeType::Modified)
+	{
+		// Still a new file
+		return;
+	}
+	if (pending.type == FileChangeType::Removed && type == FileChangeType::Added)
+	{
+		// Replaced, e.g. saved through a temp file and renamed over the original
+		type = FileChangeType::Modified;
+	}
+
+	pending.type = type;
+	pending.relativePath = move(relativePath);
+}
+
+
+void FileWatcher::PublishChanges()
+{
+	vector<FileChange> changes;
+	if (m_pendingRescan)
+	{
+		changes.push_back({ "", "", FileChangeType::Rescan });
+	}
+	else
+	{
+		changes.swap(m_pendingChanges);
+	}
+
+	m_pendingChanges.clear();
+	m_pendingChangeIndex.clear();
+	m_pendingRescan = false;
+
+	if (changes.empty())
+	{
+		return;
+	}
+
+	if (m_onChanges)
+	{
+		m_onChanges(changes);
+	}
+
+	// Copy the callbacks, so subscribers can subscribe or unsubscribe from a callback
+	vector<FileChangeCallback> subscribers;
+	{
+		lock_guard<mutex> lock(m_subscriberMutex);
+		for (const auto& [subscriptionId, callback] : m_subscribers)
+		{
+			subscribers.push_back(callback);
+		}
+	}
+
+	for (const auto& callback : subscribers)
+	{
+		callback(changes);
+	}
+}
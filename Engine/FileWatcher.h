@@ -0,0 +1,92 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core\FlatHashMap.h"
+
+namespace Kodiak
+{
+
+enum class FileChangeType : uint32_t
+{
+	Added,
+	Removed,
+	Modified,
+	Rescan		// Too many changes to track, or a directory changed.  Anything may have changed.
+};
+
+
+struct FileChange
+{
+	std::string name;			// Normalized, relative to the search path (see FileSystem::NormalizePath)
+	std::string relativePath;	// As reported by the OS, relative to the search path
+	FileChangeType type{ FileChangeType::Modified };
+};
+
+
+using FileChangeCallback = std::function<void(std::span<const FileChange>)>;
+
+
+// Watches a set of directory trees with ReadDirectoryChangesW and reports batches of changes.
+// Bursts of events (e.g. an editor saving through a temp file, or a tool writing many files) are
+// coalesced until no new events have arrived for the debounce interval, then published once.
+// Callbacks run on the watcher thread.
+class FileWatcher : NonCopyable, NonMovable
+{
+public:
+	// onChanges is called with every batch before any subscribers
+	explicit FileWatcher(FileChangeCallback onChanges);
+	~FileWatcher();
+
+	// Replaces the set of watched directories.  Doesn't wait for the watcher thread.
+	void Watch(const std::vector<std::filesystem::path>& directories);
+
+	uint32_t Subscribe(FileChangeCallback callback);
+	void Unsubscribe(uint32_t subscriptionId);
+
+	void SetDebounceInterval(std::chrono::milliseconds interval) noexcept { m_debounceMs = (uint32_t)interval.count(); }
+
+private:
+	struct WatchedDirectory;
+
+	void WatcherLoop();
+	void UpdateWatchedDirectories();
+	bool IssueRead(WatchedDirectory* dir);
+	void CollectChanges(WatchedDirectory* dir, DWORD bytesTransferred);
+	void AddChange(std::string relativePath, FileChangeType type);
+	void PublishChanges();
+
+private:
+	FileChangeCallback m_onChanges;
+
+	HANDLE m_completionPort{ nullptr };
+	std::future<void> m_watcherLoop;
+
+	std::atomic<uint32_t> m_debounceMs{ 100 };
+
+	// Requested directories, applied by the watcher thread
+	std::mutex m_watchMutex;
+	std::vector<std::filesystem::path> m_requestedDirectories;
+
+	// Owned by the watcher thread
+	std::vector<std::unique_ptr<WatchedDirectory>> m_directories;
+	std::vector<std::unique_ptr<WatchedDirectory>> m_retiredDirectories;
+	std::vector<FileChange> m_pendingChanges;
+	FlatHashMap<std::string, size_t> m_pendingChangeIndex;
+	bool m_pendingRescan{ false };
+	std::chrono::steady_clock::time_point m_lastEventTime;
+
+	std::mutex m_subscriberMutex;
+	std::map<uint32_t, FileChangeCallback> m_subscribers;
+	uint32_t m_nextSubscriptionId{ 1 };
+};
+
+} // namespace Kodiak
@@ -0,0 +1,237 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\Enums.h"
+
+
+namespace Kodiak
+{
+
+// A graphics device's free command contexts, by CommandListType.  Each thread keeps the last few
+// contexts it finished, so a thread that begins and finishes its own contexts every frame doesn't
+// synchronize at all.  The rest go on a lock-free stack per type, shared by every thread.
+//
+// Contexts are referred to by the slot index AddContext gives them.  The cache doesn't own them,
+// the device does.  Only one cache is live per thread at a time: a thread that moves to another
+// cache (a new device) hands the contexts it was holding back to the old cache's shared stacks,
+// as does a thread that exits.  Contexts past s_maxContexts of a type get no slot of their own,
+// they go on a list under a mutex instead.
+template <typename Context>
+class CommandContextCache : NonCopyable, NonMovable
+{
+public:
+	static constexpr uint32_t s_maxContexts{ 256 };
+	static constexpr uint32_t s_maxThreadCachedContexts{ 4 };
+
+	CommandContextCache() noexcept = default;
+
+	~CommandContextCache()
+	{
+		// Threads still holding contexts from this cache drop them on their next use or exit
+		std::lock_guard<std::mutex> lock(s_threadCacheMutex);
+		for (ThreadCache* threadCache : m_threadCaches)
+		{
+			threadCache->owner.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	// Gives a newly created context its slot.  The context belongs to the calling thread until
+	// it's pushed.
+	uint32_t AddContext(CommandListType commandListType, Context* context)
+	{
+		auto& contextList = m_contextLists[(uint32_t)commandListType];
+
+		uint32_t index = contextList.numContexts.load(std::memory_order_relaxed);
+		do
+		{
+			if (index == s_maxContexts)
+			{
+				std::lock_guard<std::mutex> lock(contextList.overflowMutex);
+				contextList.overflowContexts.push_back(context);
+				return s_maxContexts + (uint32_t)contextList.overflowContexts.size() - 1;
+			}
+		} while (!contextList.numContexts.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+		contextList.contexts[index] = context;
+		return index;
+	}
+
+	// Returns nullptr if there isn't a free context of the type
+	Context* Pop(CommandListType commandListType)
+	{
+		auto& contextList = m_contextLists[(uint32_t)commandListType];
+
+		auto& threadList = GetThreadCache().lists[(uint32_t)commandListType];
+		if (threadList.count > 0)
+		{
+			return contextList.contexts[threadList.indices[--threadList.count]];
+		}
+
+		uint64_t head = contextList.head.load(std::memory_order_acquire);
+		for (;;)
+		{
+			const uint32_t index = GetHeadIndex(head);
+			if (index == s_invalidIndex)
+			{
+				break;
+			}
+
+			// May be stale if another thread pops this index first, the head's tag fails the exchange
+			const uint32_t next = contextList.next[index].load(std::memory_order_relaxed);
+			if (contextList.head.compare_exchange_weak(head, MakeHead(head, next), std::memory_order_acquire, std::memory_order_acquire))
+			{
+				return contextList.contexts[index];
+			}
+		}
+
+		if (contextList.numFreeOverflow.load(std::memory_order_relaxed) == 0)
+		{
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> lock(contextList.overflowMutex);
+		if (contextList.freeOverflow.empty())
+		{
+			return nullptr;
+		}
+
+		const uint32_t overflowIndex = contextList.freeOverflow.back();
+		contextList.freeOverflow.pop_back();
+		contextList.numFreeOverflow.store((uint32_t)contextList.freeOverflow.size(), std::memory_order_relaxed);
+		return contextList.overflowContexts[overflowIndex];
+	}
+
+	void Push(CommandListType commandListType, uint32_t index)
+	{
+		auto& contextList = m_contextLists[(uint32_t)commandListType];
+
+		if (index >= s_maxContexts)
+		{
+			std::lock_guard<std::mutex> lock(contextList.overflowMutex);
+			contextList.freeOverflow.push_back(index - s_maxContexts);
+			contextList.numFreeOverflow.store((uint32_t)contextList.freeOverflow.size(), std::memory_order_relaxed);
+			return;
+		}
+
+		auto& threadList = GetThreadCache().lists[(uint32_t)commandListType];
+		if (threadList.count < s_maxThreadCachedContexts)
+		{
+			threadList.indices[threadList.count++] = index;
+			return;
+		}
+
+		PushShared(contextList, index);
+	}
+
+private:
+	static constexpr uint32_t s_invalidIndex{ ~0u };
+
+	// The stack head is a slot index in the low 32 bits and a tag in the high 32 bits.  The tag
+	// changes on every push and pop, so a pop can't succeed against a head that was popped and
+	// pushed back since it was read.
+	static uint32_t GetHeadIndex(uint64_t head) noexcept { return (uint32_t)head; }
+	static uint64_t MakeHead(uint64_t oldHead, uint32_t index) noexcept { return (((oldHead >> 32) + 1) << 32) | index; }
+
+	struct ContextList
+	{
+		std::atomic<uint64_t> head{ s_invalidIndex };
+		std::atomic<uint32_t> numContexts{ 0 };
+		std::array<std::atomic<uint32_t>, s_maxContexts> next{};
+		std::array<Context*, s_maxContexts> contexts{};
+
+		// Contexts that didn't get a slot, their index is s_maxContexts + position
+		std::mutex overflowMutex;
+		std::vector<Context*> overflowContexts;
+		std::vector<uint32_t> freeOverflow;
+		std::atomic<uint32_t> numFreeOverflow{ 0 };
+	};
+
+	struct ThreadList
+	{
+		std::array<uint32_t, s_maxThreadCachedContexts> indices{};
+		uint32_t count{ 0 };
+	};
+
+	// Registered with its owner, so whichever goes first, the thread or the cache, can let the
+	// other know
+	struct ThreadCache
+	{
+		// Only the destroying cache writes this from another thread
+		std::atomic<CommandContextCache*> owner{ nullptr };
+		std::array<ThreadList, (uint32_t)CommandListType::Count> lists{};
+
+		~ThreadCache()
+		{
+			std::lock_guard<std::mutex> lock(s_threadCacheMutex);
+			if (auto* cache = owner.load(std::memory_order_relaxed))
+			{
+				cache->DetachThreadCache(*this);
+			}
+		}
+	};
+
+	static void PushShared(ContextList& contextList, uint32_t index) noexcept
+	{
+		uint64_t head = contextList.head.load(std::memory_order_relaxed);
+		do
+		{
+			contextList.next[index].store(GetHeadIndex(head), std::memory_order_relaxed);
+		} while (!contextList.head.compare_exchange_weak(head, MakeHead(head, index), std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	ThreadCache& GetThreadCache()
+	{
+		static thread_local ThreadCache t_threadCache;
+
+		if (t_threadCache.owner.load(std::memory_order_relaxed) != this)
+		{
+			std::lock_guard<std::mutex> lock(s_threadCacheMutex);
+			if (auto* cache = t_threadCache.owner.load(std::memory_order_relaxed))
+			{
+				cache->DetachThreadCache(t_threadCache);
+			}
+
+			// Anything left is from a cache that has since been destroyed
+			t_threadCache.lists = {};
+
+			m_threadCaches.push_back(&t_threadCache);
+			t_threadCache.owner.store(this, std::memory_order_relaxed);
+		}
+		return t_threadCache;
+	}
+
+	// Hands the thread's contexts to the shared stacks.  Caller holds s_threadCacheMutex.
+	void DetachThreadCache(ThreadCache& threadCache)
+	{
+		for (uint32_t type = 0; type < (uint32_t)CommandListType::Count; ++type)
+		{
+			ThreadList& threadList = threadCache.lists[type];
+			for (uint32_t i = 0; i < threadList.count; ++i)
+			{
+				PushShared(m_contextLists[type], threadList.indices[i]);
+			}
+			threadList.count = 0;
+		}
+
+		std::erase(m_threadCaches, &threadCache);
+		threadCache.owner.store(nullptr, std::memory_order_relaxed);
+	}
+
+private:
+	// Guards every cache's m_threadCaches and every thread's ThreadCache::owner
+	static inline std::mutex s_threadCacheMutex;
+
+	std::array<ContextList, (uint32_t)CommandListType::Count> m_contextLists;
+	std::vector<ThreadCache*> m_threadCaches;
+};
+
+} // namespace Kodiak
@@ -39,9 +39,7 @@ ColorBuffer::ColorBuffer(const ColorBufferCreationParams& creationParams, const
 	, m_rtvHandle{ creationParamsExt.rtvHandle }
 	, m_srvHandle{ creationParamsExt.srvHandle }
 	, m_uavHandles{ creationParamsExt.uavHandles }
-{
-	m_numMips = m_numMips == 0 ? ComputeNumMips(m_width, m_height) : m_numMips;
-}
+{}
 
 
 NativeObjectPtr ColorBuffer::GetNativeObject(NativeObjectType nativeObjectType) const noexcept
@@ -68,6 +68,8 @@ CommandContext::~CommandContext() = default;
 
 uint64_t CommandContext::Finish(bool bWaitForCompletion)
 {
+	ALLOCATION_TAG(Graphics);
+
 	assert(m_type == CommandListType::Direct || m_type == CommandListType::Compute);
 
 	FlushResourceBarriers();
@@ -136,7 +138,10 @@ void CommandContext::SetMarker(const string& label)
 
 void CommandContext::TransitionResource(IGpuImage* gpuImage, ResourceState newState, bool bFlushImmediate)
 {
-	auto oldState = gpuImage->GetUsageState();
+	ALLOCATION_TAG(Graphics);
+
+	const GpuImageId imageId = gpuImage->GetId();
+	auto oldState = GetGpuImageTable().ExchangeUsageState(imageId, newState);
 
 	if (m_type == CommandListType::Compute)
 	{
@@ -145,21 +150,15 @@ void CommandContext::TransitionResource(IGpuImage* gpuImage, ResourceState newSt
 	}
 
 	TextureBarrier barrier{};
-	barrier.resource = gpuImage->GetNativeObject(NativeObjectType::DX12_Resource);
+	barrier.imageId = imageId;
 	barrier.beforeState = oldState;
 	barrier.afterState = newState;
-	barrier.numMips = gpuImage->GetNumMips();
 	barrier.mipLevel = 0;
-	barrier.arraySizeOrDepth = gpuImage->GetArraySize();
 	barrier.arraySlice = 0;
-	barrier.planeCount = gpuImage->GetPlaneCount();
 	barrier.bWholeTexture = true;
 
 	m_textureBarriers.push_back(barrier);
 
-	gpuImage->SetUsageState(newState);
-
-
 	if (bFlushImmediate || GetPendingBarrierCount() >= 16)
 	{
 		FlushResourceBarriers();
@@ -187,6 +186,8 @@ void CommandContext::InsertUAVBarrier(IGpuImage* gpuImage, bool bFlushImmediate)
 
 void CommandContext::FlushResourceBarriers()
 {
+	ALLOCATION_TAG(Graphics);
+
 	using enum ResourceState;
 
 	const size_t numBarriers = m_textureBarriers.size() + m_bufferBarriers.size();
@@ -198,39 +199,58 @@ void CommandContext::FlushResourceBarriers()
 	m_dxBarriers.clear();
 	m_dxBarriers.reserve(numBarriers);
 
-	for (const auto& barrier : m_textureBarriers)
-	{
-		D3D12_RESOURCE_BARRIER dxBarrier{};
-		const D3D12_RESOURCE_STATES beforeState = ResourceStateToDX12(barrier.beforeState);
-		const D3D12_RESOURCE_STATES afterState = ResourceStateToDX12(barrier.afterState);
-
-		if (beforeState != afterState)
+	// One lock for the whole batch, the image data comes from contiguous columns
+	GetGpuImageTable().Read([this](const GpuImageTable::Images& images)
 		{
-			dxBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-			dxBarrier.Transition.StateBefore = beforeState;
-			dxBarrier.Transition.StateAfter = afterState;
-			dxBarrier.Transition.pResource = barrier.resource;
-			if (barrier.bWholeTexture)
+			for (const auto& barrier : m_textureBarriers)
 			{
-				dxBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-				m_dxBarriers.push_back(dxBarrier);
-			}
-			else
-			{
-				for (uint8_t plane = 0; plane < barrier.planeCount; ++plane)
+				// The image was destroyed with the barrier still pending
+				if (!images.Contains(barrier.imageId))
+				{
+					continue;
+				}
+
+				const uint32_t index = images.GetDenseIndex(barrier.imageId);
+				auto* resource = reinterpret_cast<ID3D12Resource*>(images.GetColumn<GpuImageColumn::NativeImage>()[index]);
+
+				D3D12_RESOURCE_BARRIER dxBarrier{};
+				const D3D12_RESOURCE_STATES beforeState = ResourceStateToDX12(barrier.beforeState);
+				const D3D12_RESOURCE_STATES afterState = ResourceStateToDX12(barrier.afterState);
+
+				if (beforeState != afterState)
+				{
+					dxBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+					dxBarrier.Transition.StateBefore = beforeState;
+					dxBarrier.Transition.StateAfter = afterState;
+					dxBarrier.Transition.pResource = resource;
+					if (barrier.bWholeTexture)
+					{
+						dxBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+						m_dxBarriers.push_back(dxBarrier);
+					}
+					else
+					{
+						// Subresource indices count the image's mips and array slices, a 3D texture has one slice
+						const uint32_t numMips = images.GetColumn<GpuImageColumn::NumMips>()[index];
+						const bool is3D = images.GetColumn<GpuImageColumn::Type>()[index] == ResourceType::Texture3D;
+						const uint32_t arraySize = is3D ? 1 : images.GetColumn<GpuImageColumn::ArraySizeOrDepth>()[index];
+
+						const uint32_t planeCount = images.GetColumn<GpuImageColumn::PlaneCount>()[index];
+						for (uint8_t plane = 0; plane < planeCount; ++plane)
+						{
+							dxBarrier.Transition.Subresource = CalcSubresource(barrier.mipLevel, barrier.arraySlice, plane, numMips, arraySize);
+							m_dxBarriers.push_back(dxBarrier);
+						}
+					}
+				}
+				else if (afterState & D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
 				{
-					dxBarrier.Transition.Subresource = CalcSubresource(barrier.mipLevel, barrier.arraySlice, plane, barrier.numMips, barrier.arraySizeOrDepth);
+					dxBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+					dxBarrier.UAV.pResource = resource;
 					m_dxBarriers.push_back(dxBarrier);
 				}
 			}
-		}
-		else if (afterState & D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
-		{
-			dxBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-			dxBarrier.UAV.pResource = barrier.resource;
-			m_dxBarriers.push_back(dxBarrier);
-		}
-	}
+		});
 
 	for (const auto& barrier : m_bufferBarriers)
 	{
@@ -11,6 +11,7 @@
 #pragma once
 
 
+#include "Core\SmallVector.h"
 #include "Graphics\Interfaces.h"
 #include "Graphics\DX12\DirectXCommon.h"
 
@@ -22,16 +23,14 @@ namespace Kodiak::DX12
 class GraphicsDevice;
 
 
+// The resource and whole-texture extents are looked up in the GpuImageTable at flush time
 struct TextureBarrier
 {
-	ID3D12Resource* resource{ nullptr };
+	GpuImageId imageId;
 	ResourceState beforeState{ ResourceState::Undefined };
 	ResourceState afterState{ ResourceState::Undefined };
-	uint32_t numMips{ 1 };
 	uint32_t mipLevel{ 0 };
-	uint32_t arraySizeOrDepth{ 1 };
 	uint32_t arraySlice{ 0 };
-	uint32_t planeCount{ 1 };
 	bool bWholeTexture{ false };
 };
 
@@ -79,13 +78,15 @@ protected:
 protected:
 	GraphicsDevice* m_device{ nullptr };
 	CommandListType m_type{ CommandListType::Direct };
+	uint32_t m_cacheIndex{ 0 };
 
 	ID3D12GraphicsCommandList* m_commandList{ nullptr };
 	ID3D12CommandAllocator* m_currentAllocator{ nullptr };
 
-	std::vector<TextureBarrier> m_textureBarriers;
-	std::vector<BufferBarrier> m_bufferBarriers;
-	std::vector<D3D12_RESOURCE_BARRIER> m_dxBarriers;
+	// Resource barriers, batched until the next flush
+	SmallVector<TextureBarrier, 16> m_textureBarriers;
+	SmallVector<BufferBarrier, 16> m_bufferBarriers;
+	SmallVector<D3D12_RESOURCE_BARRIER, 16> m_dxBarriers;
 
 	std::string m_id;
 
@@ -36,9 +36,7 @@ DepthBuffer::DepthBuffer(const DepthBufferCreationParams& creationParams, const
 	, m_dsvHandles{ creationParamsExt.dsvHandles }
 	, m_depthSrvHandle{ creationParamsExt.depthSrvHandle }
 	, m_stencilSrvHandle{ creationParamsExt.stencilSrvHandle }
-{
-	m_numMips = m_numMips == 0 ? ComputeNumMips(m_width, m_height) : m_numMips;
-}
+{}
 
 
 NativeObjectPtr DepthBuffer::GetNativeObject(NativeObjectType nativeObjectType) const noexcept
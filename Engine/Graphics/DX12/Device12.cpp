@@ -267,6 +267,8 @@ bool GraphicsDevice::CreateSwapChain()
 
 void GraphicsDevice::BeginFrame()
 {
+	ALLOCATION_TAG(Graphics);
+
 	// TODO Handle window resize here
 
 	m_currentBufferIndex = m_dxgiSwapChain->GetCurrentBackBufferIndex();
@@ -276,6 +278,8 @@ void GraphicsDevice::BeginFrame()
 
 void GraphicsDevice::Present()
 {
+	ALLOCATION_TAG(Graphics);
+
 	if (!m_bIsWindowVisible)
 	{
 		return;
@@ -553,6 +557,8 @@ DepthBufferHandle GraphicsDevice::CreateDepthBuffer(const DepthBufferCreationPar
 
 CommandContextHandle GraphicsDevice::BeginCommandContext(const string& ID)
 {
+	ALLOCATION_TAG(Graphics);
+
 	auto* newContext = AllocateContext(CommandListType::Direct);
 
 	newContext->SetID(ID);
@@ -722,26 +728,24 @@ void GraphicsDevice::CreateDescriptorAllocators()
 
 CommandContext* GraphicsDevice::AllocateContext(CommandListType commandListType)
 {
-	lock_guard<mutex> guard{ m_contextAllocationMutex };
-
-	auto& availableContexts = m_availableContexts[(uint32_t)commandListType];
-
-	CommandContext* context{ nullptr };
-	if (availableContexts.empty())
+	CommandContext* context = m_contextCache.Pop(commandListType);
+	if (context != nullptr)
+	{
+		context->Reset();
+	}
+	else
 	{
 		context = new CommandContext(this, commandListType);
 		CommandContextHandle handle;
 		handle.Attach(context);
-		m_contextPool[(uint32_t)commandListType].emplace_back(handle);
+		{
+			lock_guard<mutex> guard{ m_contextCreationMutex };
+			m_contextPool[(uint32_t)commandListType].emplace_back(handle);
+		}
 
+		context->m_cacheIndex = m_contextCache.AddContext(commandListType, context);
 		CreateCommandList(commandListType, &context->m_commandList, &context->m_currentAllocator);
 	}
-	else
-	{
-		context = availableContexts.front();
-		availableContexts.pop();
-		context->Reset();
-	}
 
 	assert(context != nullptr);
 	assert(context->m_type == commandListType);
@@ -753,9 +757,7 @@ void GraphicsDevice::FreeContext(CommandContext* usedContext)
 {
 	assert(usedContext != nullptr);
 
-	lock_guard<mutex> guard(m_contextAllocationMutex);
-
-	m_availableContexts[(uint32_t)usedContext->m_type].push(usedContext);
+	m_contextCache.Push(usedContext->m_type, usedContext->m_cacheIndex);
 }
 
 
@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include "Core\FlatHashMap.h"
+#include "Graphics\CommandContextCache.h"
 #include "Graphics\Interfaces.h"
 #include "Graphics\DX12\DirectXCommon.h"
 
@@ -161,16 +163,16 @@ private:
 	// Descriptor allocators
 	std::array<std::unique_ptr<DescriptorAllocator>, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> m_descriptorAllocators;
 
-	// Command contexts
+	// Command contexts, owned by the pool, which is only touched when a context is created
 	std::array<std::vector<CommandContextHandle>, (uint32_t)CommandListType::Count> m_contextPool;
-	std::array<std::queue<CommandContext*>, (uint32_t)CommandListType::Count> m_availableContexts;
-	std::mutex m_contextAllocationMutex;
+	CommandContextCache<CommandContext> m_contextCache;
+	std::mutex m_contextCreationMutex;
 
 	// DirectX caps
 	std::unique_ptr<DeviceCaps> m_caps;
 
 	// Format properties
-	std::unordered_map<DXGI_FORMAT, uint8_t> m_dxgiFormatPlaneCounts;
+	FlatHashMap<DXGI_FORMAT, uint8_t> m_dxgiFormatPlaneCounts;
 };
 
 } // namespace Kodiak::DX12
\ No newline at end of file
@@ -344,26 +344,23 @@ vector<AdapterInfo> DeviceManager::EnumerateAdapters()
 			adapterInfo.vendor = VendorIdToHardwareVendor(adapterInfo.vendorId);
 			adapterInfo.adapterType = GetAdapterType(tempAdapter);
 
-			LogInfo(LogDirectX) << format("  Adapter {} is D3D12-capable: {} (Vendor: {}, VendorId: {:#x}, DeviceId: {:#x})",
+			LogInfo(LogDirectX, "  Adapter {} is D3D12-capable: {} (Vendor: {}, VendorId: {:#x}, DeviceId: {:#x})",
 				idx,
 				adapterInfo.name,
 				HardwareVendorToString(adapterInfo.vendor),
-				adapterInfo.vendorId, adapterInfo.deviceId)
-				<< endl;
+				adapterInfo.vendorId, adapterInfo.deviceId);
 
-			LogInfo(LogDirectX) << format("    Feature level {}, shader model {}, binding tier {}, wave ops {}, atomic64 {}",
+			LogInfo(LogDirectX, "    Feature level {}, shader model {}, binding tier {}, wave ops {}, atomic64 {}",
 				D3DTypeToString(basicCaps.maxFeatureLevel, true),
 				D3DTypeToString(basicCaps.maxShaderModel, true),
 				D3DTypeToString(basicCaps.resourceBindingTier, true),
 				basicCaps.bSupportsWaveOps ? "supported" : "not supported",
-				basicCaps.bSupportsAtomic64 ? "supported" : "not supported")
-				<< endl;
+				basicCaps.bSupportsAtomic64 ? "supported" : "not supported");
 
-			LogInfo(LogDirectX) << format("    Adapter memory: {} MB dedicated video memory, {} MB dedicated system memory, {} MB shared memory",
+			LogInfo(LogDirectX, "    Adapter memory: {} MB dedicated video memory, {} MB dedicated system memory, {} MB shared memory",
 				(uint32_t)(desc.DedicatedVideoMemory >> 20),
 				(uint32_t)(desc.DedicatedSystemMemory >> 20),
-				(uint32_t)(desc.SharedSystemMemory >> 20))
-				<< endl;
+				(uint32_t)(desc.SharedSystemMemory >> 20));
 
 			m_bestFeatureLevel = basicCaps.maxFeatureLevel;
 			m_bestShaderModel = basicCaps.maxShaderModel;
@@ -31,12 +31,31 @@ GpuImage::GpuImage(
 	, m_width{ width }
 	, m_height{ height }
 	, m_arraySizeOrDepth{ arraySizeOrDepth }
-	, m_numMips{ numMips }
+	, m_numMips{ numMips == 0 ? ComputeNumMips(width, height) : numMips }
 	, m_numSamples{ numSamples }
 	, m_planeCount{ planeCount }
 	, m_resourceType{ resourceType }
-	, m_usageState{ usageState }
 	, m_format{ format }
-{}
+{
+	auto imageInfo = GpuImageInfo{};
+	imageInfo.nativeImage = reinterpret_cast<uint64_t>(resource);
+	imageInfo.type = resourceType;
+	imageInfo.format = format;
+	imageInfo.width = width;
+	imageInfo.height = height;
+	imageInfo.arraySizeOrDepth = arraySizeOrDepth;
+	imageInfo.numMips = m_numMips;
+	imageInfo.numSamples = numSamples;
+	imageInfo.planeCount = planeCount;
+	imageInfo.usageState = usageState;
+
+	m_id = GetGpuImageTable().Register(imageInfo);
+}
+
+
+GpuImage::~GpuImage()
+{
+	GetGpuImageTable().Unregister(m_id);
+}
 
 } // namespace Kodiak::DX12
\ No newline at end of file
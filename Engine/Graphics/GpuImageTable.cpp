@@ -0,0 +1,78 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "GpuImageTable.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+GpuImageId GpuImageTable::Register(const GpuImageInfo& info)
+{
+	lock_guard lock(m_mutex);
+
+	return m_images.Insert(
+		info.nativeImage,
+		info.type,
+		info.format,
+		info.width,
+		info.height,
+		info.arraySizeOrDepth,
+		info.numMips,
+		info.numSamples,
+		info.planeCount,
+		info.usageState);
+}
+
+
+void GpuImageTable::Unregister(GpuImageId id)
+{
+	lock_guard lock(m_mutex);
+
+	m_images.Erase(id);
+}
+
+
+ResourceState GpuImageTable::GetUsageState(GpuImageId id) const
+{
+	shared_lock lock(m_mutex);
+
+	return m_images.Contains(id) ? m_images.Get<GpuImageColumn::UsageState>(id) : ResourceState::Undefined;
+}
+
+
+void GpuImageTable::SetUsageState(GpuImageId id, ResourceState usageState)
+{
+	ExchangeUsageState(id, usageState);
+}
+
+
+ResourceState GpuImageTable::ExchangeUsageState(GpuImageId id, ResourceState usageState)
+{
+	// Only the owner changes an image's state, so a shared lock is enough to keep it in place
+	shared_lock lock(m_mutex);
+
+	if (!m_images.Contains(id))
+	{
+		return ResourceState::Undefined;
+	}
+	return exchange(m_images.Get<GpuImageColumn::UsageState>(id), usageState);
+}
+
+
+GpuImageTable& Kodiak::GetGpuImageTable()
+{
+	// Never destroyed, images can outlive static destruction order
+	static GpuImageTable* s_gpuImageTable = new GpuImageTable;
+	return *s_gpuImageTable;
+}
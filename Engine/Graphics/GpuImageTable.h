@@ -0,0 +1,105 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core\SlotMap.h"
+#include "Graphics\Enums.h"
+#include "Graphics\Formats.h"
+
+
+namespace Kodiak
+{
+
+struct GpuImageTag;
+using GpuImageId = SlotHandle<GpuImageTag>;
+
+
+struct GpuImageInfo
+{
+	// VkImage or ID3D12Resource*
+	uint64_t nativeImage{ 0 };
+	ResourceType type{ ResourceType::Unknown };
+	Format format{ Format::Unknown };
+	uint64_t width{ 0 };
+	uint32_t height{ 0 };
+	uint32_t arraySizeOrDepth{ 0 };
+	uint32_t numMips{ 1 };
+	uint32_t numSamples{ 1 };
+	uint32_t planeCount{ 1 };
+	ResourceState usageState{ ResourceState::Undefined };
+};
+
+
+// Column indices for GpuImageTable::Images
+struct GpuImageColumn
+{
+	enum : size_t
+	{
+		NativeImage,
+		Type,
+		Format,
+		Width,
+		Height,
+		ArraySizeOrDepth,
+		NumMips,
+		NumSamples,
+		PlaneCount,
+		UsageState
+	};
+};
+
+
+// Metadata and usage state for every live GPU image, stored structure-of-arrays and addressed by
+// GpuImageId.  The GpuImage classes register themselves, and the command contexts resolve a
+// whole batch of barriers from here under one lock instead of making virtual calls per image.
+// Usage state lives only here.  Registration is rare and takes the lock exclusively.  Reads, and
+// usage state updates for images the caller owns, share it.
+class GpuImageTable : NonCopyable, NonMovable
+{
+public:
+	using Images = SlotMap<GpuImageId,
+		uint64_t,			// NativeImage
+		ResourceType,		// Type
+		Kodiak::Format,		// Format
+		uint64_t,			// Width
+		uint32_t,			// Height
+		uint32_t,			// ArraySizeOrDepth
+		uint32_t,			// NumMips
+		uint32_t,			// NumSamples
+		uint32_t,			// PlaneCount
+		ResourceState>;		// UsageState
+
+	GpuImageId Register(const GpuImageInfo& info);
+	void Unregister(GpuImageId id);
+
+	// Undefined for a stale id
+	ResourceState GetUsageState(GpuImageId id) const;
+	void SetUsageState(GpuImageId id, ResourceState usageState);
+
+	// Sets the new state and returns the previous one
+	ResourceState ExchangeUsageState(GpuImageId id, ResourceState usageState);
+
+	// Calls func(images) with registration locked out, for looking up many images at once
+	template <typename Func>
+	void Read(Func&& func) const
+	{
+		std::shared_lock lock(m_mutex);
+		func(static_cast<const Images&>(m_images));
+	}
+
+private:
+	mutable std::shared_mutex m_mutex;
+	Images m_images;
+};
+
+GpuImageTable& GetGpuImageTable();
+
+} // namespace Kodiak
@@ -12,6 +12,7 @@
 
 #include "Graphics\Enums.h"
 #include "Graphics\Formats.h"
+#include "Graphics\GpuImageTable.h"
 
 
 namespace Kodiak
@@ -30,6 +31,9 @@ struct DepthBufferCreationParams;
 class __declspec(novtable) IGpuImage : public IObject
 {
 public:
+	// For looking the image up in GetGpuImageTable()
+	virtual GpuImageId GetId() const noexcept = 0;
+
 	virtual ResourceType GetType() const noexcept = 0;
 	virtual ResourceState GetUsageState() const noexcept = 0;
 	virtual void SetUsageState(ResourceState usageState) noexcept = 0;
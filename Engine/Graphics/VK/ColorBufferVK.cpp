@@ -35,9 +35,7 @@ ColorBuffer::ColorBuffer(const ColorBufferCreationParams& creationParams, const
 	, m_imageViewSrv{ creationParamsExt.imageViewSrv }
 	, m_imageInfoSrv{ creationParamsExt.imageInfoSrv }
 	, m_imageInfoUav{ creationParamsExt.imageInfoUav }
-{
-	m_numMips = m_numMips == 0 ? ComputeNumMips(m_width, m_height) : m_numMips;
-}
+{}
 
 
 NativeObjectPtr ColorBuffer::GetNativeObject(NativeObjectType nativeObjectType) const noexcept
@@ -18,7 +18,7 @@ namespace Kodiak::VK
 
 class CommandBufferPool : public IObject, public NonCopyable
 {
-	IMPLEMENT_IOBJECT
+	IMPLEMENT_IOBJECT_SINGLE_THREADED
 
 public:
 	CommandBufferPool(CVkCommandPool* commandPool, CommandListType commandListType) noexcept
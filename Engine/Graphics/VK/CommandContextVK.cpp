@@ -34,6 +34,8 @@ CommandContext::~CommandContext() = default;
 
 uint64_t CommandContext::Finish(bool bWaitForCompletion)
 {
+	ALLOCATION_TAG(Graphics);
+
 	assert(m_type == CommandListType::Direct || m_type == CommandListType::Compute);
 
 	FlushResourceBarriers();
@@ -115,22 +117,18 @@ void CommandContext::SetMarker(const string& label)
 
 void CommandContext::TransitionResource(IGpuImage* gpuImage, ResourceState newState, bool bFlushImmediate)
 {
+	ALLOCATION_TAG(Graphics);
+
 	TextureBarrier barrier{};
-	barrier.image = gpuImage->GetNativeObject(NativeObjectType::VK_Image);
-	barrier.format = FormatToVulkan(gpuImage->GetFormat());
-	barrier.imageAspect = GetImageAspect(gpuImage->GetFormat());
-	barrier.beforeState = gpuImage->GetUsageState();
+	barrier.imageId = gpuImage->GetId();
+	barrier.beforeState = GetGpuImageTable().ExchangeUsageState(barrier.imageId, newState);
 	barrier.afterState = newState;
-	barrier.numMips = gpuImage->GetNumMips();
 	barrier.mipLevel = 0;
-	barrier.arraySizeOrDepth = gpuImage->GetArraySize();
 	barrier.arraySlice = 0;
 	barrier.bWholeTexture = true;
 
 	m_textureBarriers.push_back(barrier);
 
-	gpuImage->SetUsageState(newState);
-
 	if (bFlushImmediate || GetPendingBarrierCount() >= 16)
 	{
 		FlushResourceBarriers();
@@ -148,34 +146,56 @@ void CommandContext::InsertUAVBarrier(IGpuImage* gpuImage, bool bFlushImmediate)
 
 void CommandContext::FlushResourceBarriers()
 {
-	for (const auto& barrier : m_textureBarriers)
-	{
-		ResourceStateMapping before = GetResourceStateMapping(barrier.beforeState);
-		ResourceStateMapping after = GetResourceStateMapping(barrier.afterState);
-
-		assert(after.imageLayout != VK_IMAGE_LAYOUT_UNDEFINED);
-
-		VkImageSubresourceRange subresourceRange{};
-		subresourceRange.aspectMask = barrier.imageAspect;
-		subresourceRange.baseArrayLayer = barrier.arraySlice;
-		subresourceRange.baseMipLevel = barrier.mipLevel;
-		subresourceRange.layerCount = barrier.arraySizeOrDepth;
-		subresourceRange.levelCount = barrier.numMips;
-
-		VkImageMemoryBarrier2 vkBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
-		vkBarrier.srcAccessMask = before.accessFlags;
-		vkBarrier.dstAccessMask = after.accessFlags;
-		vkBarrier.srcStageMask = before.stageFlags;
-		vkBarrier.dstStageMask = after.stageFlags;
-		vkBarrier.oldLayout = before.imageLayout;
-		vkBarrier.newLayout = after.imageLayout;
-		vkBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		vkBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		vkBarrier.image = barrier.image;
-		vkBarrier.subresourceRange = subresourceRange;
-
-		m_imageMemoryBarriers.push_back(vkBarrier);
-	}
+	ALLOCATION_TAG(Graphics);
+
+	// One lock for the whole batch, the image data comes from contiguous columns
+	GetGpuImageTable().Read([this](const GpuImageTable::Images& images)
+		{
+			for (const auto& barrier : m_textureBarriers)
+			{
+				// The image was destroyed with the barrier still pending
+				if (!images.Contains(barrier.imageId))
+				{
+					continue;
+				}
+
+				const uint32_t index = images.GetDenseIndex(barrier.imageId);
+				const Format format = images.GetColumn<GpuImageColumn::Format>()[index];
+				const bool is3D = images.GetColumn<GpuImageColumn::Type>()[index] == ResourceType::Texture3D;
+
+				ResourceStateMapping before = GetResourceStateMapping(barrier.beforeState);
+				ResourceStateMapping after = GetResourceStateMapping(barrier.afterState);
+
+				assert(after.imageLayout != VK_IMAGE_LAYOUT_UNDEFINED);
+
+				VkImageSubresourceRange subresourceRange{};
+				subresourceRange.aspectMask = GetImageAspect(format);
+				subresourceRange.baseArrayLayer = barrier.arraySlice;
+				subresourceRange.baseMipLevel = barrier.mipLevel;
+				subresourceRange.layerCount = barrier.arraySizeOrDepth;
+				subresourceRange.levelCount = barrier.numMips;
+
+				if (barrier.bWholeTexture)
+				{
+					subresourceRange.layerCount = is3D ? 1 : images.GetColumn<GpuImageColumn::ArraySizeOrDepth>()[index];
+					subresourceRange.levelCount = images.GetColumn<GpuImageColumn::NumMips>()[index];
+				}
+
+				VkImageMemoryBarrier2 vkBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+				vkBarrier.srcAccessMask = before.accessFlags;
+				vkBarrier.dstAccessMask = after.accessFlags;
+				vkBarrier.srcStageMask = before.stageFlags;
+				vkBarrier.dstStageMask = after.stageFlags;
+				vkBarrier.oldLayout = before.imageLayout;
+				vkBarrier.newLayout = after.imageLayout;
+				vkBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				vkBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				vkBarrier.image = (VkImage)images.GetColumn<GpuImageColumn::NativeImage>()[index];
+				vkBarrier.subresourceRange = subresourceRange;
+
+				m_imageMemoryBarriers.push_back(vkBarrier);
+			}
+		});
 
 	if (!m_imageMemoryBarriers.empty())
 	{
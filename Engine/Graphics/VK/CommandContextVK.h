@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "Core\SmallVector.h"
 #include "Graphics\Enums.h"
 #include "Graphics\Interfaces.h"
 #include "Graphics\VK\VulkanCommon.h"
@@ -23,11 +24,10 @@ namespace Kodiak::VK
 class GraphicsDevice;
 
 
+// The image, format and whole-texture extents are looked up in the GpuImageTable at flush time
 struct TextureBarrier
 {
-	VkImage image{ VK_NULL_HANDLE };
-	VkFormat format{ VK_FORMAT_UNDEFINED };
-	VkImageAspectFlags imageAspect{ 0 };
+	GpuImageId imageId;
 	ResourceState beforeState{ ResourceState::Undefined };
 	ResourceState afterState{ ResourceState::Undefined };
 	uint32_t numMips{ 1 };
@@ -78,17 +78,18 @@ public:
 protected:
 	GraphicsDevice* m_device{ nullptr };
 	CommandListType m_type{ CommandListType::Direct };
+	uint32_t m_cacheIndex{ 0 };
 	VkCommandBuffer m_commandBuffer{ VK_NULL_HANDLE };
 
 	bool m_bInvertedViewport{ true };
 	bool m_hasPendingDebugEvent{ false };
 
-	// Resource barriers
-	std::vector<TextureBarrier> m_textureBarriers;
+	// Resource barriers, batched until the next flush
+	SmallVector<TextureBarrier, 16> m_textureBarriers;
 	std::vector<BufferBarrier> m_bufferBarriers;
 	std::vector<VkMemoryBarrier2> m_memoryBarriers;
 	std::vector<VkBufferMemoryBarrier2> m_bufferMemoryBarriers;
-	std::vector<VkImageMemoryBarrier2> m_imageMemoryBarriers;
+	SmallVector<VkImageMemoryBarrier2, 16> m_imageMemoryBarriers;
 
 private:
 	explicit CommandContext(CommandListType type);
@@ -37,9 +37,7 @@ DepthBuffer::DepthBuffer(const DepthBufferCreationParams& creationParams, const
 	, m_imageViewStencilOnly{ creationParamsExt.imageViewStencilOnly }
 	, m_imageInfoDepth{ creationParamsExt.imageInfoDepth }
 	, m_imageInfoStencil{ creationParamsExt.imageInfoStencil }
-{
-	m_numMips = m_numMips == 0 ? ComputeNumMips(m_width, m_height) : m_numMips;
-}
+{}
 
 
 NativeObjectPtr DepthBuffer::GetNativeObject(NativeObjectType nativeObjectType) const noexcept
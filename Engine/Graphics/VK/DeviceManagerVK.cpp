@@ -202,8 +202,8 @@ bool DeviceManager::CreateInstance()
 	{
 		m_versionInfo = DecodeVulkanVersion(instanceVersion);
 
-		LogInfo(LogVulkan) << format("Created Vulkan instance, variant {}, API version {}",
-			m_versionInfo.variant, m_versionInfo) << endl;
+		LogInfo(LogVulkan, "Created Vulkan instance, variant {}, API version {}",
+			m_versionInfo.variant, m_versionInfo);
 	}
 	else
 	{
@@ -451,18 +451,16 @@ vector<pair<AdapterInfo, VkPhysicalDevice>> DeviceManager::EnumeratePhysicalDevi
 		adapterInfo.adapterType = VkPhysicalDeviceTypeToEngine(caps.properties.deviceType);
 		adapterInfo.apiVersion = caps.properties.apiVersion;
 
-		LogInfo(LogVulkan) << format("  {} physical device {} is Vulkan-capable: {} (VendorId: {:#x}, DeviceId: {:#x}, API version: {})",
+		LogInfo(LogVulkan, "  {} physical device {} is Vulkan-capable: {} (VendorId: {:#x}, DeviceId: {:#x}, API version: {})",
 			AdapterTypeToString(adapterInfo.adapterType),
 			deviceIdx,
 			adapterInfo.name,
-			adapterInfo.vendorId, adapterInfo.deviceId, VulkanVersionToString(adapterInfo.apiVersion))
-			<< endl;
+			adapterInfo.vendorId, adapterInfo.deviceId, VulkanVersionToString(adapterInfo.apiVersion));
 
-		LogInfo(LogVulkan) << format("    Physical device memory: {} MB dedicated video memory, {} MB dedicated system memory, {} MB shared memory",
+		LogInfo(LogVulkan, "    Physical device memory: {} MB dedicated video memory, {} MB dedicated system memory, {} MB shared memory",
 			(uint32_t)(adapterInfo.dedicatedVideoMemory >> 20),
 			(uint32_t)(adapterInfo.dedicatedSystemMemory >> 20),
-			(uint32_t)(adapterInfo.sharedSystemMemory >> 20))
-			<< endl;
+			(uint32_t)(adapterInfo.sharedSystemMemory >> 20));
 
 		adapters.push_back(make_pair(adapterInfo, physicalDevices[deviceIdx]));
 	}
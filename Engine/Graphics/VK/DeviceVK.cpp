@@ -12,6 +12,7 @@
 
 #include "DeviceVK.h"
 
+#include "Core\FlatHashMap.h"
 #include "Graphics\CreationParams.h"
 #include "ColorBufferVK.h"
 #include "CreationParamsVK.h"
@@ -20,8 +21,6 @@
 #include "QueueVK.h"
 #include "Generated\LoaderVk.h"
 
-#include <unordered_set>
-
 using namespace std;
 
 
@@ -96,7 +95,7 @@ bool GraphicsDevice::CreateSwapChain()
 		m_deviceCreationParams.backBufferWidth,	
 		m_deviceCreationParams.backBufferHeight };
 
-	unordered_set<uint32_t> uniqueQueues{ 
+	FlatHashSet<uint32_t> uniqueQueues{ 
 		(uint32_t)m_deviceCreationParams.queueFamilyIndices.graphics, 
 		(uint32_t)m_deviceCreationParams.queueFamilyIndices.present };
 	vector<uint32_t> queues(uniqueQueues.begin(), uniqueQueues.end());
@@ -212,6 +211,8 @@ bool GraphicsDevice::CreateSwapChain()
 
 void GraphicsDevice::BeginFrame()
 {
+	ALLOCATION_TAG(Graphics);
+
 	const auto& semaphore = m_presentSemaphores[m_presentSemaphoreIndex];
 	const auto& fence = m_presentFences[m_presentSemaphoreIndex];
 	m_presentFenceState[m_presentSemaphoreIndex] = 1;
@@ -228,6 +229,8 @@ void GraphicsDevice::BeginFrame()
 
 void GraphicsDevice::Present()
 {
+	ALLOCATION_TAG(Graphics);
+
 	const auto& semaphore = m_presentSemaphores[m_presentSemaphoreIndex];
 	const auto& fence = m_presentFences[m_presentSemaphoreIndex];
 
@@ -410,6 +413,8 @@ DepthBufferHandle GraphicsDevice::CreateDepthBuffer(const DepthBufferCreationPar
 
 CommandContextHandle GraphicsDevice::BeginCommandContext(const std::string& ID)
 {
+	ALLOCATION_TAG(Graphics);
+
 	auto* newContext = AllocateContext(CommandListType::Direct);
 
 	// TODO
@@ -728,27 +733,25 @@ void GraphicsDevice::QueueSignalSemaphore(QueueType queueType, VkSemaphore semap
 
 CommandContext* GraphicsDevice::AllocateContext(CommandListType commandListType)
 {
-	lock_guard<mutex> guard{ m_contextAllocationMutex };
-
-	auto& availableContexts = m_availableContexts[(uint32_t)commandListType];
-
-	CommandContext* context{ nullptr };
-	if (availableContexts.empty())
+	CommandContext* context = m_contextCache.Pop(commandListType);
+	if (context != nullptr)
+	{
+		context->Reset();
+	}
+	else
 	{
 		context = new CommandContext(commandListType);
 		CommandContextHandle handle;
 		handle.Attach(context);
-		m_contextPool[(uint32_t)commandListType].emplace_back(handle);
-		
+		{
+			lock_guard<mutex> guard{ m_contextCreationMutex };
+			m_contextPool[(uint32_t)commandListType].emplace_back(handle);
+		}
+
 		context->m_device = this;
+		context->m_cacheIndex = m_contextCache.AddContext(commandListType, context);
 		context->m_commandBuffer = GetQueue(commandListType).RequestCommandBuffer();
 	}
-	else
-	{
-		context = availableContexts.front();
-		availableContexts.pop();
-		context->Reset();
-	}
 
 	assert(context != nullptr);
 	assert(context->m_type == commandListType);
@@ -759,9 +762,7 @@ CommandContext* GraphicsDevice::AllocateContext(CommandListType commandListType)
 
 void GraphicsDevice::FreeContext(CommandContext* usedContext)
 {
-	lock_guard<mutex> guard{ m_contextAllocationMutex };
-
-	m_availableContexts[(uint32_t)usedContext->m_type].push(usedContext);
+	m_contextCache.Push(usedContext->m_type, usedContext->m_cacheIndex);
 }
 
 
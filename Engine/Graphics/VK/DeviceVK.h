@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "Graphics\CommandContextCache.h"
 #include "Graphics\Interfaces.h"
 #include "Graphics\VK\CommandContextVK.h"
 #include "Graphics\VK\VulkanCommon.h"
@@ -160,10 +161,10 @@ private:
 	// Submission queues
 	std::array<std::unique_ptr<Queue>, (uint32_t)QueueType::Count> m_queues;
 
-	// Command contexts
+	// Command contexts, owned by the pool, which is only touched when a context is created
 	std::array<std::vector<CommandContextHandle>, (uint32_t)CommandListType::Count> m_contextPool;
-	std::array<std::queue<CommandContext*>, (uint32_t)CommandListType::Count> m_availableContexts;
-	std::mutex m_contextAllocationMutex;
+	CommandContextCache<CommandContext> m_contextCache;
+	std::mutex m_contextCreationMutex;
 
 	// VmaAllocator
 	VmaAllocatorHandle m_vmaAllocator;
@@ -12,7 +12,7 @@
 
 #include "Graphics\VK\VulkanCommon.h"
 
-#include <unordered_set>
+#include "Core\FlatHashMap.h"
 
 
 namespace Kodiak::VK
@@ -20,9 +20,9 @@ namespace Kodiak::VK
 
 struct ExtensionSet
 {
-	std::unordered_set<std::string> instanceExtensions;
-	std::unordered_set<std::string> instanceLayers;
-	std::unordered_set<std::string> deviceExtensions;
+	FlatHashSet<std::string> instanceExtensions;
+	FlatHashSet<std::string> instanceLayers;
+	FlatHashSet<std::string> deviceExtensions;
 };
 
 
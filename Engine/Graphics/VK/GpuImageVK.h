@@ -18,9 +18,13 @@ namespace Kodiak::VK
 class __declspec(novtable) GpuImage : public virtual IGpuImage
 {
 public:
+	~GpuImage() override;
+
+	GpuImageId GetId() const noexcept override { return m_id; }
+
 	ResourceType GetType() const noexcept override { return m_resourceType;	}
-	ResourceState GetUsageState() const noexcept override {	return m_usageState; }
-	void SetUsageState(ResourceState usageState) noexcept override { m_usageState = usageState;	}
+	ResourceState GetUsageState() const noexcept override { return GetGpuImageTable().GetUsageState(m_id); }
+	void SetUsageState(ResourceState usageState) noexcept override { GetGpuImageTable().SetUsageState(m_id, usageState); }
 
 	uint64_t GetWidth() const noexcept override { return m_width; }
 	uint32_t GetHeight() const noexcept override { return m_height; }
@@ -45,6 +49,9 @@ protected:
 		Format format) noexcept;
 
 protected:
+	// Usage state is kept in the GpuImageTable entry
+	GpuImageId m_id;
+
 	VkImageHandle m_image;
 
 	uint64_t m_width{ 0 };
@@ -55,7 +62,6 @@ protected:
 	uint32_t m_planeCount{ 1 };
 
 	ResourceType m_resourceType{ ResourceType::Unknown };
-	ResourceState m_usageState{ ResourceState::Undefined };
 	ResourceState m_transitioningState{ ResourceState::Undefined };
 
 	Format m_format{ Format::Unknown };
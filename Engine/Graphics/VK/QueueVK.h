@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "Core\SmallVector.h"
 #include "Graphics\VK\CommandBufferPoolVK.h"
 #include "Graphics\VK\VulkanCommon.h"
 
@@ -59,11 +60,11 @@ private:
 	uint64_t m_nextFenceValue{ 0 };
 	uint64_t m_lastCompletedFenceValue{ 0 };
 
-	std::vector<VkSemaphore> m_waitSemaphores;
-	std::vector<uint64_t> m_waitSemaphoreValues;
-	std::vector<VkPipelineStageFlags> m_waitDstStageMask;
-	std::vector<VkSemaphore> m_signalSemaphores;
-	std::vector<uint64_t> m_signalSemaphoreValues;
+	SmallVector<VkSemaphore, 8> m_waitSemaphores;
+	SmallVector<uint64_t, 8> m_waitSemaphoreValues;
+	SmallVector<VkPipelineStageFlags, 8> m_waitDstStageMask;
+	SmallVector<VkSemaphore, 8> m_signalSemaphores;
+	SmallVector<uint64_t, 8> m_signalSemaphoreValues;
 };
 
 } // namespace Kodiak::VK
\ No newline at end of file
@@ -28,6 +28,8 @@ namespace Kodiak::VK
 
 void SetDebugNameImpl(VkDevice device, uint64_t obj, VkObjectType objType, const string& name)
 {
+	ALLOCATION_TAG(Graphics);
+
 	VkDebugUtilsObjectNameInfoEXT nameInfo{ VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT };
 	nameInfo.objectType = objType;
 	nameInfo.objectHandle = obj;
@@ -0,0 +1,404 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "JobSystem.h"
+
+#include "CpuTopology.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+JobSystem* g_jobSystem{ nullptr };
+
+thread_local int32_t t_threadIndex{ -1 };
+thread_local uint32_t t_stealSeed{ 0 };
+
+// Failed searches before an idle worker goes to sleep
+constexpr uint32_t s_spinCount{ 64 };
+
+
+uint32_t NextStealIndex(uint32_t numThreads)
+{
+	// xorshift, seeded per thread so the thieves spread out over the victims
+	if (t_stealSeed == 0)
+	{
+		t_stealSeed = (uint32_t)hash<thread::id>{}(this_thread::get_id()) | 1;
+	}
+	t_stealSeed ^= t_stealSeed << 13;
+	t_stealSeed ^= t_stealSeed >> 17;
+	t_stealSeed ^= t_stealSeed << 5;
+	return t_stealSeed % numThreads;
+}
+
+} // anonymous namespace
+
+
+namespace Kodiak
+{
+
+// Chase-Lev work-stealing deque, with the memory orderings from Le, Pop, Cohen and Zappa Nardelli,
+// "Correct and Efficient Work-Stealing for Weak Memory Models".  Only the owning thread pushes and
+// pops, at the bottom.  Any thread can steal from the top.  Fixed capacity, Push fails when full.
+class JobDeque : NonCopyable, NonMovable
+{
+public:
+	bool Push(Job* job) noexcept
+	{
+		const int64_t bottom = m_bottom.load(memory_order_relaxed);
+		const int64_t top = m_top.load(memory_order_acquire);
+		if (bottom - top >= s_capacity)
+		{
+			return false;
+		}
+
+		// Release on the slot as well as the fence, which costs nothing on x64 and lets race
+		// detectors that don't model fences follow the handoff
+		m_jobs[bottom & s_mask].store(job, memory_order_release);
+		atomic_thread_fence(memory_order_release);
+		m_bottom.store(bottom + 1, memory_order_relaxed);
+		return true;
+	}
+
+	Job* Pop() noexcept
+	{
+		const int64_t bottom = m_bottom.load(memory_order_relaxed) - 1;
+		m_bottom.store(bottom, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+		int64_t top = m_top.load(memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			// Empty
+			m_bottom.store(bottom + 1, memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = m_jobs[bottom & s_mask].load(memory_order_acquire);
+		if (top == bottom)
+		{
+			// Last job, race the thieves for it
+			if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+			m_bottom.store(bottom + 1, memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* Steal() noexcept
+	{
+		int64_t top = m_top.load(memory_order_acquire);
+		atomic_thread_fence(memory_order_seq_cst);
+		const int64_t bottom = m_bottom.load(memory_order_acquire);
+
+		if (top >= bottom)
+		{
+			return nullptr;
+		}
+
+		Job* job = m_jobs[top & s_mask].load(memory_order_acquire);
+		if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+		{
+			// Lost to another thief or the owner
+			return nullptr;
+		}
+		return job;
+	}
+
+private:
+	static constexpr int64_t s_capacity{ 4096 };
+	static constexpr int64_t s_mask{ s_capacity - 1 };
+
+	// Thieves hammer m_top, keep it off the owner's cache line
+	alignas(64) atomic<int64_t> m_top{ 0 };
+	alignas(64) atomic<int64_t> m_bottom{ 0 };
+	array<atomic<Job*>, s_capacity> m_jobs{};
+};
+
+} // namespace Kodiak
+
+
+JobSystem::JobSystem(uint32_t numWorkers)
+{
+	if (numWorkers == 0)
+	{
+		numWorkers = std::max(thread::hardware_concurrency(), 2u) - 1;
+	}
+
+	m_deques.reserve(numWorkers + 1);
+	for (uint32_t i = 0; i <= numWorkers; ++i)
+	{
+		m_deques.emplace_back(make_unique<JobDeque>());
+	}
+
+	assert(g_jobSystem == nullptr);
+	g_jobSystem = this;
+	t_threadIndex = 0;
+
+	m_workers.reserve(numWorkers);
+	for (uint32_t i = 1; i <= numWorkers; ++i)
+	{
+		m_workers.emplace_back([this, i] { WorkerLoop(i); });
+	}
+}
+
+
+JobSystem::~JobSystem()
+{
+	// Finish anything still queued, fire-and-forget jobs included
+	while (Job* job = FindJob())
+	{
+		Execute(job);
+	}
+
+	m_quit.store(true, memory_order_release);
+	m_jobEpoch.fetch_add(1);
+	m_jobEpoch.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	t_threadIndex = -1;
+	g_jobSystem = nullptr;
+}
+
+
+void JobSystem::Run(JobFunc func, JobCounter* counter)
+{
+	if (counter)
+	{
+		counter->m_pending.fetch_add(1, memory_order_relaxed);
+	}
+
+	Submit(new Job{ move(func), counter, true });
+	WakeWorkers(1);
+}
+
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	WaitUntil([&counter] { return counter.IsDone(); });
+}
+
+
+void JobSystem::WaitUntil(const function<bool()>& condition)
+{
+	while (!condition())
+	{
+		if (Job* job = FindJob())
+		{
+			Execute(job);
+			continue;
+		}
+
+		// Nothing to help with, the remaining jobs are running on other threads
+		m_numSleepingWaiters.fetch_add(1);
+		const uint32_t epoch = m_completionEpoch.load();
+		if (!condition())
+		{
+			m_completionEpoch.wait(epoch);
+		}
+		m_numSleepingWaiters.fetch_sub(1);
+	}
+}
+
+
+int32_t JobSystem::GetThreadIndex() const noexcept
+{
+	return t_threadIndex;
+}
+
+
+bool JobSystem::SetWorkerAffinity(uint32_t threadIndex, const CpuSet& cpuSet)
+{
+	assert(threadIndex > 0 && threadIndex < GetNumThreads());
+
+	return SetThreadAffinity(m_workers[threadIndex - 1], cpuSet);
+}
+
+
+void JobSystem::Submit(span<Job> jobs, JobCounter& counter)
+{
+	counter.m_pending.fetch_add((uint32_t)jobs.size(), memory_order_relaxed);
+
+	for (auto& job : jobs)
+	{
+		job.counter = &counter;
+		job.ownedBySystem = false;
+		Submit(&job);
+	}
+
+	WakeWorkers((uint32_t)jobs.size());
+}
+
+
+void JobSystem::Submit(Job* job)
+{
+	if (t_threadIndex >= 0 && m_deques[t_threadIndex]->Push(job))
+	{
+		return;
+	}
+
+	lock_guard<mutex> lock(m_sharedQueueMutex);
+	m_sharedQueue.push_back(job);
+	m_sharedQueueSize.fetch_add(1, memory_order_release);
+}
+
+
+void JobSystem::WakeWorkers(uint32_t numJobs)
+{
+	// Pairs with the sleeping count and epoch reads in WorkerLoop, so either the worker sees the
+	// new job or we see the worker asleep
+	m_jobEpoch.fetch_add(1);
+
+	const uint32_t numSleeping = m_numSleepingWorkers.load();
+	if (numSleeping == 0)
+	{
+		return;
+	}
+
+	if (numJobs == 1)
+	{
+		m_jobEpoch.notify_one();
+	}
+	else
+	{
+		m_jobEpoch.notify_all();
+	}
+}
+
+
+Job* JobSystem::FindJob()
+{
+	const int32_t threadIndex = t_threadIndex;
+
+	if (threadIndex >= 0)
+	{
+		if (Job* job = m_deques[threadIndex]->Pop())
+		{
+			return job;
+		}
+	}
+
+	if (m_sharedQueueSize.load(memory_order_acquire) != 0)
+	{
+		lock_guard<mutex> lock(m_sharedQueueMutex);
+		if (!m_sharedQueue.empty())
+		{
+			Job* job = m_sharedQueue.front();
+			m_sharedQueue.pop_front();
+			m_sharedQueueSize.fetch_sub(1, memory_order_relaxed);
+			return job;
+		}
+	}
+
+	const uint32_t numThreads = GetNumThreads();
+	const uint32_t start = NextStealIndex(numThreads);
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		const uint32_t victim = (start + i) % numThreads;
+		if ((int32_t)victim == threadIndex)
+		{
+			continue;
+		}
+
+		if (Job* job = m_deques[victim]->Steal())
+		{
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+
+void JobSystem::Execute(Job* job)
+{
+	job->func();
+
+	JobCounter* counter = job->counter;
+
+	// Jobs that aren't ours belong to a waiting thread, which may free them as soon as the counter hits zero
+	if (job->ownedBySystem)
+	{
+		delete job;
+	}
+
+	if (counter && counter->m_pending.fetch_sub(1, memory_order_acq_rel) == 1)
+	{
+		// The counter may already be gone, so waiters sleep on the JobSystem instead
+		m_completionEpoch.fetch_add(1);
+		if (m_numSleepingWaiters.load() != 0)
+		{
+			m_completionEpoch.notify_all();
+		}
+	}
+}
+
+
+void JobSystem::WorkerLoop(uint32_t threadIndex)
+{
+	t_threadIndex = (int32_t)threadIndex;
+	SetThreadDescription(GetCurrentThread(), format(L"Kodiak Worker {}", threadIndex).c_str());
+	SetAllocationThreadName(format("Worker {}", threadIndex));
+
+	uint32_t failedSearches = 0;
+
+	while (!m_quit.load(memory_order_acquire))
+	{
+		if (Job* job = FindJob())
+		{
+			Execute(job);
+			failedSearches = 0;
+			continue;
+		}
+
+		if (++failedSearches < s_spinCount)
+		{
+			this_thread::yield();
+			continue;
+		}
+
+		// Look once more after announcing we're going to sleep, a job submitted after this
+		// epoch read wakes us
+		m_numSleepingWorkers.fetch_add(1);
+		const uint32_t epoch = m_jobEpoch.load();
+
+		Job* job = FindJob();
+		if (!job && !m_quit.load(memory_order_acquire))
+		{
+			m_jobEpoch.wait(epoch);
+		}
+		m_numSleepingWorkers.fetch_sub(1);
+
+		if (job)
+		{
+			Execute(job);
+		}
+		failedSearches = 0;
+	}
+}
+
+
+JobSystem* Kodiak::GetJobSystem()
+{
+	return g_jobSystem;
+}
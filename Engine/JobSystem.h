@@ -0,0 +1,176 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <deque>
+
+namespace Kodiak
+{
+
+// Forward declarations
+class CpuSet;
+class JobDeque;
+
+
+// Counts jobs that haven't finished yet.  Pass one to JobSystem::Run for each job in a batch,
+// then JobSystem::Wait on it.  Must outlive the jobs it counts.
+class JobCounter : NonCopyable, NonMovable
+{
+	friend class JobSystem;
+
+public:
+	bool IsDone() const noexcept { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	std::atomic<uint32_t> m_pending{ 0 };
+};
+
+
+using JobFunc = std::function<void()>;
+
+
+struct Job
+{
+	JobFunc func;
+	JobCounter* counter{ nullptr };
+	bool ownedBySystem{ false };
+};
+
+
+// Runs jobs on one worker thread per hardware thread, less one for the thread that creates the
+// JobSystem, which takes part whenever it waits.  Each thread pushes and pops jobs at the bottom
+// of its own Chase-Lev deque, and idle threads steal from the top of the others.  Threads that
+// aren't part of the system submit through a shared queue.  Waiting threads run other jobs
+// until their counter reaches zero, so waits from inside jobs don't deadlock.
+class JobSystem : NonCopyable, NonMovable
+{
+public:
+	// numWorkers == 0 picks one per hardware thread
+	explicit JobSystem(uint32_t numWorkers = 0);
+	~JobSystem();
+
+	void Run(JobFunc func, JobCounter* counter = nullptr);
+	void Wait(JobCounter& counter);
+
+	// Runs other jobs until condition() holds.  The condition has to become true before some
+	// JobCounter reaches zero, which is what wakes a waiting thread with nothing else to do.
+	void WaitUntil(const std::function<bool()>& condition);
+
+	// Calls func(i) for every i in [begin, end), in chunks of grain indices.  The calling
+	// thread runs the first chunk and helps with the rest, returning once all are done.
+	template <typename Func>
+	void ParallelFor(size_t begin, size_t end, size_t grain, Func&& func);
+
+	// Worker threads, plus the thread that created the JobSystem
+	uint32_t GetNumThreads() const noexcept { return (uint32_t)m_deques.size(); }
+
+	// Index of the calling thread, or -1 if it isn't part of the JobSystem
+	int32_t GetThreadIndex() const noexcept;
+
+	// Restricts a worker to a set of logical processors.  Thread 0 isn't a worker, place the
+	// creating thread itself.
+	bool SetWorkerAffinity(uint32_t threadIndex, const CpuSet& cpuSet);
+
+private:
+	void Submit(std::span<Job> jobs, JobCounter& counter);
+	void Submit(Job* job);
+	void WakeWorkers(uint32_t numJobs);
+
+	Job* FindJob();
+	void Execute(Job* job);
+
+	void WorkerLoop(uint32_t threadIndex);
+
+private:
+	// Index 0 belongs to the creating thread
+	std::vector<std::unique_ptr<JobDeque>> m_deques;
+	std::vector<std::thread> m_workers;
+
+	// Jobs submitted from other threads, or that didn't fit in a deque
+	std::mutex m_sharedQueueMutex;
+	std::deque<Job*> m_sharedQueue;
+	std::atomic<uint32_t> m_sharedQueueSize{ 0 };
+
+	// Bumped for every submission, idle workers sleep on it
+	std::atomic<uint32_t> m_jobEpoch{ 0 };
+	std::atomic<uint32_t> m_numSleepingWorkers{ 0 };
+
+	// Bumped whenever a counter reaches zero, threads with nothing left to help with sleep on it
+	std::atomic<uint32_t> m_completionEpoch{ 0 };
+	std::atomic<uint32_t> m_numSleepingWaiters{ 0 };
+
+	std::atomic<bool> m_quit{ false };
+};
+
+
+template <typename Func>
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grain, Func&& func)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	grain = std::max<size_t>(grain, 1);
+	const size_t numChunks = (end - begin + grain - 1) / grain;
+
+	// The jobs live on this frame, since it doesn't return until they have all run
+	JobCounter counter;
+	std::vector<Job> jobs(numChunks - 1);
+	for (size_t chunk = 1; chunk < numChunks; ++chunk)
+	{
+		const size_t chunkBegin = begin + chunk * grain;
+		const size_t chunkEnd = std::min(chunkBegin + grain, end);
+
+		jobs[chunk - 1].func = [&func, chunkBegin, chunkEnd]
+			{
+				for (size_t i = chunkBegin; i < chunkEnd; ++i)
+				{
+					func(i);
+				}
+			};
+	}
+
+	if (!jobs.empty())
+	{
+		Submit(jobs, counter);
+	}
+
+	const size_t firstEnd = std::min(begin + grain, end);
+	for (size_t i = begin; i < firstEnd; ++i)
+	{
+		func(i);
+	}
+
+	Wait(counter);
+}
+
+
+JobSystem* GetJobSystem();
+
+
+// Runs on the JobSystem if there is one, otherwise serially on the calling thread
+template <typename Func>
+void ParallelFor(size_t begin, size_t end, size_t grain, Func&& func)
+{
+	if (auto* jobSystem = GetJobSystem())
+	{
+		jobSystem->ParallelFor(begin, end, grain, std::forward<Func>(func));
+		return;
+	}
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		func(i);
+	}
+}
+
+} // namespace Kodiak
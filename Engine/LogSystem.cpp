@@ -10,6 +10,7 @@
 
 #include "Stdafx.h"
 
+#include "CpuTopology.h"
 #include "FileSystem.h"
 
 #include <iostream>
@@ -26,10 +27,20 @@ namespace
 LogSystem* g_logSystem{ nullptr };
 
 bool outputToFile{ true };
+bool outputToBinaryFile{ true };
 bool outputToConsole{ true };
 bool outputToDebug{ true };
 bool allowThreadedLogging{ true };
 
+size_t logSegmentSize{ 64 * 1024 * 1024 };
+uint32_t maxLogSegments{ 8 };
+size_t binaryLogSegmentSize{ 16 * 1024 * 1024 };
+uint32_t maxBinaryLogSegments{ 8 };
+
+// Producers wait for the log worker when the queue is full
+size_t messageQueueCapacity{ 4096 };
+size_t messageBatchSize{ 32 };
+
 
 string SeverityToString(Severity level)
 {
@@ -47,6 +58,127 @@ string SeverityToString(Severity level)
 	}
 }
 
+
+// One arg unpacked from LogMessage::args.  Strings point into the message.
+struct LogArg
+{
+	variant<int64_t, uint64_t, double, bool, string_view> value;
+};
+
+
+template <typename T>
+T ReadLogValue(string_view& data)
+{
+	T value{};
+	if (data.size() >= sizeof(T))
+	{
+		memcpy(&value, data.data(), sizeof(T));
+	}
+	data.remove_prefix(std::min(data.size(), sizeof(T)));
+	return value;
+}
+
+
+bool UnpackLogArgs(const LogMessage& message, span<LogArg> args)
+{
+	using enum BinaryLogArgType;
+
+	string_view data = message.args;
+	for (LogArg& arg : args)
+	{
+		switch (ReadLogValue<BinaryLogArgType>(data))
+		{
+		case String:
+		{
+			const uint32_t length = ReadLogValue<uint32_t>(data);
+			arg.value = data.substr(0, length);
+			data.remove_prefix(std::min<size_t>(data.size(), length));
+			break;
+		}
+		case Int:		arg.value = ReadLogValue<int64_t>(data); break;
+		case UInt:		arg.value = ReadLogValue<uint64_t>(data); break;
+		case Double:	arg.value = ReadLogValue<double>(data); break;
+		case Bool:		arg.value = ReadLogValue<uint8_t>(data) != 0; break;
+		default:		return false;
+		}
+	}
+	return true;
+}
+
+} // anonymous namespace
+
+
+// Formats a LogArg as its underlying type, with the spec from the format string.  Nested width and
+// precision args ("{:{}}") aren't supported.
+template <>
+struct std::formatter<LogArg>
+{
+	constexpr auto parse(format_parse_context& ctx)
+	{
+		auto it = ctx.begin();
+		while (it != ctx.end() && *it != '}')
+		{
+			++it;
+		}
+		m_spec = string_view{ ctx.begin(), it };
+		return it;
+	}
+
+	auto format(const LogArg& arg, format_context& ctx) const
+	{
+		return visit(
+			[&](const auto& value)
+			{
+				formatter<remove_cvref_t<decltype(value)>> valueFormatter;
+				format_parse_context specContext{ m_spec };
+				valueFormatter.parse(specContext);
+				return valueFormatter.format(value, ctx);
+			},
+			arg.value);
+	}
+
+private:
+	string_view m_spec;
+};
+
+
+namespace
+{
+
+template <size_t... Indices>
+string FormatLogArgs(string_view format, span<const LogArg> args, index_sequence<Indices...>)
+{
+	return vformat(format, make_format_args(args[Indices]...));
+}
+
+
+// Text for a message that was logged with a format string and packed args
+string FormatLogMessage(const LogMessage& message)
+{
+	using FormatFunc = string(*)(string_view, span<const LogArg>);
+	static constexpr auto s_formatFuncs = []<size_t... NumArgs>(index_sequence<NumArgs...>)
+	{
+		return array<FormatFunc, sizeof...(NumArgs)>{
+			[](string_view format, span<const LogArg> args) { return FormatLogArgs(format, args, make_index_sequence<NumArgs>{}); }... };
+	}(make_index_sequence<Detail::s_maxLogArgs + 1>{});
+
+	array<LogArg, Detail::s_maxLogArgs> args{};
+	const size_t numArgs = message.numArgs;
+	if (numArgs <= args.size() && UnpackLogArgs(message, span{ args.data(), numArgs }))
+	{
+		try
+		{
+			return s_formatFuncs[numArgs](message.format, span{ args.data(), numArgs }) + "\n";
+		}
+		catch (const format_error&)
+		{
+			// An arg that was logged as a string can't take a numeric spec, fall through
+		}
+	}
+
+	return format("{} (unformatted, {} args)\n", message.format, message.numArgs);
+}
+
 } // anonymous namespace
 
 
@@ -61,7 +193,8 @@ void Kodiak::PostLogMessage(LogMessage&& message)
 
 
 LogSystem::LogSystem()
-	: m_initialized(false)
+	: m_messageQueue(messageQueueCapacity)
+	, m_initialized(false)
 {
 	Initialize();
 
@@ -79,9 +212,20 @@ LogSystem::~LogSystem()
 
 void LogSystem::PostLogMessage(LogMessage&& message)
 {
+	ALLOCATION_TAG(Log);
+
+	message.timestamp = chrono::system_clock::now();
+	message.threadId = GetCurrentThreadId();
+
 	if (allowThreadedLogging)
 	{
-		m_messageQueue.push(move(message));
+		// A failed push leaves the message alone, so it can be retried
+		while (!m_messageQueue.TryPush(move(message)))
+		{
+			WakeWorker();
+			this_thread::yield();
+		}
+		WakeWorker();
 	}
 	else
 	{
@@ -90,36 +234,46 @@ void LogSystem::PostLogMessage(LogMessage&& message)
 }
 
 
+bool LogSystem::SetWorkerAffinity(const CpuSet& cpuSet)
+{
+	return SetThreadAffinity(m_workerThread, cpuSet);
+}
+
+
 void LogSystem::CreateLogFile()
 {
 	// Get the log directory path
 	FileSystem* fs = GetFileSystem();
 	fs->EnsureLogDirectory();
-	auto logPath = fs->GetLogPath();
-
-	// Build the filename
-	namespace chr = std::chrono;
-	auto systemTime = chr::system_clock::now();
-	auto localTime = chr::zoned_time{ chr::current_zone(), systemTime }.get_local_time();
-	string filename = format("Log-{:%Y%m%d%H%M%S}.txt", chr::floor<chr::seconds>(localTime));
 
-	// Build the full path
-	auto fullPath = logPath / filename;
+	auto logFileDesc = RollingLogFileDesc{}
+		.SetDirectory(fs->GetLogPath())
+		.SetBaseName("Log")
+		.SetExtension(".txt")
+		.SetLinkName("Log.txt")
+		.SetSegmentSize(logSegmentSize)
+		.SetMaxSegments(maxLogSegments);
 
-	// Open the file stream
-	m_file.open(fullPath.c_str(), ios::out | ios::trunc);
-	m_file << fixed;
-
-	// Create a hard link to the non-timestamped file
-	auto logFilePath = logPath / "Log.txt";
-	filesystem::remove(logFilePath);
-	try
+	if (!m_file.Open(logFileDesc))
 	{
-		filesystem::create_hard_link(fullPath, logFilePath);
+		cerr << "Failed to open log file in " << logFileDesc.directory.string() << endl;
 	}
-	catch (filesystem::filesystem_error e)
+
+	if (outputToBinaryFile)
 	{
-		cerr << e.what() << " " << e.path1().string() << " " << e.path2().string() << endl;
+		auto binaryFileDesc = RollingLogFileDesc{}
+			.SetDirectory(logFileDesc.directory)
+			.SetBaseName("Log")
+			.SetExtension(".klog")
+			.SetLinkName("Log.klog")
+			.SetTimestamp(m_file.GetTimestamp())
+			.SetSegmentSize(binaryLogSegmentSize)
+			.SetMaxSegments(maxBinaryLogSegments);
+
+		if (!m_binaryFile.Open(binaryFileDesc))
+		{
+			cerr << "Failed to open binary log file in " << binaryFileDesc.directory.string() << endl;
+		}
 	}
 }
 
@@ -140,15 +294,32 @@ void LogSystem::Initialize()
 
 	if (allowThreadedLogging)
 	{
-		m_workerLoop = async(launch::async,
+		m_workerThread = thread(
 			[&]
 			{
-				while (!m_haltLogging)
+				SetAllocationThreadName("Log");
+				ALLOCATION_TAG(Log);
+
+				vector<LogMessage> messages(messageBatchSize);
+
+				// Drains the queue before exiting, so messages posted before Shutdown are written
+				for (;;)
 				{
-					LogMessage message{};
-					if (m_messageQueue.try_pop(message))
+					const bool halting = m_haltLogging;
+
+					const size_t numMessages = m_messageQueue.TryPopBatch(messages);
+					for (size_t i = 0; i < numMessages; ++i)
+					{
+						OutputLogMessage(messages[i]);
+					}
+
+					if (numMessages == 0)
 					{
-						OutputLogMessage(message);
+						if (halting)
+						{
+							break;
+						}
+						WaitForMessages();
 					}
 				}
 			}
@@ -172,11 +343,13 @@ void LogSystem::Shutdown()
 	m_haltLogging = true;
 	if (allowThreadedLogging)
 	{
-		m_workerLoop.get();
+		m_wakeCounter.fetch_add(1);
+		m_wakeCounter.notify_one();
+		m_workerThread.join();
 	}
 
-	m_file.flush();
-	m_file.close();
+	m_file.Close();
+	m_binaryFile.Close();
 
 	m_initialized = false;
 }
@@ -187,28 +360,33 @@ void LogSystem::OutputLogMessage(const LogMessage& message)
 	using enum Severity;
 
 	namespace chr = std::chrono;
-	const auto systemTime = chr::system_clock::now();
-	const auto localTime = chr::zoned_time{ chr::current_zone(), systemTime }.get_local_time();
+	const auto localTime = chr::zoned_time{ chr::current_zone(), message.timestamp }.get_local_time();
 	const auto localTimeStr = format("[{:%Y.%m.%d-%H.%M.%S}]", chr::floor<chr::milliseconds>(localTime));
 
-	const string categoryStr = format("{}: ", message.category.GetName());
 	const string severityStr = (message.severity == Severity::Log) ? "" : format("{}: ", SeverityToString(message.severity));
 
+	const string formattedStr = message.format.empty() ? string{} : FormatLogMessage(message);
+	const string& bodyStr = message.format.empty() ? message.messageStr : formattedStr;
+
 	string messageStr;
 	if (message.category.IsValid())
 	{
-		messageStr = format("{} {}{}{}", localTimeStr, categoryStr, severityStr, message.messageStr);
+		messageStr = format("{} {}: {}{}", localTimeStr, message.category.GetName(), severityStr, bodyStr);
 	}
 	else
 	{
-		messageStr = format("{} {}{}", localTimeStr, severityStr, message.messageStr);
+		messageStr = format("{} {}{}", localTimeStr, severityStr, bodyStr);
 	}
 
 
 	if (outputToFile)
 	{
-		m_file.flush();
-		m_file << messageStr;
+		m_file.Write(messageStr);
+	}
+
+	if (outputToBinaryFile)
+	{
+		m_binaryFile.Write(message);
 	}
 
 	if (outputToConsole)
@@ -230,8 +408,8 @@ void LogSystem::OutputLogMessage(const LogMessage& message)
 
 	if (message.severity == Fatal)
 	{
-		m_file.flush();
-		m_file.close();
+		m_file.Close();
+		m_binaryFile.Close();
 
 		cerr.flush();
 		cout.flush();
@@ -244,4 +422,35 @@ void LogSystem::OutputLogMessage(const LogMessage& message)
 Kodiak::LogSystem* Kodiak::GetLogSystem()
 {
 	return g_logSystem;
+}
+
+
+// The worker flags that it's about to sleep and then checks the queue, producers push and then check
+// the flag.  With a full fence between the two steps on each side, either the worker sees the message
+// or the producer sees the flag, and producers only pay for a notify while the worker is asleep.
+void LogSystem::WaitForMessages()
+{
+	const uint32_t wakeCount = m_wakeCounter.load();
+
+	m_workerWaiting.store(true, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (m_messageQueue.IsEmpty() && !m_haltLogging)
+	{
+		m_wakeCounter.wait(wakeCount);
+	}
+
+	m_workerWaiting.store(false, memory_order_relaxed);
+}
+
+
+void LogSystem::WakeWorker()
+{
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (m_workerWaiting.load(memory_order_relaxed))
+	{
+		m_wakeCounter.fetch_add(1);
+		m_wakeCounter.notify_one();
+	}
 }
\ No newline at end of file
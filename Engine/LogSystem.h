@@ -10,11 +10,17 @@
 
 #pragma once
 
-#include <concurrent_queue.h>
+#include "BinaryLogFile.h"
+#include "Core\RingBuffer.h"
+#include "RollingLogFile.h"
 
 namespace Kodiak
 {
 
+// Forward declarations
+class CpuSet;
+
+
 enum class Severity
 {
 	Fatal,
@@ -27,32 +33,45 @@ enum class Severity
 };
 
 
+// The name is interned, so a category copies into every LogMessage as an integer
 class LogCategory
 {
 public:
 	LogCategory() = default;
-	explicit LogCategory(const std::string& name) : m_name{ name } {}
+	explicit LogCategory(std::string_view name) : m_name{ name } {}
 
 	bool IsValid() const noexcept
 	{
-		return !m_name.empty();
+		return m_name.IsValid();
+	}
+
+	std::string_view GetName() const noexcept
+	{
+		return m_name.GetString();
 	}
 
-	const std::string& GetName() const
+	StringId GetNameId() const noexcept
 	{
 		return m_name;
 	}
 
 private:
-	std::string m_name;
+	StringId m_name;
 };
 
 
+// Either preformatted text (messageStr), or a format string and its args packed as binary log args
+// (see BinaryLogFile.h), formatted on the log thread
 struct LogMessage
 {
 	std::string messageStr;
 	Severity severity;
 	LogCategory category;
+	std::chrono::system_clock::time_point timestamp{};
+	uint32_t threadId{ 0 };
+	std::string_view format;
+	std::string args;
+	uint8_t numArgs{ 0 };
 };
 
 void PostLogMessage(LogMessage&& message);
@@ -68,6 +87,9 @@ public:
 
 	void PostLogMessage(LogMessage&& message);
 
+	// Restricts the thread that writes the log files to a set of logical processors
+	bool SetWorkerAffinity(const CpuSet& cpuSet);
+
 private:
 	void CreateLogFile();
 	void Initialize();
@@ -75,16 +97,81 @@ private:
 
 	void OutputLogMessage(const LogMessage& message);
 
+	void WaitForMessages();
+	void WakeWorker();
+
 private:
 	std::mutex m_initializationMutex;
-	std::ofstream m_file;
-	Concurrency::concurrent_queue<LogMessage> m_messageQueue;
+	RollingLogFile m_file;
+	BinaryLogFile m_binaryFile;
+	MpmcRingBuffer<LogMessage> m_messageQueue;
 	std::atomic<bool> m_haltLogging;
-	std::future<void> m_workerLoop;
+	std::atomic<bool> m_workerWaiting{ false };
+	std::atomic<uint32_t> m_wakeCounter{ 0 };
+	std::thread m_workerThread;
 	std::atomic<bool> m_initialized;
 };
 
 
+namespace Detail
+{
+
+constexpr size_t s_maxLogArgs{ 12 };
+
+template <typename T>
+void AppendLogValue(std::string& args, T value)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	args.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+inline void AppendLogString(std::string& args, std::string_view str)
+{
+	str = str.substr(0, BinaryLogFile::s_maxStringLength);
+	AppendLogValue(args, BinaryLogArgType::String);
+	AppendLogValue(args, (uint32_t)str.size());
+	args.append(str);
+}
+
+// Anything that isn't a number, bool or string is formatted with "{}" here and logged as a string
+template <typename T>
+void AppendLogArg(std::string& args, const T& value)
+{
+	constexpr bool isInteger = std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>;
+
+	if constexpr (std::is_same_v<T, bool>)
+	{
+		AppendLogValue(args, BinaryLogArgType::Bool);
+		AppendLogValue(args, (uint8_t)value);
+	}
+	else if constexpr (isInteger && std::is_signed_v<T>)
+	{
+		AppendLogValue(args, BinaryLogArgType::Int);
+		AppendLogValue(args, (int64_t)value);
+	}
+	else if constexpr (isInteger)
+	{
+		AppendLogValue(args, BinaryLogArgType::UInt);
+		AppendLogValue(args, (uint64_t)value);
+	}
+	else if constexpr (std::is_floating_point_v<T>)
+	{
+		AppendLogValue(args, BinaryLogArgType::Double);
+		AppendLogValue(args, (double)value);
+	}
+	else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+	{
+		AppendLogString(args, value);
+	}
+	else
+	{
+		AppendLogString(args, std::format("{}", value));
+	}
+}
+
+} // namespace Detail
+
+
 class LogBase
 {
 public:
@@ -103,6 +190,7 @@ public:
 		{}
 		~LogProxy()
 		{
+			ALLOCATION_TAG(Log);
 			m_stream.flush();
 			PostLogMessage({ m_stream.str(), m_severity, m_category });
 		}
@@ -110,12 +198,14 @@ public:
 		template <typename T>
 		LogProxy& operator<<(const T& value)
 		{
+			ALLOCATION_TAG(Log);
 			m_stream << value;
 			return *this;
 		}
 
 		LogProxy& operator<<(std::ostream& (*os)(std::ostream&))
 		{
+			ALLOCATION_TAG(Log);
 			m_stream << os;
 			return *this;
 		}
@@ -131,6 +221,23 @@ public:
 		return LogProxy{ m_severity, category };
 	}
 
+	// LogInfo(LogApplication, "Loaded {} in {:.2f} ms", name, ms).  The caller only packs the args,
+	// formatting happens on the log thread, and the binary log keeps the format id and typed args.
+	// The format string must be a literal, the log thread reads it later.  No trailing newline.
+	template <typename... Args>
+	void operator()(const LogCategory& category, std::format_string<Args...> fmt, Args&&... args)
+	{
+		static_assert(sizeof...(Args) <= Detail::s_maxLogArgs);
+
+		ALLOCATION_TAG(Log);
+
+		LogMessage message{ {}, m_severity, category };
+		message.format = fmt.get();
+		(Detail::AppendLogArg(message.args, args), ...);
+		message.numArgs = (uint8_t)sizeof...(Args);
+		PostLogMessage(std::move(message));
+	}
+
 	template <typename T>
 	LogProxy operator<<(const T& value)
 	{
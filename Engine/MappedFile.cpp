@@ -0,0 +1,39 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "MappedFile.h"
+
+
+namespace Kodiak
+{
+
+void MappedFile::Destroy()
+{
+	if (m_parent)
+	{
+		m_parent = nullptr;
+	}
+	else if (!m_contents.empty())
+	{
+		m_contents = {};
+	}
+	else if (m_view != nullptr)
+	{
+		UnmapViewOfFile(m_view);
+	}
+
+	m_view = nullptr;
+
+	m_size = 0;
+}
+
+} // namespace Kodiak
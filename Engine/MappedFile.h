@@ -0,0 +1,71 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+namespace Kodiak
+{
+
+enum class MapFileHint : uint32_t
+{
+	None =			0,
+	Sequential =	1 << 0,	// Contents will be read front to back
+	WillNeed =		1 << 1	// Prefetch the whole view into memory now
+};
+template <> struct EnableBitmaskOperators<MapFileHint> { static const bool enable = true; };
+
+
+//
+// Read-only view of a memory-mapped file.  The view stays valid for as long as a reference is held.
+// The view keeps the underlying file mapping alive, so no file or mapping handles are retained.
+//
+class MappedFile : public IObject, public NonCopyable
+{
+	IMPLEMENT_IOBJECT
+
+public:
+	MappedFile() noexcept = default;
+	MappedFile(const std::byte* view, size_t size) noexcept
+		: m_view{ view }
+		, m_size{ size }
+	{}
+	// Contents produced in memory rather than mapped, such as a decompressed pack entry
+	explicit MappedFile(std::vector<std::byte>&& contents) noexcept
+		: m_contents{ std::move(contents) }
+		, m_view{ m_contents.data() }
+		, m_size{ m_contents.size() }
+	{}
+	// Sub-range of another mapping, which is kept alive by this view
+	MappedFile(IntrusivePtr<MappedFile> parent, const std::byte* view, size_t size) noexcept
+		: m_parent{ parent }
+		, m_view{ view }
+		, m_size{ size }
+	{}
+
+	~MappedFile() final
+	{
+		Destroy();
+	}
+
+	std::span<const std::byte> GetData() const noexcept { return { m_view, m_size }; }
+	const std::byte* GetPointer() const noexcept { return m_view; }
+	size_t GetSize() const noexcept { return m_size; }
+
+	void Destroy();
+
+private:
+	IntrusivePtr<MappedFile> m_parent;
+	std::vector<std::byte> m_contents;
+	const std::byte* m_view{ nullptr };
+	size_t m_size{ 0 };
+};
+using MappedFileHandle = IntrusivePtr<MappedFile>;
+
+} // namespace Kodiak
@@ -0,0 +1,291 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "PackFile.h"
+
+#include "Core\Compression.h"
+#include "Core\Hash.h"
+#include "FileSystem.h"
+#include "JobSystem.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+namespace
+{
+
+bool EntryLess(uint64_t hashA, string_view nameA, uint64_t hashB, string_view nameB)
+{
+	return (hashA != hashB) ? (hashA < hashB) : (nameA < nameB);
+}
+
+} // anonymous namespace
+
+
+PackFile::PackFile(const string& fullPath, MappedFileHandle mappedFile)
+	: m_fullPath{ fullPath }
+	, m_mappedFile{ mappedFile }
+{}
+
+
+bool PackFile::Initialize()
+{
+	const auto data = m_mappedFile->GetData();
+
+	if (data.size() < sizeof(PackHeader))
+	{
+		LogError(LogFileSystem) << "Pack file " << m_fullPath << " is too small to hold a header" << endl;
+		return false;
+	}
+
+	PackHeader header{};
+	memcpy(&header, data.data(), sizeof(PackHeader));
+
+	if (memcmp(header.magic, s_magic, sizeof(s_magic)) != 0 || header.version == 0 || header.version > s_version)
+	{
+		LogError(LogFileSystem) << "Pack file " << m_fullPath << " has an unknown format or version" << endl;
+		return false;
+	}
+
+	// Offsets and sizes come from the file, so compare without adding them, a sum could wrap
+	const auto fitsInFile = [fileSize = (uint64_t)data.size()](uint64_t offset, uint64_t size)
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	};
+
+	const uint64_t tocSize = (uint64_t)header.entryCount * sizeof(PackEntry);
+	if (!fitsInFile(header.tocOffset, tocSize) || !fitsInFile(header.namesOffset, header.namesSize) || (header.tocOffset % alignof(PackEntry)) != 0)
+	{
+		LogError(LogFileSystem) << "Pack file " << m_fullPath << " has a truncated table of contents" << endl;
+		return false;
+	}
+
+	m_entries = { reinterpret_cast<const PackEntry*>(data.data() + header.tocOffset), header.entryCount };
+	m_names = { reinterpret_cast<const char*>(data.data() + header.namesOffset), (size_t)header.namesSize };
+
+	for (const auto& entry : m_entries)
+	{
+		if ((uint64_t)entry.nameOffset + entry.nameLength > m_names.size() || !fitsInFile(entry.dataOffset, entry.storedSize))
+		{
+			LogError(LogFileSystem) << "Pack file " << m_fullPath << " has an entry outside of the file" << endl;
+			return false;
+		}
+
+		// Uncompressed entries are read straight out of the payload, size bytes of it
+		if (!HasFlag(entry.flags, PackEntryFlags::Compressed) && entry.storedSize != entry.size)
+		{
+			LogError(LogFileSystem) << "Pack file " << m_fullPath << " has an uncompressed entry whose stored size doesn't match its size" << endl;
+			return false;
+		}
+	}
+
+	if (header.hashKind != GetHashKind())
+	{
+		m_rehashedEntries.reserve(m_entries.size());
+		for (uint32_t i = 0; i < GetNumEntries(); ++i)
+		{
+			m_rehashedEntries.emplace_back(HashName(GetName(i)), i);
+		}
+
+		sort(m_rehashedEntries.begin(), m_rehashedEntries.end(),
+			[this](const auto& a, const auto& b) { return EntryLess(a.first, GetName(a.second), b.first, GetName(b.second)); });
+	}
+
+	return true;
+}
+
+
+string_view PackFile::GetName(uint32_t index) const
+{
+	const PackEntry& entry = m_entries[index];
+	return m_names.substr(entry.nameOffset, entry.nameLength);
+}
+
+
+bool PackFile::Find(string_view normalizedName, uint32_t& index) const
+{
+	const uint64_t hash = HashName(normalizedName);
+
+	if (m_rehashedEntries.empty())
+	{
+		auto it = lower_bound(m_entries.begin(), m_entries.end(), hash,
+			[this](const PackEntry& entry, uint64_t value) { return entry.hash < value; });
+
+		for (; it != m_entries.end() && it->hash == hash; ++it)
+		{
+			const uint32_t candidate = (uint32_t)(it - m_entries.begin());
+			if (GetName(candidate) == normalizedName)
+			{
+				index = candidate;
+				return true;
+			}
+		}
+	}
+	else
+	{
+		auto it = lower_bound(m_rehashedEntries.begin(), m_rehashedEntries.end(), hash,
+			[](const auto& entry, uint64_t value) { return entry.first < value; });
+
+		for (; it != m_rehashedEntries.end() && it->first == hash; ++it)
+		{
+			if (GetName(it->second) == normalizedName)
+			{
+				index = it->second;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+
+span<const byte> PackFile::GetStoredData(uint32_t index) const
+{
+	const PackEntry& entry = m_entries[index];
+	return m_mappedFile->GetData().subspan(entry.dataOffset, entry.storedSize);
+}
+
+
+MappedFileHandle PackFile::MapEntry(uint32_t index) const
+{
+	if (IsCompressed(index))
+	{
+		vector<byte> contents(m_entries[index].size);
+		if (!ReadEntry(index, 0, contents))
+		{
+			LogError(LogFileSystem) << "Pack file " << m_fullPath << " has a malformed compressed entry " << GetName(index) << endl;
+			return nullptr;
+		}
+		return MappedFileHandle::Create(new MappedFile(move(contents)));
+	}
+
+	const auto storedData = GetStoredData(index);
+	return MappedFileHandle::Create(new MappedFile(m_mappedFile, storedData.data(), storedData.size()));
+}
+
+
+bool PackFile::ReadEntry(uint32_t index, uint64_t offset, span<byte> destination) const
+{
+	const PackEntry& entry = m_entries[index];
+	if (offset > entry.size || destination.size() > entry.size - offset)
+	{
+		return false;
+	}
+
+	const auto storedData = GetStoredData(index);
+
+	if (!IsCompressed(index))
+	{
+		memcpy(destination.data(), storedData.data() + offset, destination.size());
+		return true;
+	}
+
+	if (destination.empty())
+	{
+		return true;
+	}
+
+	const uint64_t numBlocks = (entry.size + s_compressionBlockSize - 1) / s_compressionBlockSize;
+	if (storedData.size() < (numBlocks + 1) * sizeof(uint64_t))
+	{
+		return false;
+	}
+	// Payloads are 4KB aligned, so the offset table is naturally aligned
+	const uint64_t* blockOffsets = reinterpret_cast<const uint64_t*>(storedData.data());
+
+	const uint64_t rangeEnd = offset + destination.size();
+	const uint64_t firstBlock = offset / s_compressionBlockSize;
+	const uint64_t lastBlock = (rangeEnd - 1) / s_compressionBlockSize;
+
+	atomic<bool> succeeded{ true };
+
+	ParallelFor((size_t)firstBlock, (size_t)lastBlock + 1, 1,
+		[&](size_t block)
+		{
+			const uint64_t blockStart = block * s_compressionBlockSize;
+			const size_t blockSize = (size_t)std::min(s_compressionBlockSize, entry.size - blockStart);
+
+			const uint64_t storedStart = blockOffsets[block];
+			const uint64_t storedEnd = blockOffsets[block + 1];
+			if (storedStart > storedEnd || storedEnd > storedData.size())
+			{
+				succeeded = false;
+				return;
+			}
+			const auto storedBlock = storedData.subspan(storedStart, storedEnd - storedStart);
+
+			// The part of this block that lands in the destination
+			const uint64_t copyStart = std::max(blockStart, offset);
+			const uint64_t copyEnd = std::min(blockStart + blockSize, rangeEnd);
+			const auto blockDestination = destination.subspan(copyStart - offset, copyEnd - copyStart);
+
+			if (storedBlock.size() == blockSize)
+			{
+				memcpy(blockDestination.data(), storedBlock.data() + (copyStart - blockStart), blockDestination.size());
+			}
+			else if (blockDestination.size() == blockSize)
+			{
+				if (!Utility::DecompressBlock(storedBlock, blockDestination))
+				{
+					succeeded = false;
+				}
+			}
+			else
+			{
+				// Partial block at either end of the range, decode the whole block and copy out the part we need
+				vector<byte> scratch(blockSize);
+				if (!Utility::DecompressBlock(storedBlock, scratch))
+				{
+					succeeded = false;
+					return;
+				}
+				memcpy(blockDestination.data(), scratch.data() + (copyStart - blockStart), blockDestination.size());
+			}
+		});
+
+	return succeeded;
+}
+
+
+uint64_t PackFile::HashName(string_view normalizedName)
+{
+	// HashRange works on whole words, so zero-pad the name
+	constexpr size_t s_stackWords = 64;
+	const size_t numWords = (normalizedName.size() + 3) / 4;
+
+	uint32_t stackWords[s_stackWords];
+	vector<uint32_t> heapWords;
+
+	uint32_t* words = stackWords;
+	if (numWords > s_stackWords)
+	{
+		heapWords.resize(numWords);
+		words = heapWords.data();
+	}
+
+	if (numWords > 0)
+	{
+		words[numWords - 1] = 0;
+		memcpy(words, normalizedName.data(), normalizedName.size());
+	}
+
+	return (uint64_t)Utility::HashRange(words, words + numWords, Utility::g_hashStart);
+}
+
+
+PackHashKind PackFile::GetHashKind() noexcept
+{
+	return (Utility::GetHashKind() == Utility::HashKind::Crc32c) ? PackHashKind::Crc32c : PackHashKind::MultiplyMix;
+}
@@ -0,0 +1,133 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "MappedFile.h"
+
+
+namespace Kodiak
+{
+
+// Pack file layout (all values little-endian).  Built by Programs\PackBuilder\BuildPack.py.
+//
+//   PackHeader
+//   PackEntry[entryCount]     sorted by (hash, name)
+//   char[namesSize]           normalized names (see FileSystem::NormalizePath), not null terminated
+//   payloads                  each starts on a s_packAlignment boundary
+//
+// Compressed payloads (PackEntryFlags::Compressed) split the contents into s_compressionBlockSize blocks,
+// each compressed independently with Utility::CompressBlock:
+//
+//   u64 blockOffsets[blockCount + 1]   relative to the payload start, block i is [offsets[i], offsets[i + 1])
+//   blocks
+//
+// A block whose stored size equals its decompressed size is stored uncompressed.
+//
+// Entry hashes are Utility::HashRange of the name, zero-padded to a multiple of 4 bytes, seeded
+// with Utility::g_hashStart.  HashRange differs between CPUs with and without hardware CRC32, so the
+// header records which flavor was used.  Packs built with the other flavor are rehashed on load.
+enum class PackHashKind : uint16_t
+{
+	Crc32c =			1,
+	MultiplyMix =		2
+};
+
+
+enum class PackEntryFlags : uint16_t
+{
+	None =			0,
+	Compressed =	1 << 0
+};
+template <> struct EnableBitmaskOperators<PackEntryFlags> { static const bool enable = true; };
+
+
+struct PackHeader
+{
+	char magic[4];
+	uint16_t version;
+	PackHashKind hashKind;
+	uint32_t entryCount;
+	uint32_t reserved;
+	uint64_t tocOffset;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+static_assert(sizeof(PackHeader) == 40);
+
+
+struct PackEntry
+{
+	uint64_t hash;
+	uint64_t dataOffset;
+	uint64_t size;			// Size of the file contents
+	uint64_t storedSize;	// Size of the payload in the pack
+	uint32_t nameOffset;
+	uint16_t nameLength;
+	PackEntryFlags flags;
+};
+static_assert(sizeof(PackEntry) == 40);
+
+
+// Read-only archive of files, memory-mapped in full.  Lookups binary search the table of
+// contents in the mapping, so resolving a name inside a mounted pack makes no system calls.
+class PackFile : public IObject, public NonCopyable
+{
+	IMPLEMENT_IOBJECT
+
+public:
+	static constexpr char s_magic[4]{ 'K', 'P', 'A', 'K' };
+	static constexpr uint16_t s_version{ 2 };
+	static constexpr uint64_t s_packAlignment{ 4096 };
+	static constexpr uint64_t s_compressionBlockSize{ 64 * 1024 };
+
+	PackFile(const std::string& fullPath, MappedFileHandle mappedFile);
+
+	// Validates the header and table of contents, returns false if this isn't a usable pack
+	bool Initialize();
+
+	const std::string& GetPath() const noexcept { return m_fullPath; }
+	uint32_t GetNumEntries() const noexcept { return (uint32_t)m_entries.size(); }
+	const PackEntry& GetEntry(uint32_t index) const { return m_entries[index]; }
+	std::string_view GetName(uint32_t index) const;
+
+	// normalizedName must already be normalized with FileSystem::NormalizePath
+	bool Find(std::string_view normalizedName, uint32_t& index) const;
+
+	bool IsCompressed(uint32_t index) const { return HasFlag(m_entries[index].flags, PackEntryFlags::Compressed); }
+
+	// The payload bytes of an entry, as stored in the pack
+	std::span<const std::byte> GetStoredData(uint32_t index) const;
+	// A view of an entry's contents.  Uncompressed entries keep the pack mapping alive,
+	// compressed entries are decompressed into memory owned by the view.
+	MappedFileHandle MapEntry(uint32_t index) const;
+
+	// Copies the entry's contents starting at offset into destination.  Compressed entries only decode
+	// the blocks overlapping the range, and decode them in parallel.  Returns false if the range is
+	// outside the entry or the data is malformed.
+	bool ReadEntry(uint32_t index, uint64_t offset, std::span<std::byte> destination) const;
+
+	static uint64_t HashName(std::string_view normalizedName);
+	static PackHashKind GetHashKind() noexcept;
+
+private:
+	std::string m_fullPath;
+	MappedFileHandle m_mappedFile;
+
+	std::span<const PackEntry> m_entries;
+	std::string_view m_names;
+
+	// Only used when the pack was hashed with a different HashRange flavor than this build.
+	// (hash, entry index), sorted the same way as the table of contents.
+	std::vector<std::pair<uint64_t, uint32_t>> m_rehashedEntries;
+};
+using PackFileHandle = IntrusivePtr<PackFile>;
+
+} // namespace Kodiak
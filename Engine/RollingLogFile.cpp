@@ -0,0 +1,203 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "RollingLogFile.h"
+
+#include <iostream>
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+RollingLogFile::~RollingLogFile()
+{
+	Close();
+}
+
+
+bool RollingLogFile::Open(const RollingLogFileDesc& desc)
+{
+	assert(!IsOpen());
+	assert(desc.segmentSize > 0);
+	assert(desc.maxSegments > 0);
+
+	m_desc = desc;
+	m_segmentIndex = 0;
+
+	// All segments from this run share a timestamp
+	if (desc.timestamp.empty())
+	{
+		namespace chr = std::chrono;
+		auto systemTime = chr::system_clock::now();
+		auto localTime = chr::zoned_time{ chr::current_zone(), systemTime }.get_local_time();
+		m_timestamp = format("{:%Y%m%d%H%M%S}", chr::floor<chr::seconds>(localTime));
+	}
+	else
+	{
+		m_timestamp = desc.timestamp;
+	}
+
+	return OpenSegment();
+}
+
+
+void RollingLogFile::Close()
+{
+	CloseSegment();
+}
+
+
+void RollingLogFile::Write(string_view str)
+{
+	while (IsOpen() && !str.empty())
+	{
+		const size_t bytesAvailable = m_desc.segmentSize - m_writeOffset;
+		if (bytesAvailable == 0)
+		{
+			CloseSegment();
+			OpenSegment();
+			continue;
+		}
+
+		const size_t bytesToCopy = std::min(bytesAvailable, str.size());
+		memcpy(m_data + m_writeOffset, str.data(), bytesToCopy);
+		m_writeOffset += bytesToCopy;
+		str.remove_prefix(bytesToCopy);
+	}
+}
+
+
+void RollingLogFile::Flush()
+{
+	if (IsOpen())
+	{
+		FlushViewOfFile(m_data, m_writeOffset);
+	}
+}
+
+
+bool RollingLogFile::NextSegment()
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	CloseSegment();
+	return OpenSegment();
+}
+
+
+bool RollingLogFile::OpenSegment()
+{
+	const string filename = (m_segmentIndex == 0)
+		? format("{}-{}{}", m_desc.baseName, m_timestamp, m_desc.extension)
+		: format("{}-{}-{}{}", m_desc.baseName, m_timestamp, m_segmentIndex, m_desc.extension);
+	const auto fullPath = m_desc.directory / filename;
+
+	m_fileHandle = CreateFileA(fullPath.string().c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_fileHandle == INVALID_HANDLE_VALUE)
+	{
+		cerr << "Failed to create log file " << fullPath.string() << endl;
+		return false;
+	}
+
+	// Creating the mapping grows the file to the full segment size
+	const uint64_t segmentSize = m_desc.segmentSize;
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READWRITE, (DWORD)(segmentSize >> 32), (DWORD)(segmentSize & 0xFFFFFFFF), nullptr);
+	if (m_mappingHandle != nullptr)
+	{
+		m_data = reinterpret_cast<std::byte*>(MapViewOfFile(m_mappingHandle, FILE_MAP_WRITE, 0, 0, m_desc.segmentSize));
+	}
+
+	if (m_data == nullptr)
+	{
+		cerr << "Failed to map log file " << fullPath.string() << endl;
+		CloseSegment();
+		return false;
+	}
+
+	m_writeOffset = 0;
+	++m_segmentIndex;
+
+	m_segments.push(fullPath);
+	RemoveOldSegments();
+	UpdateLink();
+
+	return true;
+}
+
+
+void RollingLogFile::CloseSegment()
+{
+	if (m_data != nullptr)
+	{
+		FlushViewOfFile(m_data, m_writeOffset);
+		UnmapViewOfFile(m_data);
+		m_data = nullptr;
+	}
+
+	if (m_mappingHandle != nullptr)
+	{
+		CloseHandle(m_mappingHandle);
+		m_mappingHandle = nullptr;
+	}
+
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		// Trim the unused tail of the segment
+		LARGE_INTEGER fileSize{};
+		fileSize.QuadPart = (LONGLONG)m_writeOffset;
+		SetFilePointerEx(m_fileHandle, fileSize, nullptr, FILE_BEGIN);
+		SetEndOfFile(m_fileHandle);
+
+		CloseHandle(m_fileHandle);
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+
+	m_writeOffset = 0;
+}
+
+
+void RollingLogFile::RemoveOldSegments()
+{
+	while (m_segments.size() > m_desc.maxSegments)
+	{
+		error_code ec;
+		filesystem::remove(m_segments.front(), ec);
+		m_segments.pop();
+	}
+}
+
+
+void RollingLogFile::UpdateLink()
+{
+	if (m_desc.linkName.empty())
+	{
+		return;
+	}
+
+	// Create a hard link to the non-timestamped file
+	auto linkPath = m_desc.directory / m_desc.linkName;
+	error_code ec;
+	filesystem::remove(linkPath, ec);
+	try
+	{
+		filesystem::create_hard_link(m_segments.back(), linkPath);
+	}
+	catch (filesystem::filesystem_error e)
+	{
+		cerr << e.what() << " " << e.path1().string() << " " << e.path2().string() << endl;
+	}
+}
@@ -0,0 +1,80 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+namespace Kodiak
+{
+
+struct RollingLogFileDesc
+{
+	std::filesystem::path directory;
+	std::string baseName{ "Log" };
+	std::string extension{ ".txt" };
+	std::string linkName{ "Log.txt" };
+	std::string timestamp;
+	size_t segmentSize{ 64 * 1024 * 1024 };
+	uint32_t maxSegments{ 8 };
+
+	RollingLogFileDesc& SetDirectory(const std::filesystem::path& value) { directory = value; return *this; }
+	RollingLogFileDesc& SetBaseName(const std::string& value) { baseName = value; return *this; }
+	RollingLogFileDesc& SetExtension(const std::string& value) { extension = value; return *this; }
+	RollingLogFileDesc& SetLinkName(const std::string& value) { linkName = value; return *this; }
+	RollingLogFileDesc& SetTimestamp(const std::string& value) { timestamp = value; return *this; }
+	constexpr RollingLogFileDesc& SetSegmentSize(size_t value) noexcept { segmentSize = value; return *this; }
+	constexpr RollingLogFileDesc& SetMaxSegments(uint32_t value) noexcept { maxSegments = value; return *this; }
+};
+
+
+// Log file sink that writes into a pre-sized, memory-mapped file segment.  When a segment fills up,
+// it is trimmed to its written length and a new segment is started.  At most maxSegments files are
+// kept on disk; the oldest are deleted as new segments are created.  The link name (Log.txt) is a
+// hard link to the segment currently being written.  Segment names carry the timestamp from the
+// desc, or the local time at Open if it's empty.
+class RollingLogFile : NonCopyable, NonMovable
+{
+public:
+	RollingLogFile() = default;
+	~RollingLogFile();
+
+	bool Open(const RollingLogFileDesc& desc);
+	void Close();
+
+	bool IsOpen() const noexcept { return m_data != nullptr; }
+	const std::string& GetTimestamp() const noexcept { return m_timestamp; }
+
+	void Write(std::string_view str);
+	void Flush();
+
+	// For callers that must not split a record across segments
+	size_t GetBytesAvailable() const noexcept { return IsOpen() ? m_desc.segmentSize - m_writeOffset : 0; }
+	size_t GetBytesWritten() const noexcept { return m_writeOffset; }
+	bool NextSegment();
+
+private:
+	bool OpenSegment();
+	void CloseSegment();
+	void RemoveOldSegments();
+	void UpdateLink();
+
+private:
+	RollingLogFileDesc m_desc{};
+	std::string m_timestamp;
+
+	HANDLE m_fileHandle{ INVALID_HANDLE_VALUE };
+	HANDLE m_mappingHandle{ nullptr };
+	std::byte* m_data{ nullptr };
+	size_t m_writeOffset{ 0 };
+
+	uint32_t m_segmentIndex{ 0 };
+	std::queue<std::filesystem::path> m_segments;
+};
+
+} // namespace Kodiak
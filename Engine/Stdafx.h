@@ -23,6 +23,17 @@
 #define FORCE_DEBUG_MARKERS 0
 #define ENABLE_DEBUG_MARKERS (_DEBUG || _PROFILE || FORCE_DEBUG_MARKERS)
 
+#define FORCE_FILE_WATCHING 0
+#define ENABLE_FILE_WATCHING (_DEBUG || FORCE_FILE_WATCHING)
+
+// Replaces global operator new/delete to count heap allocations, see Core\AllocationTracking.h
+#define FORCE_ALLOCATION_TRACKING 0
+#define ENABLE_ALLOCATION_TRACKING (FORCE_ALLOCATION_TRACKING)
+
+// Counts live IObjects by type and reports leaks at shutdown, see Core\IObjectRegistry.h
+#define FORCE_IOBJECT_REGISTRY 0
+#define ENABLE_IOBJECT_REGISTRY (FORCE_IOBJECT_REGISTRY)
+
 // Windows headers
 #include <windows.h>
 #include <wrl.h>
@@ -73,6 +84,7 @@
 #include <vector>
 
 // Engine headers
+#include "Core\AllocationTracking.h"
 #include "Core\BitmaskEnum.h"
 #include "Core\CoreEnums.h"
 #include "Core\DWParam.h"
@@ -80,6 +92,7 @@
 #include "Core\IObject.h"
 #include "Core\NonCopyable.h"
 #include "Core\NonMovable.h"
+#include "Core\StringId.h"
 #include "Core\Utility.h"
 #include "Core\VectorMath.h"
 #include "LogSystem.h"
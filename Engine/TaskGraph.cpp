@@ -0,0 +1,292 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "TaskGraph.h"
+
+
+using namespace Kodiak;
+using namespace std;
+
+
+struct TaskGraph::Task
+{
+	string name;
+	function<void()> func;
+	vector<TaskId> dependencies;
+	vector<TaskId> previousFrameDependencies;
+
+	// Built by Compile
+	vector<TaskId> successors;
+	vector<FrameEdge*> nextFrameEdges;
+	uint32_t numDependencies{ 0 };
+
+	// Dependencies left before the task can run, for odd and even frames
+	array<atomic<uint32_t>, 2> remaining{};
+	atomic<uint64_t> completedFrame{ 0 };
+
+	// Only used to wake threads waiting on the task
+	JobCounter counter;
+};
+
+
+// Dependency on a task in the previous frame.  Both the dependency finishing and the next frame's
+// Kick arrive at the edge, and whichever comes second releases the dependent task.
+struct TaskGraph::FrameEdge
+{
+	TaskId dependent{ 0 };
+
+	// Starts at one, as though the dependency had finished in frame 0
+	atomic<uint32_t> arrivals{ 1 };
+
+	// Returns true for the second arrival, and resets the edge for the next frame
+	bool Arrive() noexcept
+	{
+		if (arrivals.fetch_add(1, memory_order_acq_rel) == 1)
+		{
+			arrivals.store(0, memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+};
+
+
+TaskGraph::TaskGraph(JobSystem& jobSystem, bool advanceFrameArenas)
+	: m_jobSystem{ jobSystem }
+	, m_advanceFrameArenas{ advanceFrameArenas }
+{}
+
+
+TaskGraph::~TaskGraph()
+{
+	WaitForAll();
+
+	// Jobs touch their task's counter after the task reports itself complete
+	for (auto& task : m_tasks)
+	{
+		m_jobSystem.Wait(task->counter);
+	}
+}
+
+
+TaskId TaskGraph::AddTask(const string& name, function<void()> func, const vector<TaskId>& dependencies, const vector<TaskId>& previousFrameDependencies)
+{
+	assert_msg(!m_compiled, "Can't add tasks after the task graph is compiled");
+
+	const TaskId taskId = (TaskId)m_tasks.size();
+
+	auto task = make_unique<Task>();
+	task->name = name;
+	task->func = move(func);
+
+	for (TaskId dependency : dependencies)
+	{
+		assert_msg(dependency < taskId, "Task %s depends on a task that hasn't been added yet", name.c_str());
+		if (find(task->dependencies.begin(), task->dependencies.end(), dependency) == task->dependencies.end())
+		{
+			task->dependencies.push_back(dependency);
+		}
+	}
+
+	m_tasks.emplace_back(move(task));
+
+	for (TaskId dependency : previousFrameDependencies)
+	{
+		AddPreviousFrameDependency(taskId, dependency);
+	}
+
+	return taskId;
+}
+
+
+void TaskGraph::AddPreviousFrameDependency(TaskId task, TaskId dependency)
+{
+	assert_msg(!m_compiled, "Can't add dependencies after the task graph is compiled");
+	assert(task < m_tasks.size() && dependency < m_tasks.size());
+
+	// Every task already waits for its own previous run
+	if (task == dependency)
+	{
+		return;
+	}
+
+	auto& previousFrameDependencies = m_tasks[task]->previousFrameDependencies;
+	if (find(previousFrameDependencies.begin(), previousFrameDependencies.end(), dependency) == previousFrameDependencies.end())
+	{
+		previousFrameDependencies.push_back(dependency);
+	}
+}
+
+
+void TaskGraph::Compile()
+{
+	if (m_compiled)
+	{
+		return;
+	}
+
+	for (TaskId taskId = 0; taskId < m_tasks.size(); ++taskId)
+	{
+		Task& task = *m_tasks[taskId];
+
+		for (TaskId dependency : task.dependencies)
+		{
+			m_tasks[dependency]->successors.push_back(taskId);
+		}
+
+		auto addFrameEdge = [this, taskId](TaskId dependency)
+			{
+				auto edge = make_unique<FrameEdge>();
+				edge->dependent = taskId;
+				m_tasks[dependency]->nextFrameEdges.push_back(edge.get());
+				m_frameEdges.emplace_back(move(edge));
+			};
+
+		addFrameEdge(taskId);
+		for (TaskId dependency : task.previousFrameDependencies)
+		{
+			addFrameEdge(dependency);
+		}
+
+		task.numDependencies = (uint32_t)(task.dependencies.size() + task.previousFrameDependencies.size() + 1);
+	}
+
+	m_compiled = true;
+}
+
+
+void TaskGraph::Kick()
+{
+	Compile();
+
+	const uint64_t frame = ++m_frameNumber;
+	const uint32_t slot = (uint32_t)(frame & 1);
+
+	// The counters for this frame were last used two frames ago
+	if (frame > 2)
+	{
+		WaitForFrame(frame - 2);
+	}
+
+	// Nothing from two frames ago is running any more, so its frame arenas can be reused
+	if (m_advanceFrameArenas)
+	{
+		AdvanceFrameArenas(frame);
+	}
+
+	for (auto& task : m_tasks)
+	{
+		task->remaining[slot].store(task->numDependencies, memory_order_relaxed);
+	}
+
+	// Arrive at every edge before releasing anything, so no task from this frame can finish and
+	// arrive for the next frame while this frame's arrivals are still in progress
+	pmr::vector<TaskId> released{ GetFrameResource() };
+	released.reserve(m_frameEdges.size());
+	for (auto& edge : m_frameEdges)
+	{
+		if (edge->Arrive())
+		{
+			released.push_back(edge->dependent);
+		}
+	}
+
+	for (TaskId task : released)
+	{
+		Release(task, frame);
+	}
+}
+
+
+void TaskGraph::Wait(TaskId task)
+{
+	const uint64_t frame = m_frameNumber;
+	const auto& completedFrame = m_tasks[task]->completedFrame;
+
+	m_jobSystem.WaitUntil([&completedFrame, frame] { return completedFrame.load(memory_order_acquire) >= frame; });
+}
+
+
+void TaskGraph::WaitForAll()
+{
+	WaitForFrame(m_frameNumber);
+}
+
+
+const string& TaskGraph::GetTaskName(TaskId task) const
+{
+	return m_tasks[task]->name;
+}
+
+
+void TaskGraph::Release(TaskId task, uint64_t frame)
+{
+	if (m_tasks[task]->remaining[frame & 1].fetch_sub(1, memory_order_acq_rel) == 1)
+	{
+		Submit(task, frame);
+	}
+}
+
+
+void TaskGraph::Submit(TaskId task, uint64_t frame)
+{
+	m_jobSystem.Run([this, task, frame] { RunTask(task, frame); }, &m_tasks[task]->counter);
+}
+
+
+void TaskGraph::RunTask(TaskId taskId, uint64_t frame)
+{
+	Task& task = *m_tasks[taskId];
+
+	task.func();
+
+	for (TaskId successor : task.successors)
+	{
+		Release(successor, frame);
+	}
+
+	// Same as Kick, arrive everywhere first.  Our own next run is one of the dependents.
+	pmr::vector<TaskId> released{ GetFrameResource() };
+	released.reserve(task.nextFrameEdges.size());
+	for (FrameEdge* edge : task.nextFrameEdges)
+	{
+		if (edge->Arrive())
+		{
+			released.push_back(edge->dependent);
+		}
+	}
+
+	// Done with this frame's counters, Kick may reuse them as soon as this is visible
+	task.completedFrame.store(frame, memory_order_release);
+
+	for (TaskId dependent : released)
+	{
+		Release(dependent, frame + 1);
+	}
+}
+
+
+void TaskGraph::WaitForFrame(uint64_t frame)
+{
+	m_jobSystem.WaitUntil(
+		[this, frame]
+		{
+			for (const auto& task : m_tasks)
+			{
+				if (task->completedFrame.load(memory_order_acquire) < frame)
+				{
+					return false;
+				}
+			}
+			return true;
+		});
+}
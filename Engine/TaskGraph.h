@@ -0,0 +1,79 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core\FrameArena.h"
+#include "JobSystem.h"
+
+namespace Kodiak
+{
+
+using TaskId = uint32_t;
+
+constexpr TaskId s_invalidTask{ ~0u };
+
+
+// A fixed graph of per-frame tasks, built once and kicked every frame on the JobSystem.
+// A task runs once everything it depends on has finished in the same frame, and once its
+// previous-frame dependencies have finished in the frame before.  Every task implicitly
+// depends on its own previous run, so a task never overlaps itself.  Frames overlap only
+// through previous-frame dependencies, and never more than two are in flight.
+class TaskGraph : NonCopyable, NonMovable
+{
+public:
+	// The application's frame graph also drives the frame arenas, see AdvanceFrameArenas
+	explicit TaskGraph(JobSystem& jobSystem, bool advanceFrameArenas = false);
+	~TaskGraph();
+
+	// Dependencies have to be added first, so the graph can't have a cycle
+	TaskId AddTask(const std::string& name, std::function<void()> func,
+		const std::vector<TaskId>& dependencies = {},
+		const std::vector<TaskId>& previousFrameDependencies = {});
+
+	// For previous-frame dependencies on tasks added later
+	void AddPreviousFrameDependency(TaskId task, TaskId dependency);
+
+	// Freezes the graph.  Called by the first Kick if needed.
+	void Compile();
+
+	// Starts the next frame, first waiting for the frame before the previous one to finish
+	void Kick();
+
+	// Wait for a task in the most recently kicked frame, running other jobs meanwhile
+	void Wait(TaskId task);
+	void WaitForAll();
+
+	uint64_t GetFrameNumber() const noexcept { return m_frameNumber; }
+	uint32_t GetNumTasks() const noexcept { return (uint32_t)m_tasks.size(); }
+	const std::string& GetTaskName(TaskId task) const;
+
+private:
+	struct Task;
+	struct FrameEdge;
+
+	void Release(TaskId task, uint64_t frame);
+	void Submit(TaskId task, uint64_t frame);
+	void RunTask(TaskId task, uint64_t frame);
+	void WaitForFrame(uint64_t frame);
+
+private:
+	JobSystem& m_jobSystem;
+
+	std::vector<std::unique_ptr<Task>> m_tasks;
+	std::vector<std::unique_ptr<FrameEdge>> m_frameEdges;
+	bool m_compiled{ false };
+	const bool m_advanceFrameArenas{ false };
+
+	// Frames are numbered from 1, so 0 means no frame has run yet
+	uint64_t m_frameNumber{ 0 };
+};
+
+} // namespace Kodiak
@@ -0,0 +1,177 @@
+'''
+This code is licensed under the MIT License (MIT).
+THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+Author:  David Elder
+'''
+
+import argparse
+import json
+import re
+import struct
+import sys
+from datetime import datetime, timezone
+
+# Must match Engine/BinaryLogFile.h
+MAGIC = b'KLOG'
+VERSION = 2
+
+RECORD_CATEGORY = 1
+RECORD_MESSAGE = 2
+RECORD_FORMAT = 3
+
+ARG_STRING = 1
+ARG_INT = 2
+ARG_UINT = 3
+ARG_DOUBLE = 4
+ARG_BOOL = 5
+
+ARG_FORMATS = {ARG_INT: 'q', ARG_UINT: 'Q', ARG_DOUBLE: 'd', ARG_BOOL: 'B'}
+
+# Must match Kodiak::Severity
+SEVERITIES = ['Fatal', 'Error', 'Warning', 'Notice', 'Info', 'Debug', 'Log']
+
+
+class LogReader:
+    '''Reads records from a binary .klog file'''
+
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+        self.categories = {0: ''}
+        self.formats = {0: '{}'}
+
+    def read(self, fmt):
+        values = struct.unpack_from('<' + fmt, self.data, self.offset)
+        self.offset += struct.calcsize('<' + fmt)
+        return values
+
+    def read_bytes(self, size):
+        value = self.data[self.offset:self.offset + size]
+        self.offset += size
+        return value
+
+    def read_header(self):
+        if self.read_bytes(4) != MAGIC:
+            raise ValueError('Not a Kodiak binary log file')
+        version, _, ticks_per_second = self.read('HHQ')
+        if version != VERSION:
+            raise ValueError('Unsupported binary log version {0}'.format(version))
+        self.ticks_per_second = ticks_per_second
+
+    def read_args(self, arg_count):
+        args = []
+        for _ in range(arg_count):
+            (arg_type,) = self.read('B')
+            if arg_type == ARG_STRING:
+                (length,) = self.read('I')
+                args.append(self.read_bytes(length).decode('utf-8', errors='replace'))
+            elif arg_type == ARG_BOOL:
+                (value,) = self.read('B')
+                args.append(value != 0)
+            elif arg_type in ARG_FORMATS:
+                (value,) = self.read(ARG_FORMATS[arg_type])
+                args.append(value)
+            else:
+                raise ValueError('Unknown arg type {0} at offset {1}'.format(arg_type, self.offset))
+        return args
+
+    def messages(self):
+        '''Yields one dict per message record, in file order'''
+        self.read_header()
+        while self.offset < len(self.data):
+            try:
+                (record_type,) = self.read('B')
+                if record_type == 0:
+                    # Zero padding at the end of a segment that wasn't closed
+                    return
+                elif record_type == RECORD_CATEGORY:
+                    category_id, length = self.read('IH')
+                    self.categories[category_id] = self.read_bytes(length).decode('utf-8', errors='replace')
+                elif record_type == RECORD_FORMAT:
+                    format_id, length = self.read('IH')
+                    self.formats[format_id] = self.read_bytes(length).decode('utf-8', errors='replace')
+                elif record_type == RECORD_MESSAGE:
+                    ticks, thread_id, category_id, severity, format_id, arg_count = self.read('QIIBIB')
+                    args = self.read_args(arg_count)
+                    yield {
+                        'time': datetime.fromtimestamp(ticks / self.ticks_per_second, tz=timezone.utc),
+                        'ticks': ticks,
+                        'thread': thread_id,
+                        'category': self.categories.get(category_id, '<{0}>'.format(category_id)),
+                        'severity': SEVERITIES[severity] if severity < len(SEVERITIES) else str(severity),
+                        'formatId': format_id,
+                        'format': self.formats.get(format_id, ''),
+                        'args': args,
+                        'message': ''.join(args) if format_id == 0 else format_message(self.formats.get(format_id), args)
+                    }
+                else:
+                    raise ValueError('Unknown record type {0} at offset {1}'.format(record_type, self.offset - 1))
+            except struct.error:
+                # Truncated tail, e.g. the application was terminated mid-write
+                return
+
+
+def format_message(fmt, args):
+    '''Applies a std::format string.  The spec syntax used in the engine is the same in Python,
+    except that bools print as true/false.'''
+    values = [('true' if arg else 'false') if isinstance(arg, bool) else arg for arg in args]
+    if fmt is not None:
+        try:
+            return fmt.format(*values) + '\n'
+        except (ValueError, IndexError, KeyError):
+            pass
+    return '{0} {1}\n'.format(fmt, values)
+
+
+def segment_key(path):
+    '''Log-<timestamp>.klog comes before Log-<timestamp>-1.klog'''
+    match = re.match(r'(.*?-\d{14})(?:-(\d+))?\.klog$', path)
+    return (match.group(1), int(match.group(2) or 0)) if match else (path, 0)
+
+
+def format_text(message):
+    '''Matches the prefix written by LogSystem::OutputLogMessage'''
+    local_time = message['time'].astimezone()
+    text = '[{0}.{1:06.3f}] '.format(local_time.strftime('%Y.%m.%d-%H.%M'), local_time.second + local_time.microsecond / 1e6)
+    if message['category']:
+        text += '{0}: '.format(message['category'])
+    if message['severity'] != 'Log':
+        text += '{0}: '.format(message['severity'])
+    return text + message['message']
+
+
+def read_segments(paths):
+    '''Each segment starts with its own header and definitions'''
+    for path in paths:
+        with open(path, 'rb') as infile:
+            reader = LogReader(infile.read())
+        yield from reader.messages()
+
+
+def decode_log():
+    parser = argparse.ArgumentParser(description='Decodes a Kodiak binary log (.klog) to text or JSON')
+    parser.add_argument('input', nargs='+', help='Binary log file segments, decoded in segment order')
+    parser.add_argument('-o', '--output', help='Output file (default: stdout)')
+    parser.add_argument('--json', action='store_true', help='Write JSON lines instead of text')
+    args = parser.parse_args()
+
+    outfile = open(args.output, 'w', encoding='utf-8') if args.output else sys.stdout
+    try:
+        for message in read_segments(sorted(args.input, key=segment_key)):
+            if args.json:
+                message['time'] = message['time'].isoformat()
+                message['message'] = message['message'].rstrip('\n')
+                outfile.write(json.dumps(message) + '\n')
+            else:
+                outfile.write(format_text(message))
+    finally:
+        if outfile is not sys.stdout:
+            outfile.close()
+
+
+if __name__ == "__main__":
+    decode_log()
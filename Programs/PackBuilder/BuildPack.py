@@ -0,0 +1,212 @@
+'''
+This code is licensed under the MIT License (MIT).
+THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+
+Author:  David Elder
+'''
+
+import argparse
+import os
+import posixpath
+import struct
+import sys
+
+# Must match Engine/PackFile.h
+MAGIC = b'KPAK'
+VERSION = 2
+ALIGNMENT = 4096
+BLOCK_SIZE = 64 * 1024
+
+FLAG_COMPRESSED = 1
+
+HASH_KIND_CRC32C = 1
+
+HEADER_FORMAT = '<4sHHIIQQQ'
+ENTRY_FORMAT = '<QQQQIHH'
+
+# Must match Utility::g_hashStart
+HASH_START = 2166136261
+
+
+def make_crc32c_table():
+    table = []
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x82F63B78 if crc & 1 else crc >> 1
+        table.append(crc)
+    return table
+
+
+CRC32C_TABLE = make_crc32c_table()
+
+
+def hash_name(name):
+    '''Matches Utility::HashRange with hardware CRC32: CRC32C over the zero-padded name, no inversion'''
+    data = name.encode('utf-8')
+    data += b'\0' * (-len(data) % 4)
+    crc = HASH_START
+    for byte in data:
+        crc = CRC32C_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8)
+    return crc
+
+
+# Must match Engine/Core/Compression.cpp
+MIN_MATCH = 4
+MAX_OFFSET = 65535
+LAST_LITERALS = 5
+MATCH_SEARCH_LIMIT = 12
+
+
+def write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def write_sequence(out, literals, offset, match_length):
+    literal_length = len(literals)
+    token = min(literal_length, 15) << 4
+    if match_length:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if literal_length >= 15:
+        write_length(out, literal_length - 15)
+    out += literals
+    if match_length:
+        out += struct.pack('<H', offset)
+        if match_length - MIN_MATCH >= 15:
+            write_length(out, match_length - MIN_MATCH - 15)
+
+
+def compress_block(data):
+    '''LZ4 block format, decoded by Utility::DecompressBlock'''
+    out = bytearray()
+    anchor = 0
+    size = len(data)
+
+    if size > MATCH_SEARCH_LIMIT:
+        hash_table = {}
+        match_limit = size - MATCH_SEARCH_LIMIT
+        extend_limit = size - LAST_LITERALS
+        pos = 0
+        while pos < match_limit:
+            sequence = data[pos:pos + 4]
+            candidate = hash_table.get(sequence)
+            hash_table[sequence] = pos
+            if candidate is None or pos - candidate > MAX_OFFSET:
+                pos += 1
+                continue
+
+            match_length = MIN_MATCH
+            while pos + match_length < extend_limit and data[candidate + match_length] == data[pos + match_length]:
+                match_length += 1
+
+            write_sequence(out, data[anchor:pos], pos - candidate, match_length)
+            pos += match_length
+            anchor = pos
+
+    write_sequence(out, data[anchor:], 0, 0)
+    return bytes(out)
+
+
+def compress_entry(data):
+    '''Returns the compressed payload (block offset table and blocks), or None if it doesn't save space'''
+    blocks = []
+    for start in range(0, len(data), BLOCK_SIZE):
+        block = data[start:start + BLOCK_SIZE]
+        compressed = compress_block(block)
+        # A block stored at its full size is read back as uncompressed
+        blocks.append(compressed if len(compressed) < len(block) else block)
+
+    offsets = [(len(blocks) + 1) * 8]
+    for block in blocks:
+        offsets.append(offsets[-1] + len(block))
+
+    payload = struct.pack('<{0}Q'.format(len(offsets)), *offsets) + b''.join(blocks)
+    return payload if len(payload) < len(data) else None
+
+
+def normalize_path(path):
+    '''Matches FileSystem::NormalizePath'''
+    normalized = posixpath.normpath(path.replace('\\', '/').lower()).lstrip('/')
+    return '' if normalized == '.' else normalized
+
+
+def align_up(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+
+def gather_files(source_dir):
+    files = []
+    for root, _, filenames in os.walk(source_dir):
+        for filename in filenames:
+            full_path = os.path.join(root, filename)
+            name = normalize_path(os.path.relpath(full_path, source_dir))
+            files.append((hash_name(name), name.encode('utf-8'), full_path))
+    files.sort(key=lambda f: (f[0], f[1]))
+    return files
+
+
+def build_pack(source_dir, output_path, compress):
+    files = gather_files(source_dir)
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+
+    toc_offset = header_size
+    names_offset = toc_offset + len(files) * entry_size
+    names = b''.join(f[1] for f in files)
+
+    data_offset = align_up(names_offset + len(names), ALIGNMENT)
+
+    with open(output_path, 'wb') as out:
+        out.seek(data_offset)
+
+        entries = []
+        name_offset = 0
+        for file_hash, name, full_path in files:
+            with open(full_path, 'rb') as f:
+                data = f.read()
+
+            payload = compress_entry(data) if compress else None
+            flags = FLAG_COMPRESSED if payload is not None else 0
+            if payload is None:
+                payload = data
+
+            offset = out.tell()
+            out.write(payload)
+            out.write(b'\0' * (align_up(out.tell(), ALIGNMENT) - out.tell()))
+
+            entries.append(struct.pack(ENTRY_FORMAT, file_hash, offset, len(data), len(payload), name_offset, len(name), flags))
+            name_offset += len(name)
+
+        out.seek(0)
+        out.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, HASH_KIND_CRC32C, len(files), 0, toc_offset, names_offset, len(names)))
+        out.write(b''.join(entries))
+        out.write(names)
+
+    print('Packed {0} files into {1}'.format(len(files), output_path))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Builds a Kodiak pack file (.kpak) from a directory')
+    parser.add_argument('source', help='Directory to pack, names in the pack are relative to it')
+    parser.add_argument('output', help='Pack file to write')
+    parser.add_argument('--compress', action='store_true', help='Compress entries in 64KB blocks where it saves space')
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.source):
+        print('{0} is not a directory'.format(args.source))
+        return 1
+
+    build_pack(args.source, args.output, args.compress)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())